@@ -0,0 +1,124 @@
+#include "crc32c.h"
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define CRC32C_X86
+#elif defined(__aarch64__)
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#define CRC32C_ARM64
+#endif
+
+typedef quint32 (*Crc32cFunction)(quint32 crc, const uchar *p, int size);
+
+// Reflected polynomial 0x1EDC6F41
+static const quint32 POLY = 0x82F63B78;
+
+struct Crc32cTable
+{
+    quint32 entries[256];
+
+    Crc32cTable()
+    {
+        for (quint32 i=0; i<256; i++)
+        {
+            quint32 crc = i;
+            for (int bit=0; bit<8; bit++) crc = (crc >> 1) ^ (POLY & (0 - (crc & 1)));
+            entries[i] = crc;
+        }
+    }
+};
+
+static quint32 crc32cTable(quint32 crc, const uchar *p, int size)
+{
+    static const Crc32cTable table;
+    for (int i=0; i<size; i++) crc = table.entries[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+#ifdef CRC32C_X86
+__attribute__((target("sse4.2")))
+static quint32 crc32cSse42(quint32 crc, const uchar *p, int size)
+{
+#ifdef __x86_64__
+    quint64 crc64 = crc;
+    for (; size >= 8; p += 8, size -= 8)
+    {
+        quint64 word;
+        memcpy(&word, p, 8);
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+    crc = quint32(crc64);
+#endif
+    for (; size >= 4; p += 4, size -= 4)
+    {
+        quint32 word;
+        memcpy(&word, p, 4);
+        crc = _mm_crc32_u32(crc, word);
+    }
+    for (; size > 0; p++, size--) crc = _mm_crc32_u8(crc, *p);
+    return crc;
+}
+#endif
+
+#ifdef CRC32C_ARM64
+__attribute__((target("+crc")))
+static quint32 crc32cArmv8(quint32 crc, const uchar *p, int size)
+{
+    for (; size >= 8; p += 8, size -= 8)
+    {
+        quint64 word;
+        memcpy(&word, p, 8);
+        crc = __crc32cd(crc, word);
+    }
+    for (; size > 0; p++, size--) crc = __crc32cb(crc, *p);
+    return crc;
+}
+#endif
+
+struct Crc32cDispatch
+{
+    Crc32cFunction function;
+    const char *name;
+
+    Crc32cDispatch() : function(crc32cTable), name("table")
+    {
+#if defined(CRC32C_X86)
+        if (__builtin_cpu_supports("sse4.2"))
+        {
+            function = crc32cSse42;
+            name = "sse4.2";
+        }
+#elif defined(CRC32C_ARM64)
+        if (getauxval(AT_HWCAP) & HWCAP_CRC32)
+        {
+            function = crc32cArmv8;
+            name = "armv8";
+        }
+#endif
+    }
+};
+
+// Chosen on first use, thread safe static initialization
+static const Crc32cDispatch &dispatch()
+{
+    static const Crc32cDispatch instance;
+    return instance;
+}
+
+quint32 crc32c(quint32 crc, const void *data, int size)
+{
+    return ~dispatch().function(~crc, static_cast<const uchar *>(data), size);
+}
+
+quint32 crc32cPortable(quint32 crc, const void *data, int size)
+{
+    return ~crc32cTable(~crc, static_cast<const uchar *>(data), size);
+}
+
+const char *crc32cImplementation()
+{
+    return dispatch().name;
+}
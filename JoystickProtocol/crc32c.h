@@ -0,0 +1,19 @@
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include <QtGlobal>
+
+// CRC32C (Castagnoli), the CRC of iSCSI and ext4, which the ARMv8 CRC32 and
+// the SSE4.2 instructions compute in hardware. The implementation is picked
+// once at runtime: the instructions when the CPU has them, otherwise a table.
+
+// crc is the value returned for the preceding data, 0 to start
+quint32 crc32c(quint32 crc, const void *data, int size);
+
+// The table implementation whatever the CPU has, to check the others against
+quint32 crc32cPortable(quint32 crc, const void *data, int size);
+
+// "armv8", "sse4.2" or "table", for the log
+const char *crc32cImplementation();
+
+#endif // CRC32C_H
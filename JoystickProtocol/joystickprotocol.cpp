@@ -0,0 +1,467 @@
+#include "joystickprotocol.h"
+#include "crc32c.h"
+#include <QDataStream>
+#include <string.h>
+
+static const qint32 SEQ_RESTART = 1024;
+
+static bool canStartMessage(char c)
+{
+    return uchar(c) == 0x00 || uchar(c) == 0xFF || uchar(c) == FRAME_MAGIC;
+}
+
+void appendFrame(QByteArray &out, FrameType type, quint32 seq, const char *payload, int size)
+{
+    int start = out.size();
+    out.resize(start + FRAME_HEADER_SIZE + size + FRAME_CHECK_SIZE);
+    char *p = out.data() + start;
+
+    p[0] = char(FRAME_MAGIC);
+    p[1] = char(type);
+    putU16(p + 2, quint16(size));
+    putU32(p + 4, seq);
+    if (size > 0) memcpy(p + FRAME_HEADER_SIZE, payload, size_t(size));
+    putU32(p + FRAME_HEADER_SIZE + size, crc32c(0, p, FRAME_HEADER_SIZE + size));
+}
+
+void appendChannelsFrame(QByteArray &out, quint32 seq, const int *values, int count, quint64 stampUs)
+{
+    count = qBound(0, count, FRAME_MAX_CHANNELS);
+    char payload[1 + 2 * FRAME_MAX_CHANNELS + 8];
+    payload[0] = char(count);
+    for (int i=0; i<count; i++)
+        putU16(payload + 1 + 2 * i, quint16(qBound(0, values[i], 0xFFFF)));
+
+    int size = 1 + 2 * count;
+    if (stampUs)
+    {
+        putU64(payload + size, stampUs);
+        size += 8;
+    }
+    appendFrame(out, FrameChannels, seq, payload, size);
+}
+
+bool decodeChannels(const char *payload, int size, int *values, int &count, quint64 *stampUs)
+{
+    if (size < 1) return false;
+
+    count = uchar(payload[0]);
+    int base = 1 + 2 * count;
+    if (count < 1 || count > FRAME_MAX_CHANNELS || (size != base && size != base + 8))
+        return false;
+
+    for (int i=0; i<count; i++)
+        values[i] = getU16(payload + 1 + 2 * i);
+    if (stampUs) *stampUs = size > base ? getU64(payload + base) : 0;
+    return true;
+}
+
+void appendDeltaFrame(QByteArray &out, quint32 seq, const int *values, quint16 mask, quint64 stampUs)
+{
+    char payload[2 + 2 * FRAME_MAX_CHANNELS + 8];
+    putU16(payload, mask);
+    int size = 2;
+    for (int i=0; i<FRAME_MAX_CHANNELS; i++)
+    {
+        if (!(mask & (1 << i))) continue;
+        putU16(payload + size, quint16(qBound(0, values[i], 0xFFFF)));
+        size += 2;
+    }
+    if (stampUs)
+    {
+        putU64(payload + size, stampUs);
+        size += 8;
+    }
+
+    appendFrame(out, FrameDelta, seq, payload, size);
+}
+
+void appendHelloFrame(QByteArray &out, ControlRole role, int priority, const QString &name)
+{
+    QByteArray utf8 = name.toUtf8().left(HELLO_MAX_NAME);
+    char payload[2 + HELLO_MAX_NAME];
+    payload[0] = char(role);
+    payload[1] = char(qBound(0, priority, 255));
+    memcpy(payload + 2, utf8.constData(), size_t(utf8.size()));
+
+    appendFrame(out, FrameHello, 0, payload, 2 + utf8.size());
+}
+
+bool decodeHello(const char *payload, int size, ControlRole &role, int &priority, QString &name)
+{
+    if (size < 2 || size > 2 + HELLO_MAX_NAME) return false;
+    if (uchar(payload[0]) > RoleController) return false;
+
+    role = ControlRole(uchar(payload[0]));
+    priority = uchar(payload[1]);
+    name = QString::fromUtf8(payload + 2, size - 2);
+    return true;
+}
+
+void appendControlFrame(QByteArray &out, bool owner, int priority, quint16 ownerId)
+{
+    char payload[4];
+    payload[0] = char(owner ? 1 : 0);
+    payload[1] = char(qBound(0, priority, 255));
+    putU16(payload + 2, ownerId);
+
+    appendFrame(out, FrameControl, 0, payload, sizeof(payload));
+}
+
+bool decodeControl(const char *payload, int size, bool &owner, int &priority, quint16 &ownerId)
+{
+    if (size != 4) return false;
+
+    owner = payload[0] != 0;
+    priority = uchar(payload[1]);
+    ownerId = getU16(payload + 2);
+    return true;
+}
+
+void appendPingFrame(QByteArray &out, quint64 serverUs)
+{
+    char payload[8];
+    putU64(payload, serverUs);
+    appendFrame(out, FramePing, 0, payload, sizeof(payload));
+}
+
+bool decodePing(const char *payload, int size, quint64 &serverUs)
+{
+    if (size != 8) return false;
+    serverUs = getU64(payload);
+    return true;
+}
+
+void appendPongFrame(QByteArray &out, quint64 serverUs, quint64 receivedUs, quint64 sentUs)
+{
+    char payload[24];
+    putU64(payload, serverUs);
+    putU64(payload + 8, receivedUs);
+    putU64(payload + 16, sentUs);
+    appendFrame(out, FramePong, 0, payload, sizeof(payload));
+}
+
+bool decodePong(const char *payload, int size, quint64 &serverUs, quint64 &receivedUs, quint64 &sentUs)
+{
+    if (size != 24) return false;
+    serverUs = getU64(payload);
+    receivedUs = getU64(payload + 8);
+    sentUs = getU64(payload + 16);
+    return true;
+}
+
+void appendSubscribeFrame(QByteArray &out, int rateHz)
+{
+    char payload[2];
+    putU16(payload, quint16(qBound(0, rateHz, 0xFFFF)));
+    appendFrame(out, FrameSubscribe, 0, payload, sizeof(payload));
+}
+
+bool decodeSubscribe(const char *payload, int size, int &rateHz)
+{
+    if (size != 2) return false;
+    rateHz = getU16(payload);
+    return true;
+}
+
+void appendFeedbackFrame(QByteArray &out, const Feedback &feedback)
+{
+    char payload[24];
+    putU32(payload, feedback.received);
+    putU32(payload + 4, feedback.lost);
+    putU32(payload + 8, feedback.late);
+    putU32(payload + 12, feedback.coalesced);
+    putU32(payload + 16, feedback.ageUs);
+    putU32(payload + 20, feedback.queuedBytes);
+    appendFrame(out, FrameFeedback, 0, payload, sizeof(payload));
+}
+
+bool decodeFeedback(const char *payload, int size, Feedback &feedback)
+{
+    if (size != 24) return false;
+    feedback.received = getU32(payload);
+    feedback.lost = getU32(payload + 4);
+    feedback.late = getU32(payload + 8);
+    feedback.coalesced = getU32(payload + 12);
+    feedback.ageUs = getU32(payload + 16);
+    feedback.queuedBytes = getU32(payload + 20);
+    return true;
+}
+
+void appendPathFrame(QByteArray &out, quint32 session, int path)
+{
+    char payload[5];
+    putU32(payload, session);
+    payload[4] = char(path);
+    appendFrame(out, FramePath, 0, payload, sizeof(payload));
+}
+
+bool decodePath(const char *payload, int size, quint32 &session, int &path)
+{
+    if (size != 5) return false;
+    session = getU32(payload);
+    path = uchar(payload[4]);
+    return path < FRAME_PATHS;
+}
+
+void appendResumeFrame(QByteArray &out, quint32 token)
+{
+    char payload[4];
+    putU32(payload, token);
+    appendFrame(out, FrameResume, 0, payload, sizeof(payload));
+}
+
+bool decodeResume(const char *payload, int size, quint32 &token)
+{
+    if (size != 4) return false;
+    token = getU32(payload);
+    return true;
+}
+
+int encodeTelemetry(const Telemetry &t, char *payload)
+{
+    int count = qBound(0, t.count, FRAME_MAX_CHANNELS);
+    int inputs = qBound(0, t.inputCount, TELEMETRY_MAX_INPUTS);
+
+    char *p = payload;
+    *p++ = char(t.failsafe ? 1 : 0);
+    *p++ = char(qBound(-1, t.source, 127));
+    *p++ = char(count);
+    for (int i=0; i<count; i++, p += 2)
+        putU16(p, quint16(qBound(0, t.channels[i], 0xFFFF)));
+
+    *p++ = char(inputs);
+    for (int i=0; i<inputs; i++)
+    {
+        const TelemetryInput &in = t.inputs[i];
+        *p++ = char(in.type);
+        *p++ = char(in.flags);
+        putU32(p, in.goodFrames);   p += 4;
+        putU32(p, in.badFrames);    p += 4;
+        putU32(p, in.lostFrames);   p += 4;
+        putU32(p, in.failsafes);    p += 4;
+        putU32(p, in.resyncs);      p += 4;
+        if (!(in.flags & TelemetryInput::HasLink)) continue;
+
+        *p++ = char(in.uplinkRssi1);
+        *p++ = char(in.uplinkRssi2);
+        *p++ = char(in.uplinkQuality);
+        *p++ = char(in.uplinkSnr);
+        *p++ = char(in.activeAntenna);
+        *p++ = char(in.rfMode);
+        *p++ = char(in.uplinkTxPower);
+        *p++ = char(in.downlinkRssi);
+        *p++ = char(in.downlinkQuality);
+        *p++ = char(in.downlinkSnr);
+    }
+
+    return int(p - payload);
+}
+
+bool decodeTelemetry(const char *payload, int size, Telemetry &t)
+{
+    const char *p = payload;
+    const char *end = payload + size;
+    if (end - p < 3) return false;
+
+    t.failsafe = (*p++ & 1) != 0;
+    t.source = qint8(*p++);
+    t.count = uchar(*p++);
+    if (t.count > FRAME_MAX_CHANNELS || end - p < 2 * t.count + 1) return false;
+    for (int i=0; i<t.count; i++, p += 2)
+        t.channels[i] = getU16(p);
+
+    t.inputCount = uchar(*p++);
+    if (t.inputCount > TELEMETRY_MAX_INPUTS) return false;
+    for (int i=0; i<t.inputCount; i++)
+    {
+        TelemetryInput &in = t.inputs[i];
+        in = TelemetryInput();
+        if (end - p < 22) return false;
+        in.type = quint8(*p++);
+        in.flags = quint8(*p++);
+        in.goodFrames = getU32(p);  p += 4;
+        in.badFrames = getU32(p);   p += 4;
+        in.lostFrames = getU32(p);  p += 4;
+        in.failsafes = getU32(p);   p += 4;
+        in.resyncs = getU32(p);     p += 4;
+
+        if (!(in.flags & TelemetryInput::HasLink)) continue;
+        if (end - p < 10) return false;
+        in.uplinkRssi1 = quint8(*p++);
+        in.uplinkRssi2 = quint8(*p++);
+        in.uplinkQuality = quint8(*p++);
+        in.uplinkSnr = qint8(*p++);
+        in.activeAntenna = quint8(*p++);
+        in.rfMode = quint8(*p++);
+        in.uplinkTxPower = quint8(*p++);
+        in.downlinkRssi = quint8(*p++);
+        in.downlinkQuality = quint8(*p++);
+        in.downlinkSnr = qint8(*p++);
+    }
+
+    return p == end;
+}
+
+ChannelState::ChannelState()
+{
+    reset();
+}
+
+void ChannelState::reset()
+{
+    memset(m_values, 0, sizeof(m_values));
+    m_count = 0;
+    m_hasSeq = false;
+    m_lastSeq = 0;
+    m_lost = 0;
+    m_lastGap = 0;
+    m_stampUs = 0;
+}
+
+ChannelState::Result ChannelState::apply(const FrameHeader &header, const char *payload)
+{
+    // Serial number arithmetic, the sequence wraps. A full frame far behind
+    // is a restarted sender and starts over.
+    qint32 step = qint32(header.seq - m_lastSeq);
+    if (m_hasSeq && step <= 0 && (header.type != FrameChannels || step > -SEQ_RESTART))
+        return Stale;
+
+    if (header.type == FrameChannels)
+    {
+        int values[FRAME_MAX_CHANNELS];
+        int count = 0;
+        quint64 stampUs = 0;
+        if (!decodeChannels(payload, header.length, values, count, &stampUs))
+            return Invalid;
+
+        memcpy(m_values, values, sizeof(int) * size_t(count));
+        m_count = count;
+        m_stampUs = stampUs;
+    }
+    else if (header.type == FrameDelta)
+    {
+        if (header.length < 2) return Invalid;
+        if (m_count == 0) return NoBase;
+
+        quint16 mask = getU16(payload);
+        int bits = 0;
+        for (quint16 m = mask; m; m &= m - 1) bits++;
+        int base = 2 + 2 * bits;
+        if ((header.length != base && header.length != base + 8) || (m_count < FRAME_MAX_CHANNELS && mask >> m_count))
+            return Invalid;
+        m_stampUs = header.length > base ? getU64(payload + base) : 0;
+
+        const char *p = payload + 2;
+        for (int i=0; i<m_count; i++)
+        {
+            if (!(mask & (1 << i))) continue;
+            m_values[i] = getU16(p);
+            p += 2;
+        }
+    }
+    else
+    {
+        return Invalid;
+    }
+
+    m_lastGap = m_hasSeq && step > 1 ? quint32(step - 1) : 0;
+    m_lost += m_lastGap;
+    m_lastSeq = header.seq;
+    m_hasSeq = true;
+    return Applied;
+}
+
+FrameReader::FrameReader() : m_pos(0), m_payload(nullptr)
+{
+    m_header.type = 0;
+    m_header.length = 0;
+    m_header.seq = 0;
+}
+
+void FrameReader::append(const char *data, int size)
+{
+    // Drop what was consumed before growing the buffer
+    if (m_pos > 0)
+    {
+        m_buf.remove(0, m_pos);
+        m_pos = 0;
+    }
+    m_buf.append(data, size);
+    m_payload = nullptr;
+}
+
+void FrameReader::clear()
+{
+    m_buf.clear();
+    m_pos = 0;
+    m_payload = nullptr;
+}
+
+FrameReader::Result FrameReader::invalid(int skip, const QString &error)
+{
+    // Skip to the next byte that can start a message
+    m_pos += skip;
+    while (m_pos < m_buf.size() && !canStartMessage(m_buf.at(m_pos))) m_pos++;
+    m_error = error;
+    return Invalid;
+}
+
+FrameReader::Result FrameReader::next()
+{
+    int avail = m_buf.size() - m_pos;
+    if (avail <= 0) return NeedMore;
+
+    const char *p = m_buf.constData() + m_pos;
+    uchar first = uchar(p[0]);
+
+    if (first == FRAME_MAGIC)
+    {
+        if (avail < FRAME_HEADER_SIZE) return NeedMore;
+
+        int length = getU16(p + 2);
+        if (length > FRAME_MAX_PAYLOAD)
+            return invalid(1, QString("Frame too long (%1 bytes)").arg(length));
+
+        int total = FRAME_HEADER_SIZE + length + FRAME_CHECK_SIZE;
+        if (avail < total) return NeedMore;
+
+        // Header and payload in one pass, before anything is decoded
+        if (crc32c(0, p, FRAME_HEADER_SIZE + length) != getU32(p + FRAME_HEADER_SIZE + length))
+            return invalid(1, QString("Frame CRC failed (type %1, seq %2)").arg(uchar(p[1])).arg(getU32(p + 4)));
+
+        m_header.type = quint8(p[1]);
+        m_header.length = quint16(length);
+        m_header.seq = getU32(p + 4);
+        m_payload = p + FRAME_HEADER_SIZE;
+        m_pos += total;
+        return Frame;
+    }
+
+    if (first == 0x00 || first == 0xFF)
+    {
+        if (avail < 4) return NeedMore;
+
+        quint32 bytes = quint32(uchar(p[0])) << 24 | quint32(uchar(p[1])) << 16 |
+                        quint32(uchar(p[2])) << 8 | quint32(uchar(p[3]));
+        if (bytes == 0xFFFFFFFF)
+        {
+            m_text.clear();
+            m_pos += 4;
+            return Text;
+        }
+        if (bytes > quint32(TEXT_MAX_BYTES) || (bytes & 1))
+            return invalid(1, QString("Invalid text length %1").arg(bytes));
+
+        int total = 4 + int(bytes);
+        if (avail < total) return NeedMore;
+
+        QDataStream in(QByteArray::fromRawData(p, total));
+        in.setVersion(QDataStream::Qt_5_11);
+        in >> m_text;
+        m_pos += total;
+        return Text;
+    }
+
+    return invalid(1, "Garbage in the stream skipped");
+}
@@ -0,0 +1,254 @@
+#ifndef JOYSTICKPROTOCOL_H
+#define JOYSTICKPROTOCOL_H
+
+#include <QByteArray>
+#include <QString>
+
+// Binary frames between QTCPClient and QTCPServer.
+// They share the TCP stream with the QDataStream text messages: a serialized
+// QString starts with its big endian byte count, so its first byte is 0x00
+// (0xFF for a null string), which FRAME_MAGIC never is.
+//
+// Frame, all fields little endian:
+//   magic u8, type u8, length u16 (payload bytes), seq u32,
+//   payload, crc u32 (CRC32C of all bytes before it, see crc32c.h)
+
+static const quint8 FRAME_MAGIC = 0xA5;
+static const int FRAME_HEADER_SIZE = 8;
+static const int FRAME_CHECK_SIZE = 4;
+static const int FRAME_MAX_PAYLOAD = 1024;
+static const int FRAME_MAX_CHANNELS = 16;
+static const int TEXT_MAX_BYTES = 4096;
+static const int HELLO_MAX_NAME = 64;
+
+enum FrameType
+{
+    FrameChannels = 1,      // count u8, count x u16 channel values[, sender time u64]
+    FrameDelta = 2,         // mask u16 (bit n = channel n), u16 value per set bit[, sender time u64]
+    FrameHello = 3,         // role u8, priority u8, UTF-8 name
+    FrameRelease = 4,       // empty, the owner hands control back
+    FrameControl = 5,       // server to client: owner u8 (1 = you), priority u8, owner id u16
+    FrameTelemetry = 6,     // server to client, see Telemetry
+    FrameSubscribe = 7,     // telemetry rate u16 in Hz, 0 stops it
+    FramePath = 8,          // session u32, path u8: this connection carries a copy of the session's frames
+    FramePing = 9,          // server to client: server time u64
+    FramePong = 10,         // server time u64 from the ping, client receive and send time u64
+    FrameFeedback = 11,     // server to client, see Feedback
+    FrameResume = 12        // token u32, random per client process and kept across reconnects
+};
+
+// Sequence numbers count channel and delta frames, the control frames
+// above carry 0 and leave the count alone.
+// Times are microseconds on the sender's monotonic clock. A ping exchange
+// gives the server each client's clock offset, so the optional sender time
+// of a channel frame tells how old the frame is when it arrives.
+
+enum ControlRole
+{
+    RoleObserver = 0,       // receives, never moves the vehicle
+    RoleController = 1
+};
+
+struct FrameHeader
+{
+    quint8 type;
+    quint16 length;
+    quint32 seq;
+};
+
+inline void putU16(char *p, quint16 v) { p[0] = char(v); p[1] = char(v >> 8); }
+inline void putU32(char *p, quint32 v) { putU16(p, quint16(v)); putU16(p + 2, quint16(v >> 16)); }
+inline quint16 getU16(const char *p) { return quint16(uchar(p[0]) | uchar(p[1]) << 8); }
+inline quint32 getU32(const char *p) { return getU16(p) | quint32(getU16(p + 2)) << 16; }
+inline void putU64(char *p, quint64 v) { putU32(p, quint32(v)); putU32(p + 4, quint32(v >> 32)); }
+inline quint64 getU64(const char *p) { return getU32(p) | quint64(getU32(p + 4)) << 32; }
+
+// Appends one complete frame to out
+void appendFrame(QByteArray &out, FrameType type, quint32 seq, const char *payload, int size);
+
+// stampUs is the sender time, 0 leaves it out
+void appendChannelsFrame(QByteArray &out, quint32 seq, const int *values, int count, quint64 stampUs = 0);
+// False if the payload is malformed, values must hold FRAME_MAX_CHANNELS.
+// stampUs is set to the sender time, 0 without one.
+bool decodeChannels(const char *payload, int size, int *values, int &count, quint64 *stampUs = nullptr);
+
+// Only the channels in mask, values holds all channels
+void appendDeltaFrame(QByteArray &out, quint32 seq, const int *values, quint16 mask, quint64 stampUs = 0);
+
+void appendHelloFrame(QByteArray &out, ControlRole role, int priority, const QString &name);
+bool decodeHello(const char *payload, int size, ControlRole &role, int &priority, QString &name);
+
+void appendControlFrame(QByteArray &out, bool owner, int priority, quint16 ownerId);
+bool decodeControl(const char *payload, int size, bool &owner, int &priority, quint16 &ownerId);
+
+void appendPingFrame(QByteArray &out, quint64 serverUs);
+bool decodePing(const char *payload, int size, quint64 &serverUs);
+// Answer to a ping, received and sent are client times
+void appendPongFrame(QByteArray &out, quint64 serverUs, quint64 receivedUs, quint64 sentUs);
+bool decodePong(const char *payload, int size, quint64 &serverUs, quint64 &receivedUs, quint64 &sentUs);
+
+// Full channel state of one sender, rebuilt from full and delta frames.
+// A delta only carries absolute values of the channels that changed, so
+// after a gap it still applies, channels changed in the lost frames are
+// repaired by the next full frame (the sender's heartbeat).
+class ChannelState
+{
+public:
+    enum Result
+    {
+        Applied,
+        NoBase,     // delta before the first full frame
+        Stale,      // delta older than the state, reordered datagram
+        Invalid     // malformed payload or unknown frame type
+    };
+
+    ChannelState();
+    void reset();
+
+    Result apply(const FrameHeader &header, const char *payload);
+
+    const int *values() const { return m_values; }
+    int count() const { return m_count; }
+    // Frames missing between the ones applied, from sequence numbers
+    quint32 lost() const { return m_lost; }
+    // Frames lost before the last one applied, 0 if there was no gap
+    quint32 lastGap() const { return m_lastGap; }
+    // Sender time of the last frame applied, 0 if it had none
+    quint64 stampUs() const { return m_stampUs; }
+
+private:
+    int m_values[FRAME_MAX_CHANNELS];
+    int m_count;
+    bool m_hasSeq;
+    quint32 m_lastSeq;
+    quint32 m_lost;
+    quint32 m_lastGap;
+    quint64 m_stampUs;
+};
+
+void appendSubscribeFrame(QByteArray &out, int rateHz);
+bool decodeSubscribe(const char *payload, int size, int &rateHz);
+
+// A client sending every frame over two connections (e.g. TCP and UDP)
+// announces both with the same random session and path 0 or 1, then sends
+// each frame with the same sequence number on both. The server keeps the
+// first copy.
+static const int FRAME_PATHS = 2;
+void appendPathFrame(QByteArray &out, quint32 session, int path);
+bool decodePath(const char *payload, int size, quint32 &session, int &path);
+
+// Sent after the hello of every connection of a client. A new connection
+// with the token of one still open on the server (its old one over a link
+// that dropped) takes over that one's control at once.
+void appendResumeFrame(QByteArray &out, quint32 token);
+bool decodeResume(const char *payload, int size, quint32 &token);
+
+// How the server took a client's channel frames, sent periodically so the
+// client can slow down on a congested link. Counters are totals since the
+// connection started, the client compares them with the previous feedback.
+// Payload: 6 x u32 in the order below.
+struct Feedback
+{
+    static const quint32 NO_AGE = 0xFFFFFFFF;
+
+    quint32 received;           // channel and delta frames, used or not
+    quint32 lost;               // missing from the sequence numbers
+    quint32 late;               // of the received, reordered or older than the server's maximum age
+    quint32 coalesced;          // replaced by the next one before the mixer took them
+    quint32 ageUs;              // mean age since the previous feedback, NO_AGE unknown
+    quint32 queuedBytes;        // server data waiting to be sent to the client
+};
+
+void appendFeedbackFrame(QByteArray &out, const Feedback &feedback);
+bool decodeFeedback(const char *payload, int size, Feedback &feedback);
+
+static const int TELEMETRY_MAX_INPUTS = 8;
+
+// Bridge state for operator displays, one snapshot per telemetry tick.
+// Payload: flags u8 (1 = failsafe), source i8 (-1 none), count u8,
+// count x u16 output channels, inputs u8, then per input type u8, flags u8,
+// 5 x u32 counters and with HasLink 10 bytes of CRSF link statistics.
+struct TelemetryInput
+{
+    enum Type { Network, Sbus, Crsf, Shm };
+    enum Flags { Open = 1, Fresh = 2, HasLink = 4 };
+
+    quint8 type;
+    quint8 flags;
+    quint32 goodFrames;
+    quint32 badFrames;          // failed checksum, CRC or footer
+    quint32 lostFrames;         // SBUS frame lost flags
+    quint32 failsafes;          // SBUS failsafe frames, CRSF link down events
+    quint32 resyncs;
+
+    // CRSF link statistics as the receiver reports them
+    quint8 uplinkRssi1;         // -dBm
+    quint8 uplinkRssi2;
+    quint8 uplinkQuality;       // %
+    qint8 uplinkSnr;            // dB
+    quint8 activeAntenna;
+    quint8 rfMode;
+    quint8 uplinkTxPower;
+    quint8 downlinkRssi;
+    quint8 downlinkQuality;
+    qint8 downlinkSnr;
+};
+
+struct Telemetry
+{
+    bool failsafe;
+    int source;                 // input in priority order, -1 before the first frame
+    int count;
+    int channels[FRAME_MAX_CHANNELS];
+    int inputCount;
+    TelemetryInput inputs[TELEMETRY_MAX_INPUTS];
+};
+
+static const int TELEMETRY_MAX_PAYLOAD = 4 + 2 * FRAME_MAX_CHANNELS + TELEMETRY_MAX_INPUTS * (2 + 5 * 4 + 10);
+
+// Returns the payload size, payload must hold TELEMETRY_MAX_PAYLOAD bytes
+int encodeTelemetry(const Telemetry &telemetry, char *payload);
+bool decodeTelemetry(const char *payload, int size, Telemetry &telemetry);
+
+// Splits a received byte stream into text messages and frames.
+// TCP data is appended as it arrives, next() returns one complete message
+// at a time. After garbage or a failed check it resynchronizes on the
+// next byte that can start a message.
+class FrameReader
+{
+public:
+    enum Result
+    {
+        NeedMore,   // no complete message buffered
+        Text,       // text() holds a QDataStream string
+        Frame,      // header() and payload() hold a frame with a valid CRC
+        Invalid     // error() says what was skipped
+    };
+
+    FrameReader();
+
+    // Invalidates payload()
+    void append(const char *data, int size);
+    void append(const QByteArray &data) { append(data.constData(), data.size()); }
+    void clear();
+
+    Result next();
+
+    const QString &text() const { return m_text; }
+    const FrameHeader &header() const { return m_header; }
+    const char *payload() const { return m_payload; }
+    const QString &error() const { return m_error; }
+    int buffered() const { return m_buf.size() - m_pos; }
+
+private:
+    Result invalid(int skip, const QString &error);
+
+    QByteArray m_buf;
+    int m_pos;
+    QString m_text;
+    FrameHeader m_header;
+    const char *m_payload;
+    QString m_error;
+};
+
+#endif // JOYSTICKPROTOCOL_H
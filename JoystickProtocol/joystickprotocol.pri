@@ -0,0 +1,11 @@
+# Binary frame format shared by QTCPClient and QTCPServer
+
+SOURCES += \
+    $$PWD/crc32c.cpp \
+    $$PWD/joystickprotocol.cpp
+
+HEADERS += \
+    $$PWD/crc32c.h \
+    $$PWD/joystickprotocol.h
+
+INCLUDEPATH += $$PWD
@@ -0,0 +1,151 @@
+#include <iostream>
+#include <QByteArray>
+#include "joystickprotocol.h"
+
+using namespace std;
+
+// A frame as the sender builds it. Full frames carry 4 channels starting
+// at value, delta frames change channel 0 to value.
+struct Frame
+{
+    FrameType type;
+    quint32 seq;
+    int value;
+    ChannelState::Result result;
+};
+
+struct Case
+{
+    const char *name;
+    Frame frames[5];
+    int frameCount;
+    // State after the last frame
+    int channel0;
+    int channel1;
+    quint32 lost;
+    quint32 lastGap;
+};
+
+static const ChannelState::Result A = ChannelState::Applied;
+static const ChannelState::Result S = ChannelState::Stale;
+static const ChannelState::Result N = ChannelState::NoBase;
+static const ChannelState::Result I = ChannelState::Invalid;
+
+static const Case cases[] =
+{
+    { "in order", { {FrameChannels, 1, 100, A}, {FrameDelta, 2, 110, A}, {FrameDelta, 3, 120, A}, {FrameChannels, 4, 200, A} }, 4, 200, 201, 0, 0 },
+    { "duplicate full frame", { {FrameChannels, 1, 100, A}, {FrameChannels, 1, 300, S} }, 2, 100, 101, 0, 0 },
+    { "duplicate delta", { {FrameChannels, 1, 100, A}, {FrameDelta, 2, 150, A}, {FrameDelta, 2, 160, S} }, 3, 150, 101, 0, 0 },
+    { "reordered delta", { {FrameChannels, 1, 100, A}, {FrameDelta, 3, 130, A}, {FrameDelta, 2, 120, S} }, 3, 130, 101, 1, 1 },
+    { "reordered full frame", { {FrameChannels, 100, 100, A}, {FrameChannels, 50, 300, S} }, 2, 100, 101, 0, 0 },
+    { "wraparound", { {FrameChannels, 0xFFFFFFFE, 100, A}, {FrameDelta, 0xFFFFFFFF, 110, A}, {FrameDelta, 0, 120, A}, {FrameDelta, 1, 130, A} }, 4, 130, 101, 0, 0 },
+    { "gap across wraparound", { {FrameChannels, 0xFFFFFFFF, 100, A}, {FrameDelta, 2, 110, A} }, 2, 110, 101, 2, 2 },
+    { "stale across wraparound", { {FrameChannels, 1, 100, A}, {FrameDelta, 0xFFFFFFFF, 110, S} }, 2, 100, 101, 0, 0 },
+    { "restart", { {FrameChannels, 5000, 100, A}, {FrameChannels, 1, 300, A}, {FrameDelta, 2, 310, A} }, 3, 310, 301, 0, 0 },
+    { "restart at the window", { {FrameChannels, 2000, 100, A}, {FrameChannels, 2000 - 1024, 300, A} }, 2, 300, 301, 0, 0 },
+    { "inside the window", { {FrameChannels, 2000, 100, A}, {FrameChannels, 2000 - 1023, 300, S} }, 2, 100, 101, 0, 0 },
+    { "delta can't restart", { {FrameChannels, 5000, 100, A}, {FrameDelta, 1, 110, S} }, 2, 100, 101, 0, 0 },
+    { "delta before full frame", { {FrameDelta, 1, 110, N}, {FrameChannels, 2, 100, A}, {FrameDelta, 3, 120, A} }, 3, 120, 101, 0, 0 },
+    { "delta after gap", { {FrameChannels, 1, 100, A}, {FrameDelta, 5, 140, A} }, 2, 140, 101, 3, 3 },
+    { "gaps add up", { {FrameChannels, 1, 100, A}, {FrameDelta, 3, 110, A}, {FrameDelta, 4, 120, A}, {FrameDelta, 7, 130, A} }, 4, 130, 101, 3, 2 },
+    { "unknown type", { {FrameChannels, 1, 100, A}, {FrameHello, 2, 0, I}, {FrameDelta, 2, 110, A} }, 3, 110, 101, 0, 0 }
+};
+
+static void build(const Frame &frame, QByteArray &out)
+{
+    int values[FRAME_MAX_CHANNELS] = { frame.value };
+    switch (frame.type)
+    {
+    case FrameChannels:
+        for (int i=1; i<4; i++) values[i] = frame.value + i;
+        appendChannelsFrame(out, frame.seq, values, 4);
+        break;
+    case FrameDelta:
+        appendDeltaFrame(out, frame.seq, values, 1);
+        break;
+    default:
+        appendFrame(out, frame.type, frame.seq, nullptr, 0);
+        break;
+    }
+}
+
+static bool apply(ChannelState &state, const QByteArray &frame, ChannelState::Result &result)
+{
+    FrameReader reader;
+    reader.append(frame);
+    if (reader.next() != FrameReader::Frame) return false;
+    result = state.apply(reader.header(), reader.payload());
+    return true;
+}
+
+int main()
+{
+    int failed = 0;
+    for (const Case &c : cases)
+    {
+        ChannelState state;
+        for (int i=0; i<c.frameCount; i++)
+        {
+            QByteArray frame;
+            build(c.frames[i], frame);
+            ChannelState::Result result;
+            if (!apply(state, frame, result))
+            {
+                cerr << c.name << ": frame " << i << " not read back" << endl;
+                return -1;
+            }
+            if (result != c.frames[i].result)
+            {
+                cerr << c.name << ": frame " << i << " gave " << result << ", expected " << c.frames[i].result << endl;
+                failed++;
+            }
+        }
+
+        if (state.count() != 4 || state.values()[0] != c.channel0 || state.values()[1] != c.channel1)
+        {
+            cerr << c.name << ": channels " << state.values()[0] << ", " << state.values()[1]
+                 << ", expected " << c.channel0 << ", " << c.channel1 << endl;
+            failed++;
+        }
+        if (state.lost() != c.lost || state.lastGap() != c.lastGap)
+        {
+            cerr << c.name << ": lost " << state.lost() << ", last gap " << state.lastGap()
+                 << ", expected " << c.lost << ", " << c.lastGap << endl;
+            failed++;
+        }
+    }
+
+    // Malformed deltas leave the state alone
+    ChannelState state;
+    QByteArray frame;
+    int values[FRAME_MAX_CHANNELS] = { 100, 101 };
+    appendChannelsFrame(frame, 1, values, 2);
+    ChannelState::Result result;
+    apply(state, frame, result);
+
+    frame.clear();
+    appendDeltaFrame(frame, 2, values, 1 << 2);
+    if (!apply(state, frame, result) || result != ChannelState::Invalid)
+    {
+        cerr << "delta for a channel the state doesn't have accepted" << endl;
+        failed++;
+    }
+
+    // The sender time goes with the frame that carried it
+    frame.clear();
+    appendDeltaFrame(frame, 2, values, 1, 123456789);
+    if (!apply(state, frame, result) || result != ChannelState::Applied || state.stampUs() != 123456789)
+    {
+        cerr << "stamped delta not applied" << endl;
+        failed++;
+    }
+    frame.clear();
+    appendChannelsFrame(frame, 3, values, 2);
+    if (!apply(state, frame, result) || result != ChannelState::Applied || state.stampUs() != 0)
+    {
+        cerr << "sender time kept from an earlier frame" << endl;
+        failed++;
+    }
+
+    return failed ? -1 : 0;
+}
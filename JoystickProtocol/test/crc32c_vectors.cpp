@@ -0,0 +1,99 @@
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include "crc32c.h"
+
+using namespace std;
+
+typedef quint32 (*Crc32cFunction)(quint32 crc, const void *data, int size);
+
+struct Known
+{
+    const char *name;
+    uchar data[32];
+    int size;
+    quint32 crc;
+};
+
+// The check value of the CRC catalogue and the iSCSI vectors of RFC 3720
+static Known known[] =
+{
+    { "check", "123456789", 9, 0xE3069283 },
+    { "32 zeros", { 0 }, 32, 0x8A9136AA },
+    { "32 x 0xFF", { 0 }, 32, 0x62A8AB43 },
+    { "0 to 31", { 0 }, 32, 0x46DD794E },
+    { "31 to 0", { 0 }, 32, 0x113FDB5C }
+};
+
+static int checkKnown(Crc32cFunction crc32c, const char *implementation)
+{
+    int failed = 0;
+    for (const Known &k : known)
+    {
+        quint32 crc = crc32c(0, k.data, k.size);
+        if (crc != k.crc)
+        {
+            cerr << implementation << ", " << k.name << ": " << hex << crc << ", expected " << k.crc << dec << endl;
+            failed++;
+        }
+    }
+    if (crc32c(0, known[0].data, 0) != 0)
+    {
+        cerr << implementation << ": CRC of no data isn't 0" << endl;
+        failed++;
+    }
+    return failed;
+}
+
+// Any split of the data gives the same CRC as one call
+static int checkIncremental(Crc32cFunction crc32c, const char *implementation, const uchar *data, int size)
+{
+    quint32 whole = crc32c(0, data, size);
+    for (int split=0; split<=size; split++)
+    {
+        if (crc32c(crc32c(0, data, split), data + split, size - split) != whole)
+        {
+            cerr << implementation << ": split at " << split << " of " << size << " differs" << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main()
+{
+    memset(known[2].data, 0xFF, 32);
+    for (int i=0; i<32; i++)
+    {
+        known[3].data[i] = uchar(i);
+        known[4].data[i] = uchar(31 - i);
+    }
+
+    cout << "Dispatched implementation: " << crc32cImplementation() << endl;
+    int failed = checkKnown(crc32c, crc32cImplementation());
+    failed += checkKnown(crc32cPortable, "table");
+
+    // Random lengths and alignments, the hardware paths take 8, 4 and 1
+    // bytes at a time
+    static uchar buf[1024 + 8];
+    srand(1);
+    for (size_t i=0; i<sizeof(buf); i++) buf[i] = uchar(rand());
+    for (int round=0; round<2000; round++)
+    {
+        int offset = rand() % 8;
+        int size = rand() % 1024;
+        quint32 seed = round % 2 ? quint32(rand()) : 0;
+        quint32 dispatched = crc32c(seed, buf + offset, size);
+        quint32 table = crc32cPortable(seed, buf + offset, size);
+        if (dispatched != table)
+        {
+            cerr << crc32cImplementation() << " and table differ on " << size << " bytes at offset " << offset << endl;
+            failed++;
+        }
+    }
+
+    failed += checkIncremental(crc32c, crc32cImplementation(), buf + 3, 67);
+    failed += checkIncremental(crc32cPortable, "table", buf + 3, 67);
+
+    return failed ? -1 : 0;
+}
@@ -0,0 +1,12 @@
+#-------------------------------------------------
+#
+# Unit tests of the frame format, run with make check
+#
+#-------------------------------------------------
+
+TEMPLATE = subdirs
+
+SUBDIRS += channel_state crc32c
+
+channel_state.file = test_channel_state.pro
+crc32c.file = test_crc32c.pro
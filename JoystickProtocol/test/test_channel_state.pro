@@ -0,0 +1,16 @@
+QT       += core
+QT       -= gui
+
+TARGET = test_channel_state
+TEMPLATE = app
+
+CONFIG+=sdk_no_version_check
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+CONFIG += c++11
+
+include(../joystickprotocol.pri)
+
+SOURCES += \
+        channel_state.cpp
@@ -0,0 +1,17 @@
+QT       += core
+QT       -= gui
+
+TARGET = test_crc32c
+TEMPLATE = app
+
+CONFIG+=sdk_no_version_check
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+CONFIG += c++11
+
+include(../joystickprotocol.pri)
+
+# Not crc32c.cpp, its object would clash with the one under test
+SOURCES += \
+        crc32c_vectors.cpp
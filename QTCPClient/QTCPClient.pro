@@ -26,12 +26,22 @@ DEFINES += QT_DEPRECATED_WARNINGS
 
 CONFIG += c++11
 
+include(../JoystickProtocol/joystickprotocol.pri)
+
 SOURCES += \
+        evdevreader.cpp \
+        joysticksender.cpp \
         main.cpp \
-        mainwindow.cpp
+        mainwindow.cpp \
+        ratecontrol.cpp \
+        reconnector.cpp
 
 HEADERS += \
-        mainwindow.h
+        evdevreader.h \
+        joysticksender.h \
+        mainwindow.h \
+        ratecontrol.h \
+        reconnector.h
 
 FORMS += \
         mainwindow.ui
@@ -0,0 +1,192 @@
+#include "evdevreader.h"
+#include <QFile>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+
+static qint64 monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+EvdevReader::EvdevReader() :
+    m_fd(-1), m_dropped(false), m_isRecording(false), m_loop(false),
+    m_next(0), m_startNs(0), m_firstUs(0)
+{
+    memset(m_abs, 0, sizeof(m_abs));
+    memset(m_keys, 0, sizeof(m_keys));
+    setRecordingRange(-32768, 32767);
+}
+
+EvdevReader::~EvdevReader()
+{
+    close();
+}
+
+void EvdevReader::setRecordingRange(int min, int max)
+{
+    for (int i=0; i<ABS_CNT; i++)
+    {
+        m_min[i] = min;
+        m_max[i] = max;
+    }
+}
+
+bool EvdevReader::open(const QString &path, QString &error)
+{
+    close();
+
+    struct stat st;
+    if (::stat(path.toLocal8Bit().constData(), &st) == 0 && S_ISREG(st.st_mode))
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+        {
+            error = QString("Unable to open '%1': %2").arg(path, file.errorString());
+            return false;
+        }
+        m_recording = file.readAll();
+        if (m_recording.size() < int(sizeof(struct input_event)))
+        {
+            error = QString("'%1' holds no input events").arg(path);
+            return false;
+        }
+
+        const struct input_event *first = reinterpret_cast<const struct input_event *>(m_recording.constData());
+        m_firstUs = qint64(first->time.tv_sec) * 1000000 + first->time.tv_usec;
+        m_next = 0;
+        m_startNs = monotonicNs();
+        m_isRecording = true;
+        m_name = QString("recording %1").arg(path);
+        return true;
+    }
+
+    m_fd = ::open(path.toLocal8Bit().constData(), O_RDONLY | O_NONBLOCK);
+    if (m_fd < 0)
+    {
+        error = QString("Unable to open '%1': %2").arg(path, strerror(errno));
+        return false;
+    }
+
+    char name[128] = "";
+    ioctl(m_fd, EVIOCGNAME(sizeof(name)), name);
+    m_name = QString::fromLocal8Bit(name);
+
+    if (!syncState())
+    {
+        error = QString("'%1' is not an input device").arg(path);
+        close();
+        return false;
+    }
+    return true;
+}
+
+void EvdevReader::close()
+{
+    if (m_fd >= 0)
+    {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+    m_isRecording = false;
+    m_recording.clear();
+}
+
+// Current axis values, ranges and buttons straight from the driver
+bool EvdevReader::syncState()
+{
+    unsigned long keys[KEY_CNT / (8 * sizeof(unsigned long)) + 1];
+    memset(keys, 0, sizeof(keys));
+    if (ioctl(m_fd, EVIOCGKEY(sizeof(keys)), keys) < 0)
+        return false;
+
+    for (int i=0; i<KEY_CNT; i++)
+        m_keys[i] = keys[i / (8 * sizeof(unsigned long))] & (1UL << (i % (8 * sizeof(unsigned long))));
+
+    for (int i=0; i<ABS_CNT; i++)
+    {
+        struct input_absinfo info;
+        if (ioctl(m_fd, EVIOCGABS(i), &info) == 0 && info.maximum > info.minimum)
+        {
+            m_abs[i] = info.value;
+            m_min[i] = info.minimum;
+            m_max[i] = info.maximum;
+        }
+    }
+    m_dropped = false;
+    return true;
+}
+
+void EvdevReader::apply(const struct input_event &event)
+{
+    if (event.type == EV_SYN)
+    {
+        if (event.code == SYN_DROPPED)
+            m_dropped = true;
+        else if (event.code == SYN_REPORT && m_dropped && m_fd >= 0)
+            syncState();
+        return;
+    }
+
+    // Events between SYN_DROPPED and the next report are incomplete
+    if (m_dropped) return;
+
+    if (event.type == EV_ABS && event.code < ABS_CNT)
+        m_abs[event.code] = event.value;
+    else if (event.type == EV_KEY && event.code < KEY_CNT)
+        m_keys[event.code] = event.value != 0;
+}
+
+void EvdevReader::playRecording()
+{
+    const struct input_event *events = reinterpret_cast<const struct input_event *>(m_recording.constData());
+    int count = m_recording.size() / int(sizeof(struct input_event));
+    qint64 elapsedUs = (monotonicNs() - m_startNs) / 1000;
+
+    while (m_next < count)
+    {
+        const struct input_event &event = events[m_next];
+        if (qint64(event.time.tv_sec) * 1000000 + event.time.tv_usec - m_firstUs > elapsedUs)
+            break;
+        apply(event);
+        m_next++;
+    }
+
+    if (m_next >= count && m_loop)
+    {
+        m_next = 0;
+        m_startNs = monotonicNs();
+    }
+}
+
+bool EvdevReader::poll()
+{
+    if (m_isRecording)
+    {
+        playRecording();
+        return true;
+    }
+    if (m_fd < 0)
+        return false;
+
+    struct input_event events[64];
+    for (;;)
+    {
+        ssize_t n = ::read(m_fd, events, sizeof(events));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            return errno == EAGAIN;
+        if (n == 0)
+            return false;
+
+        for (int i=0; i<int(n / ssize_t(sizeof(struct input_event))); i++)
+            apply(events[i]);
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef EVDEVREADER_H
+#define EVDEVREADER_H
+
+#include <QByteArray>
+#include <QString>
+#include <linux/input.h>
+
+// Linux evdev gamepad state, read without blocking.
+// path is a device (/dev/input/eventN) or a file of recorded input_event
+// structs, e.g. made with "cat /dev/input/event0 > pad.events". A recording
+// is played back on its own timestamps.
+class EvdevReader
+{
+public:
+    EvdevReader();
+    ~EvdevReader();
+
+    bool open(const QString &path, QString &error);
+    void close();
+    bool isOpen() const { return m_fd >= 0 || m_isRecording; }
+    bool isRecording() const { return m_isRecording; }
+    // Readable when events are pending, -1 for a recording
+    int fd() const { return m_fd; }
+    QString name() const { return m_name; }
+
+    // Range of the axes of a recording, devices report their own
+    void setRecordingRange(int min, int max);
+    // Start a recording over when it ends
+    void setLoop(bool loop) { m_loop = loop; }
+
+    // Applies every pending event, false if the device is gone
+    bool poll();
+
+    int axis(int code) const { return m_abs[code]; }
+    int axisMin(int code) const { return m_min[code]; }
+    int axisMax(int code) const { return m_max[code]; }
+    bool button(int code) const { return m_keys[code]; }
+
+private:
+    void apply(const struct input_event &event);
+    bool syncState();
+    void playRecording();
+
+    int m_fd;
+    QString m_name;
+    bool m_dropped;         // SYN_DROPPED seen, state is resynced at the next SYN_REPORT
+
+    bool m_isRecording;
+    bool m_loop;
+    QByteArray m_recording;
+    int m_next;
+    qint64 m_startNs;
+    qint64 m_firstUs;
+
+    int m_abs[ABS_CNT];
+    int m_min[ABS_CNT];
+    int m_max[ABS_CNT];
+    bool m_keys[KEY_CNT];
+};
+
+#endif // EVDEVREADER_H
@@ -0,0 +1,606 @@
+#include "joysticksender.h"
+#include "crc32c.h"
+#include <QDateTime>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <QTcpSocket>
+#include <QUdpSocket>
+#include <string.h>
+#include <time.h>
+
+static const int BUTTON_FLAG = 0x10000;
+// Longest time between full frames while deltas are sent
+static const int KEYFRAME_MS = 1000;
+
+struct CodeName
+{
+    const char *name;
+    int code;
+};
+
+static const CodeName axisNames[] = {
+    { "x", ABS_X }, { "y", ABS_Y }, { "z", ABS_Z },
+    { "rx", ABS_RX }, { "ry", ABS_RY }, { "rz", ABS_RZ },
+    { "throttle", ABS_THROTTLE }, { "rudder", ABS_RUDDER },
+    { "wheel", ABS_WHEEL }, { "gas", ABS_GAS }, { "brake", ABS_BRAKE },
+    { "hat0x", ABS_HAT0X }, { "hat0y", ABS_HAT0Y },
+    { "hat1x", ABS_HAT1X }, { "hat1y", ABS_HAT1Y },
+};
+
+static const CodeName buttonNames[] = {
+    { "south", BTN_SOUTH }, { "east", BTN_EAST }, { "north", BTN_NORTH }, { "west", BTN_WEST },
+    { "tl", BTN_TL }, { "tr", BTN_TR }, { "tl2", BTN_TL2 }, { "tr2", BTN_TR2 },
+    { "select", BTN_SELECT }, { "start", BTN_START }, { "mode", BTN_MODE },
+    { "thumbl", BTN_THUMBL }, { "thumbr", BTN_THUMBR },
+    { "trigger", BTN_TRIGGER }, { "thumb", BTN_THUMB }, { "thumb2", BTN_THUMB2 },
+    { "top", BTN_TOP }, { "top2", BTN_TOP2 }, { "pinkie", BTN_PINKIE }, { "base", BTN_BASE },
+};
+
+// Frame times and ping answers, the server only needs the same clock for both
+static quint64 monotonicUs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return quint64(ts.tv_sec) * 1000000 + quint64(ts.tv_nsec) / 1000;
+}
+
+static bool lookup(const CodeName *table, int size, const QString &name, int limit, int &code)
+{
+    bool ok = false;
+    code = name.toInt(&ok);
+    if (ok) return code >= 0 && code < limit;
+
+    for (int i=0; i<size; i++)
+    {
+        if (name == table[i].name)
+        {
+            code = table[i].code;
+            return true;
+        }
+    }
+    return false;
+}
+
+JoystickSender::JoystickSender(const SenderConfig &config, QObject *parent) :
+    QObject(parent), m_config(config), m_socket(nullptr), m_link(nullptr), m_resumeToken(0),
+    m_lastRxMs(0), m_serverPings(false), m_reconnectedMs(-1), m_second(nullptr), m_secondLink(nullptr), m_session(0), m_lastReopenMs(0), m_seq(0),
+    m_notifier(nullptr), m_lastSendMs(0), m_lastFullMs(0), m_framesSent(0), m_inControl(-1)
+{
+    m_rate.setBounds(m_config.minRateHz > 0 ? m_config.minRateHz : m_config.rateHz, m_config.rateHz,
+                     m_config.deltaThreshold, qMax(m_config.deltaThreshold, m_config.maxDeltaThreshold));
+
+    m_timer = new QTimer(this);
+    m_timer->setTimerType(Qt::PreciseTimer);
+    m_timer->setInterval(qMax(1, 1000 / qMax(1, m_config.rateHz)));
+    connect(m_timer, &QTimer::timeout, this, &JoystickSender::tick);
+
+    m_holdTimer = new QTimer(this);
+    m_holdTimer->setTimerType(Qt::PreciseTimer);
+    m_holdTimer->setSingleShot(true);
+    connect(m_holdTimer, &QTimer::timeout, this, &JoystickSender::sendChanges);
+
+    m_heartbeat = new QTimer(this);
+    m_heartbeat->setInterval(qMax(1, m_config.heartbeatMs));
+    connect(m_heartbeat, &QTimer::timeout, this, &JoystickSender::heartbeat);
+
+    m_linkTimer = new QTimer(this);
+    m_linkTimer->setInterval(qMax(50, m_config.linkTimeoutMs / 4));
+    connect(m_linkTimer, &QTimer::timeout, this, &JoystickSender::checkLink);
+
+    memset(m_values, 0, sizeof(m_values));
+    memset(m_sent, 0, sizeof(m_sent));
+    m_clock.start();
+}
+
+bool JoystickSender::parseMap(const QString &map, QVector<int> &codes, QString &error)
+{
+    codes.clear();
+    foreach (QString entry, map.split(','))
+    {
+        entry = entry.trimmed();
+        bool reverse = entry.startsWith(QLatin1Char('-'));
+        if (reverse) entry.remove(0, 1);
+
+        int code = 0;
+        bool ok;
+        if (entry.startsWith("btn:"))
+        {
+            ok = lookup(buttonNames, int(sizeof(buttonNames) / sizeof(buttonNames[0])), entry.mid(4), KEY_CNT, code);
+            code |= BUTTON_FLAG;
+        }
+        else
+        {
+            ok = lookup(axisNames, int(sizeof(axisNames) / sizeof(axisNames[0])),
+                        entry.startsWith("abs:") ? entry.mid(4) : entry, ABS_CNT, code);
+        }
+
+        if (!ok)
+        {
+            error = QString("Unknown axis or button '%1' in the channel map").arg(entry);
+            return false;
+        }
+        codes << (reverse ? -code - 1 : code);
+    }
+
+    if (codes.isEmpty() || codes.count() > FRAME_MAX_CHANNELS)
+    {
+        error = QString("The channel map needs 1 to %1 entries").arg(FRAME_MAX_CHANNELS);
+        return false;
+    }
+    return true;
+}
+
+bool JoystickSender::start(QString &error)
+{
+    if (!parseMap(m_config.map, m_codes, error))
+        return false;
+    QList<Reconnector::Server> servers;
+    if (!Reconnector::parseServers(m_config.host, m_config.port, servers, error))
+        return false;
+    QList<Reconnector::Server> secondServers;
+    if (!m_config.secondHost.isEmpty() && !Reconnector::parseServers(m_config.secondHost, m_config.port, secondServers, error))
+        return false;
+
+    m_reader.setRecordingRange(m_config.recordingMin, m_config.recordingMax);
+    m_reader.setLoop(m_config.loop);
+    if (!m_reader.open(m_config.device, error))
+        return false;
+    emit statusMessage(QString("Reading %1").arg(m_reader.name()));
+
+    m_socket = createSocket(m_config.udp);
+    connect(m_socket, &QAbstractSocket::connected, this, &JoystickSender::connected);
+    connect(m_socket, &QAbstractSocket::disconnected, this, &JoystickSender::disconnected);
+    connect(m_socket, &QAbstractSocket::readyRead, this, &JoystickSender::readSocket);
+
+    emit statusMessage(QString("Frame CRC32C: %1").arg(crc32cImplementation()));
+    // Never 0, which means no token on the server
+    m_resumeToken = QRandomGenerator::global()->generate() | 1;
+    // UDP "connects" at once, it only fixes the peer address
+    m_link = new Reconnector(m_socket, servers, m_config.reconnectMaxMs, this);
+    connect(m_link, &Reconnector::attempt, this, &JoystickSender::connectAttempt);
+    m_link->start();
+
+    if (!m_config.secondHost.isEmpty())
+    {
+        m_session = QRandomGenerator::global()->generate();
+        m_second = createSocket(!m_config.udp);
+        connect(m_second, &QAbstractSocket::connected, this, &JoystickSender::secondConnected);
+        connect(m_second, &QAbstractSocket::disconnected, this, &JoystickSender::secondDisconnected);
+        connect(m_second, &QAbstractSocket::readyRead, this, &JoystickSender::drainSecond);
+        // Reconnects on its own, it carries the frames while the first path is down
+        m_secondLink = new Reconnector(m_second, secondServers, m_config.reconnectMaxMs, this);
+        m_secondLink->start();
+    }
+    return true;
+}
+
+QAbstractSocket *JoystickSender::createSocket(bool udp)
+{
+    QAbstractSocket *socket;
+    if (udp)
+    {
+        socket = new QUdpSocket(this);
+    }
+    else
+    {
+        socket = new QTcpSocket(this);
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    }
+    connect(socket, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(socketError(QAbstractSocket::SocketError)));
+    return socket;
+}
+
+void JoystickSender::connected()
+{
+    // Role first, the server answers with who is in control
+    m_frame.clear();
+    appendHelloFrame(m_frame, m_config.observer ? RoleObserver : RoleController, m_config.priority, m_config.name);
+    appendResumeFrame(m_frame, m_resumeToken);
+    if (m_second)
+        appendPathFrame(m_frame, m_session, 0);
+    if (m_config.telemetryHz > 0)
+        appendSubscribeFrame(m_frame, m_config.telemetryHz);
+    m_socket->write(m_frame);
+    m_inControl = -1;
+    m_lastRxMs = m_clock.elapsed();
+    m_serverPings = false;
+    if (m_config.linkTimeoutMs > 0) m_linkTimer->start();
+    m_rate.reset();
+    m_framesSent = 0;
+    m_timer->setInterval(qMax(1, 1000 / m_rate.rateHz()));
+
+    const Reconnector::Server &server = m_link->server();
+    if (m_reconnectedMs >= 0)
+    {
+        emit statusMessage(QString("Reconnected to %1:%2 after %3 ms").arg(server.host).arg(server.port).arg(m_link->lastOutageMs()));
+        m_reconnectedMs = m_clock.elapsed();
+    }
+    if (m_config.observer)
+    {
+        emit statusMessage(QString("Observing %1:%2").arg(server.host).arg(server.port));
+        return;
+    }
+
+    QString target = QString("%1:%2 (%3)").arg(server.host).arg(server.port).arg(m_config.udp ? "udp" : "tcp");
+    if (m_config.deltaThreshold <= 0)
+    {
+        emit statusMessage(QString("Sending %1 Hz to %2").arg(m_config.rateHz).arg(target));
+        if (m_rate.isEnabled())
+            emit statusMessage(QString("Adapting the rate down to %1 Hz to the link").arg(m_config.minRateHz));
+        startSending();
+        return;
+    }
+
+    emit statusMessage(QString("Sending changes of %1 or more, up to %2 Hz, to %3")
+                       .arg(m_config.deltaThreshold).arg(m_config.rateHz).arg(target));
+    if (m_rate.isEnabled())
+        emit statusMessage(QString("Adapting the rate down to %1 Hz and the threshold up to %2 to the link")
+                           .arg(m_config.minRateHz > 0 ? m_config.minRateHz : m_config.rateHz).arg(qMax(m_config.deltaThreshold, m_config.maxDeltaThreshold)));
+    startSending();
+}
+
+void JoystickSender::disconnected()
+{
+    m_linkTimer->stop();
+    // From now until back in control
+    m_reconnectedMs = 0;
+    if (isConnected(m_second))
+    {
+        emit statusMessage("Disconnected from the server, reconnecting, sending over the second path meanwhile");
+        return;
+    }
+    stopSending();
+    emit statusMessage("Disconnected from the server, reconnecting");
+}
+
+// Over whichever path is connected, again from the start after a path came back
+void JoystickSender::startSending()
+{
+    if (m_config.observer) return;
+    if (m_config.deltaThreshold <= 0)
+    {
+        m_timer->start();
+        return;
+    }
+
+    // A device signals its events, a recording is played back on the timer
+    watchDevice();
+    if (m_reader.isRecording()) m_timer->start();
+    heartbeat();
+}
+
+void JoystickSender::stopSending()
+{
+    m_timer->stop();
+    m_holdTimer->stop();
+    m_heartbeat->stop();
+    if (m_notifier) m_notifier->setEnabled(false);
+}
+
+bool JoystickSender::isConnected(const QAbstractSocket *socket) const
+{
+    return socket && socket->state() == QAbstractSocket::ConnectedState;
+}
+
+void JoystickSender::connectAttempt(const QString &host, quint16 port, int number)
+{
+    if (number == 1)
+        emit statusMessage(QString("Connecting to %1:%2").arg(host).arg(port));
+    else
+        emit statusMessage(QString("Connecting to %1:%2, attempt %3").arg(host).arg(port).arg(number));
+}
+
+// A link that dropped without a FIN or RST (Wi-Fi out of range) only shows
+// as silence, TCP would keep retransmitting for minutes
+void JoystickSender::checkLink()
+{
+    qint64 silentMs = m_clock.elapsed() - m_lastRxMs;
+    if (!m_serverPings || silentMs < m_config.linkTimeoutMs) return;
+
+    emit statusMessage(QString("Nothing from the server for %1 ms").arg(silentMs));
+    m_link->reconnect();
+}
+
+// The second path only carries copies of the frames, its replies other
+// than pings are dropped
+void JoystickSender::secondConnected()
+{
+    QByteArray frame;
+    appendHelloFrame(frame, m_config.observer ? RoleObserver : RoleController, m_config.priority, m_config.name);
+    appendPathFrame(frame, m_session, 1);
+    m_second->write(frame);
+    const Reconnector::Server &server = m_secondLink->server();
+    emit statusMessage(QString("Second path to %1:%2 (%3)").arg(server.host).arg(server.port).arg(m_config.udp ? "tcp" : "udp"));
+    if (!isConnected(m_socket)) startSending();
+}
+
+void JoystickSender::secondDisconnected()
+{
+    if (isConnected(m_socket))
+    {
+        emit statusMessage("Second path disconnected, reconnecting");
+        return;
+    }
+    stopSending();
+    emit statusMessage("Second path disconnected, reconnecting, nothing to send over");
+}
+
+void JoystickSender::drainSecond()
+{
+    for (;;)
+    {
+        QByteArray block = m_second->readAll();
+        if (block.isEmpty()) break;
+        quint64 receivedUs = monotonicUs();
+        if (!m_config.udp) m_secondIncoming.clear();
+        m_secondIncoming.append(block);
+
+        for (FrameReader::Result result; (result = m_secondIncoming.next()) != FrameReader::NeedMore; )
+            if (result == FrameReader::Frame && m_secondIncoming.header().type == FramePing)
+                answerPing(m_second, m_secondIncoming.payload(), m_secondIncoming.header().length, receivedUs);
+    }
+}
+
+void JoystickSender::readSocket()
+{
+    for (;;)
+    {
+        QByteArray block = m_socket->readAll();
+        if (block.isEmpty()) break;
+        quint64 receivedUs = monotonicUs();
+        m_lastRxMs = m_clock.elapsed();
+        if (m_config.udp) m_incoming.clear();
+        m_incoming.append(block);
+
+        for (FrameReader::Result result; (result = m_incoming.next()) != FrameReader::NeedMore; )
+        {
+            if (result != FrameReader::Frame) continue;
+            if (m_incoming.header().type == FramePing || m_incoming.header().type == FrameFeedback)
+                m_serverPings = true;
+            if (m_incoming.header().type == FramePing)
+                answerPing(m_socket, m_incoming.payload(), m_incoming.header().length, receivedUs);
+            else if (m_incoming.header().type == FrameControl)
+                showControl(m_incoming.payload(), m_incoming.header().length);
+            else if (m_incoming.header().type == FrameTelemetry)
+                showTelemetry(m_incoming.payload(), m_incoming.header().length);
+            else if (m_incoming.header().type == FrameFeedback)
+                adaptRate(m_incoming.payload(), m_incoming.header().length);
+        }
+    }
+}
+
+void JoystickSender::answerPing(QAbstractSocket *socket, const char *payload, int size, quint64 receivedUs)
+{
+    quint64 serverUs = 0;
+    if (!decodePing(payload, size, serverUs)) return;
+
+    QByteArray frame;
+    appendPongFrame(frame, serverUs, receivedUs, monotonicUs());
+    socket->write(frame);
+}
+
+void JoystickSender::showControl(const char *payload, int size)
+{
+    bool owner = false;
+    int priority = 0;
+    quint16 ownerId = 0;
+    if (!decodeControl(payload, size, owner, priority, ownerId)) return;
+
+    if (int(owner) == m_inControl && !m_config.observer) return;
+    m_inControl = owner;
+    if (owner && m_reconnectedMs > 0)
+    {
+        qint64 sinceMs = m_clock.elapsed() - m_reconnectedMs;
+        emit statusMessage(QString("Back in control %1 ms after reconnecting, %2 ms after the link dropped")
+                           .arg(sinceMs).arg(sinceMs + m_link->lastOutageMs()));
+        m_reconnectedMs = -1;
+        return;
+    }
+    if (owner)
+        emit statusMessage("In control");
+    else if (ownerId)
+        emit statusMessage(QString("Client %1 is in control, priority %2").arg(ownerId).arg(priority));
+    else
+        emit statusMessage("Nobody is in control");
+}
+
+// One line per snapshot: output state, then each input of the bridge
+void JoystickSender::showTelemetry(const char *payload, int size)
+{
+    Telemetry telemetry;
+    if (!decodeTelemetry(payload, size, telemetry)) return;
+
+    static const char *const types[] = { "net", "sbus", "crsf", "shm" };
+    QStringList channels;
+    for (int i=0; i<telemetry.count; i++) channels << QString::number(telemetry.channels[i]);
+    QString line = QString("%1 input %2 | %3").arg(telemetry.failsafe ? "FAILSAFE" : "ok")
+            .arg(telemetry.source).arg(channels.join(' '));
+
+    for (int i=0; i<telemetry.inputCount; i++)
+    {
+        const TelemetryInput &in = telemetry.inputs[i];
+        line += QString(" | %1 %2").arg(in.type < 4 ? types[in.type] : "?")
+                .arg(!(in.flags & TelemetryInput::Open) ? "closed" : (in.flags & TelemetryInput::Fresh) ? "fresh" : "stale");
+        if (in.type == TelemetryInput::Shm)
+            line += QString(" frames %1 torn %2").arg(in.goodFrames).arg(in.badFrames);
+        else if (in.type != TelemetryInput::Network)
+            line += QString(" ok %1 bad %2 lost %3 fs %4 resync %5")
+                    .arg(in.goodFrames).arg(in.badFrames).arg(in.lostFrames).arg(in.failsafes).arg(in.resyncs);
+        if (in.flags & TelemetryInput::HasLink)
+            line += QString(" rssi -%1/-%2 lq %3 snr %4 | down rssi -%5 lq %6 snr %7")
+                    .arg(in.uplinkRssi1).arg(in.uplinkRssi2).arg(in.uplinkQuality).arg(in.uplinkSnr)
+                    .arg(in.downlinkRssi).arg(in.downlinkQuality).arg(in.downlinkSnr);
+    }
+    emit statusMessage(line);
+}
+
+void JoystickSender::adaptRate(const char *payload, int size)
+{
+    Feedback feedback;
+    if (!m_rate.isEnabled() || !decodeFeedback(payload, size, feedback)) return;
+
+    QString reason;
+    switch (m_rate.update(feedback, m_framesSent, m_socket->bytesToWrite(), reason))
+    {
+    case RateControl::Unchanged:
+        return;
+    case RateControl::BackedOff:
+        if (m_config.deltaThreshold > 0)
+            emit statusMessage(QString("Backing off to %1 Hz, threshold %2: %3").arg(m_rate.rateHz()).arg(m_rate.threshold()).arg(reason));
+        else
+            emit statusMessage(QString("Backing off to %1 Hz: %2").arg(m_rate.rateHz()).arg(reason));
+        break;
+    case RateControl::SteppedUp:
+        if (m_rate.isFull())
+            emit statusMessage(QString("Link clean, back at %1 Hz").arg(m_rate.rateHz()));
+        break;
+    }
+    m_timer->setInterval(qMax(1, 1000 / m_rate.rateHz()));
+}
+
+void JoystickSender::socketError(QAbstractSocket::SocketError)
+{
+    QAbstractSocket *socket = static_cast<QAbstractSocket*>(sender());
+    emit statusMessage(QString("Socket error%1: %2").arg(socket == m_second ? " on the second path" : "").arg(socket->errorString()));
+}
+
+int JoystickSender::channelValue(int code) const
+{
+    bool reverse = code < 0;
+    if (reverse) code = -code - 1;
+
+    double position;
+    if (code & BUTTON_FLAG)
+    {
+        position = m_reader.button(code & ~BUTTON_FLAG) ? 1.0 : 0.0;
+    }
+    else
+    {
+        int min = m_reader.axisMin(code), max = m_reader.axisMax(code);
+        if (max <= min) return CHANNEL_CENTER;
+        position = double(qBound(min, m_reader.axis(code), max) - min) / (max - min);
+    }
+
+    if (reverse) position = 1.0 - position;
+    return CHANNEL_MIN + qRound(position * (CHANNEL_MAX - CHANNEL_MIN));
+}
+
+bool JoystickSender::readDevice()
+{
+    if (m_reader.isOpen() && m_reader.poll()) return true;
+
+    if (m_reader.isOpen())
+    {
+        // Hand back rather than hold the vehicle until the owner timeout
+        emit statusMessage(QString("Lost %1").arg(m_reader.name()));
+        m_reader.close();
+        m_frame.clear();
+        appendFrame(m_frame, FrameRelease, 0, nullptr, 0);
+        send(m_frame);
+    }
+
+    // Unplugged, try the device again once a second and send nothing
+    if (m_notifier) m_notifier->setEnabled(false);
+    qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    if (nowMs - m_lastReopenMs < 1000) return false;
+    m_lastReopenMs = nowMs;
+
+    QString error;
+    if (!m_reader.open(m_config.device, error)) return false;
+    emit statusMessage(QString("Reading %1").arg(m_reader.name()));
+    watchDevice();
+    return true;
+}
+
+void JoystickSender::watchDevice()
+{
+    // May be called from the old notifier's own signal
+    if (m_notifier) m_notifier->deleteLater();
+    m_notifier = nullptr;
+    if (m_config.deltaThreshold <= 0 || m_reader.fd() < 0) return;
+
+    m_notifier = new QSocketNotifier(m_reader.fd(), QSocketNotifier::Read, this);
+    connect(m_notifier, SIGNAL(activated(int)), this, SLOT(sample()));
+}
+
+void JoystickSender::tick()
+{
+    if (m_config.deltaThreshold > 0)
+    {
+        sample();
+        return;
+    }
+
+    if (!readDevice()) return;
+    for (int i=0; i<m_codes.count(); i++) m_values[i] = channelValue(m_codes.at(i));
+    sendFrame(true);
+}
+
+void JoystickSender::sample()
+{
+    if (!readDevice()) return;
+    for (int i=0; i<m_codes.count(); i++) m_values[i] = channelValue(m_codes.at(i));
+
+    // Held back changes go out with the newest values when the timer fires
+    if (!m_holdTimer->isActive()) sendChanges();
+}
+
+void JoystickSender::sendChanges()
+{
+    quint16 mask = 0;
+    for (int i=0; i<m_codes.count(); i++)
+        if (qAbs(m_values[i] - m_sent[i]) >= m_rate.threshold()) mask |= quint16(1 << i);
+    if (!mask) return;
+
+    qint64 nowMs = m_clock.elapsed();
+    qint64 waitMs = m_lastSendMs + 1000 / m_rate.rateHz() - nowMs;
+    if (waitMs > 0)
+    {
+        m_holdTimer->start(int(waitMs));
+        return;
+    }
+
+    if (nowMs - m_lastFullMs >= KEYFRAME_MS)
+        sendFrame(true);
+    else
+        sendFrame(false, mask);
+}
+
+void JoystickSender::heartbeat()
+{
+    if (!readDevice()) return;
+    for (int i=0; i<m_codes.count(); i++) m_values[i] = channelValue(m_codes.at(i));
+    sendFrame(true);
+}
+
+void JoystickSender::sendFrame(bool full, quint16 mask)
+{
+    // Stamped with the time the device was read
+    quint64 stampUs = monotonicUs();
+    m_frame.clear();
+    if (full)
+        appendChannelsFrame(m_frame, m_seq++, m_values, m_codes.count(), stampUs);
+    else
+        appendDeltaFrame(m_frame, m_seq++, m_values, mask, stampUs);
+    send(m_frame);
+    m_framesSent++;
+
+    for (int i=0; i<m_codes.count(); i++)
+        if (full || (mask & (1 << i))) m_sent[i] = m_values[i];
+
+    m_lastSendMs = m_clock.elapsed();
+    if (full) m_lastFullMs = m_lastSendMs;
+    if (m_config.deltaThreshold > 0)
+    {
+        m_holdTimer->stop();
+        m_heartbeat->start();
+    }
+}
+
+void JoystickSender::send(const QByteArray &frame)
+{
+    if (isConnected(m_socket))
+        m_socket->write(frame);
+    if (isConnected(m_second))
+        m_second->write(frame);
+}
@@ -0,0 +1,154 @@
+#ifndef JOYSTICKSENDER_H
+#define JOYSTICKSENDER_H
+
+#include <QObject>
+#include <QAbstractSocket>
+#include <QElapsedTimer>
+#include <QSocketNotifier>
+#include <QString>
+#include <QTimer>
+#include <QVector>
+#include "evdevreader.h"
+#include "joystickprotocol.h"
+#include "ratecontrol.h"
+#include "reconnector.h"
+
+struct SenderConfig
+{
+    QString host = "127.0.0.1";     // comma separated host[:port], tried in turn
+    quint16 port = 9001;
+    int reconnectMaxMs = 2000;      // longest backoff between connect attempts
+    // Reconnect after this long without data from a server known to ping,
+    // 0 waits for the socket to notice
+    int linkTimeoutMs = 1000;
+    bool udp = false;
+    QString device;             // evdev device or recorded event file
+    int rateHz = 50;
+    // One entry per channel: axis name or abs:N, btn:name or btn:N,
+    // a leading '-' reverses it
+    QString map = "x,-y,rx,-ry,z,rz,hat0x,-hat0y,"
+                  "btn:south,btn:east,btn:north,btn:west,btn:tl,btn:tr,btn:select,btn:start";
+    int recordingMin = -32768;  // axis range of a recording
+    int recordingMax = 32767;
+    bool loop = false;          // repeat a recording
+    // Above 0 a frame is sent as soon as a channel moves this many SBUS units,
+    // carrying only the changed channels, rateHz is then the highest rate
+    int deltaThreshold = 0;
+    int heartbeatMs = 100;      // full frame after this long without a frame
+    // With the server's feedback the rate drops towards minRateHz and the
+    // threshold grows towards maxDeltaThreshold on a congested link, 0 keeps
+    // them fixed
+    int minRateHz = 0;
+    int maxDeltaThreshold = 0;
+    // Announced to the server, which gives control to the highest priority
+    // controller still sending
+    bool observer = false;
+    int priority = 100;
+    QString name;
+    int telemetryHz = 0;        // telemetry snapshots per second asked from the server
+    // Also sends every frame over the other transport (UDP with TCP and the
+    // other way round) to this address of the server, the first copy wins
+    QString secondHost;
+};
+
+// Sends the gamepad state as binary channel frames at a fixed rate.
+// The device is read right before each frame is built, so a frame carries
+// the newest state and no older event queue.
+// With a delta threshold frames follow the device instead: changed channels
+// go out as delta frames when the events arrive, and a full frame is sent
+// after heartbeatMs of silence and at least once a second, so the server
+// repairs channels whose delta was lost and knows the client is alive.
+// A dropped connection is made again at once, and resumed on the server so
+// the client is back in control without waiting for the owner timeout.
+class JoystickSender : public QObject
+{
+    Q_OBJECT
+public:
+    explicit JoystickSender(const SenderConfig &config, QObject *parent = nullptr);
+
+    // False with error set if the map or the device is invalid
+    bool start(QString &error);
+
+    // Channel values in SBUS units
+    static const int CHANNEL_MIN = 172;
+    static const int CHANNEL_MAX = 1811;
+    static const int CHANNEL_CENTER = 992;
+
+    static bool parseMap(const QString &map, QVector<int> &codes, QString &error);
+
+signals:
+    void statusMessage(const QString &msg);
+
+private slots:
+    void tick();
+    void sample();
+    void sendChanges();
+    void heartbeat();
+    void readSocket();
+    void connected();
+    void disconnected();
+    void secondConnected();
+    void secondDisconnected();
+    void drainSecond();
+    void socketError(QAbstractSocket::SocketError error);
+    void connectAttempt(const QString &host, quint16 port, int number);
+    void checkLink();
+
+private:
+    bool readDevice();
+    void watchDevice();
+    int channelValue(int code) const;
+    // Sampling and frames, while either path is connected
+    void startSending();
+    void stopSending();
+    bool isConnected(const QAbstractSocket *socket) const;
+    void sendFrame(bool full, quint16 mask = 0);
+    // To the server over every connected path
+    void send(const QByteArray &frame);
+    QAbstractSocket *createSocket(bool udp);
+    void showControl(const char *payload, int size);
+    void showTelemetry(const char *payload, int size);
+    void adaptRate(const char *payload, int size);
+    // Pings give the server this clock's offset, so it can tell the age of the frames
+    void answerPing(QAbstractSocket *socket, const char *payload, int size, quint64 receivedUs);
+
+    SenderConfig m_config;
+    EvdevReader m_reader;
+    // Per channel: ABS code, or BUTTON_FLAG | KEY code, negative to reverse
+    QVector<int> m_codes;
+    QAbstractSocket *m_socket;
+    Reconnector *m_link;
+    quint32 m_resumeToken;      // the same for every connection of this process
+    QTimer *m_linkTimer;
+    qint64 m_lastRxMs;
+    bool m_serverPings;         // the server sends without being asked, its silence means a dead link
+    qint64 m_reconnectedMs;     // waiting for control since, -1 when not
+    QAbstractSocket *m_second;  // second path, null without one
+    Reconnector *m_secondLink;
+    quint32 m_session;          // pairs the paths on the server
+    QTimer *m_timer;
+    qint64 m_lastReopenMs;
+    quint32 m_seq;
+    QByteArray m_frame;
+
+    // Change driven sending
+    QSocketNotifier *m_notifier;
+    QTimer *m_holdTimer;        // sends changes held back by the rate limit
+    QTimer *m_heartbeat;
+    QElapsedTimer m_clock;
+    qint64 m_lastSendMs;
+    qint64 m_lastFullMs;
+    int m_values[FRAME_MAX_CHANNELS];
+    int m_sent[FRAME_MAX_CHANNELS];     // as the server has them
+
+    // Rate and threshold in use, adapted to the feedback
+    RateControl m_rate;
+    quint32 m_framesSent;       // channel frames on this connection
+
+    // Control frames from the server
+    FrameReader m_incoming;
+    FrameReader m_secondIncoming;
+    int m_inControl;            // -1 until the server said
+};
+
+#endif // JOYSTICKSENDER_H
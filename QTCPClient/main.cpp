@@ -1,11 +1,139 @@
 #include "mainwindow.h"
+#include "joysticksender.h"
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QScopedPointer>
+#include <QSysInfo>
+#include <QTextStream>
+#include <string.h>
 
 int main(int argc, char *argv[])
 {
-    QApplication a(argc, argv);
-    MainWindow w;
+    // The sender runs without a window (or an X session), so the kind of
+    // application is picked before the options are parsed
+    bool senderMode = false;
+    for (int i=1; i<argc; i++)
+        if (strcmp(argv[i], "--device") == 0 || strncmp(argv[i], "--device=", 9) == 0) senderMode = true;
+
+    QScopedPointer<QCoreApplication> a(senderMode ? new QCoreApplication(argc, argv) : new QApplication(argc, argv));
+
+    SenderConfig config;
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Remote joystick client");
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("host", "Server <host>, or a comma separated list of host[:port] tried in turn.", "host", config.host));
+    parser.addOption(QCommandLineOption("port", "Server <port>.", "port", QString::number(config.port)));
+    parser.addOption(QCommandLineOption("device", "Send the gamepad at evdev <path> (or a recorded event file) instead of showing the window.", "path"));
+    parser.addOption(QCommandLineOption("rate", "Frames per second sent.", "hz", QString::number(config.rateHz)));
+    parser.addOption(QCommandLineOption("map", "Comma separated axis or btn:button per channel, '-' reverses.", "list", config.map));
+    parser.addOption(QCommandLineOption("udp", "Send over UDP instead of TCP."));
+    parser.addOption(QCommandLineOption("recording-range", "Axis <min:max> of a recorded event file.", "min:max"));
+    parser.addOption(QCommandLineOption("loop", "Repeat a recorded event file."));
+    parser.addOption(QCommandLineOption("delta-threshold", "Send only changes of at least <units> as they happen, --rate is then the highest rate. 0 sends every frame.", "units", QString::number(config.deltaThreshold)));
+    parser.addOption(QCommandLineOption("priority", "Control <priority> 0-255, the highest controller still sending is in control.", "n", QString::number(config.priority)));
+    parser.addOption(QCommandLineOption("observer", "Announce as an observer, which never controls."));
+    parser.addOption(QCommandLineOption("name", "<name> shown in the server's log.", "name", QSysInfo::machineHostName()));
+    parser.addOption(QCommandLineOption("second-path", "Also send every frame over the other transport (UDP, or TCP with --udp) to <host>.", "host"));
+    parser.addOption(QCommandLineOption("telemetry", "Show the bridge's telemetry <hz> times a second.", "hz", QString::number(config.telemetryHz)));
+    parser.addOption(QCommandLineOption("min-rate", "Lower the rate down to <hz> while the server reports a congested link, 0 keeps --rate.", "hz", QString::number(config.minRateHz)));
+    parser.addOption(QCommandLineOption("max-delta-threshold", "With --delta-threshold, raise it up to <units> while the link is congested.", "units", QString::number(config.maxDeltaThreshold)));
+    parser.addOption(QCommandLineOption("reconnect-max", "Wait at most <ms> between attempts to reconnect.", "ms", QString::number(config.reconnectMaxMs)));
+    parser.addOption(QCommandLineOption("link-timeout", "Reconnect after <ms> without data from the server, 0 to wait for the socket.", "ms", QString::number(config.linkTimeoutMs)));
+    parser.addOption(QCommandLineOption("heartbeat", "With --delta-threshold, full frame after <ms> without a change.", "ms", QString::number(config.heartbeatMs)));
+    parser.process(*a);
+
+    config.host = parser.value("host");
+    config.port = quint16(parser.value("port").toUInt());
+    config.device = parser.value("device");
+    config.rateHz = parser.value("rate").toInt();
+    config.map = parser.value("map");
+    config.udp = parser.isSet("udp");
+    config.loop = parser.isSet("loop");
+    config.deltaThreshold = parser.value("delta-threshold").toInt();
+    config.heartbeatMs = parser.value("heartbeat").toInt();
+    config.reconnectMaxMs = parser.value("reconnect-max").toInt();
+    config.linkTimeoutMs = parser.value("link-timeout").toInt();
+    config.minRateHz = parser.value("min-rate").toInt();
+    config.maxDeltaThreshold = parser.value("max-delta-threshold").toInt();
+    config.priority = parser.value("priority").toInt();
+    config.observer = parser.isSet("observer");
+    config.name = parser.value("name");
+    config.telemetryHz = parser.value("telemetry").toInt();
+    config.secondHost = parser.value("second-path");
+    if (parser.isSet("recording-range"))
+    {
+        QStringList range = parser.value("recording-range").split(':');
+        if (range.count() == 2)
+        {
+            config.recordingMin = range.at(0).toInt();
+            config.recordingMax = range.at(1).toInt();
+        }
+    }
+
+    QTextStream out(stdout);
+    QList<Reconnector::Server> servers;
+    QString error;
+    if (!Reconnector::parseServers(config.host, config.port, servers, error))
+    {
+        out << error << "\n";
+        return EXIT_FAILURE;
+    }
+    if (config.reconnectMaxMs <= 0 || config.linkTimeoutMs < 0)
+    {
+        out << "The reconnect backoff must be positive and the link timeout can't be negative\n";
+        return EXIT_FAILURE;
+    }
+
+    if (senderMode)
+    {
+        if (config.rateHz <= 0 || config.rateHz > 1000)
+        {
+            out << "The rate must be 1 to 1000 Hz\n";
+            return EXIT_FAILURE;
+        }
+        if (config.minRateHz < 0 || config.minRateHz > config.rateHz)
+        {
+            out << "The minimum rate must be 0 to --rate\n";
+            return EXIT_FAILURE;
+        }
+        if (config.maxDeltaThreshold < 0 || (config.maxDeltaThreshold > 0 && config.deltaThreshold <= 0))
+        {
+            out << "The maximum delta threshold needs a delta threshold\n";
+            return EXIT_FAILURE;
+        }
+        if (config.priority < 0 || config.priority > 255)
+        {
+            out << "The priority must be 0 to 255\n";
+            return EXIT_FAILURE;
+        }
+        if (config.telemetryHz < 0 || config.telemetryHz > 1000)
+        {
+            out << "The telemetry rate must be 0 to 1000 Hz\n";
+            return EXIT_FAILURE;
+        }
+        if (config.deltaThreshold < 0 || config.heartbeatMs <= 0)
+        {
+            out << "The delta threshold can't be negative and the heartbeat must be positive\n";
+            return EXIT_FAILURE;
+        }
+
+        JoystickSender sender(config);
+        QObject::connect(&sender, &JoystickSender::statusMessage, [&out](const QString &msg) {
+            out << QDateTime::currentDateTime().toString("hh:mm:ss.zzz") << " " << msg << "\n";
+            out.flush();
+        });
+
+        if (!sender.start(error))
+        {
+            out << error << "\n";
+            return EXIT_FAILURE;
+        }
+        return a->exec();
+    }
+
+    MainWindow w(servers, config.reconnectMaxMs);
     w.show();
 
-    return a.exec();
+    return a->exec();
 }
@@ -1,7 +1,7 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 
-MainWindow::MainWindow(QWidget *parent) :
+MainWindow::MainWindow(const QList<Reconnector::Server> &servers, int reconnectMaxMs, QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::MainWindow)
 {
@@ -11,13 +11,13 @@ MainWindow::MainWindow(QWidget *parent) :
     connect(this,SIGNAL(newMessage(QString)),this,SLOT(displayMessage(QString)));
     connect(socket,SIGNAL(readyRead()),this,SLOT(readSocket()));
     connect(socket,SIGNAL(disconnected()),this,SLOT(discardSocket()));
-    socket->connectToHost(QHostAddress::LocalHost,9001);
-    if(socket->waitForConnected())
-        this->ui->statusBar->showMessage("Connected to Server");
-    else{
-        QMessageBox::critical(this,"QTCPClient", QString("The following error occurred: %1.").arg(socket->errorString()));
-        exit(EXIT_FAILURE);
-    }
+    connect(socket,SIGNAL(connected()),this,SLOT(socketConnected()));
+
+    // Connects in the background and again after every drop, the window
+    // stays usable meanwhile
+    link = new Reconnector(socket, servers, reconnectMaxMs, this);
+    connect(link, &Reconnector::attempt, this, &MainWindow::connectAttempt);
+    link->start();
 }
 
 MainWindow::~MainWindow()
@@ -45,15 +45,22 @@ void MainWindow::readSocket()
 
 void MainWindow::discardSocket()
 {
-    socket->deleteLater();
-    socket=nullptr;
-
     this->ui->statusBar->showMessage("Disconnected!");
 }
 
+void MainWindow::socketConnected()
+{
+    this->ui->statusBar->showMessage(QString("Connected to %1:%2").arg(link->server().host).arg(link->server().port));
+}
+
+void MainWindow::connectAttempt(const QString &host, quint16 port, int number)
+{
+    this->ui->statusBar->showMessage(QString("Connecting to %1:%2 (attempt %3)").arg(host).arg(port).arg(number));
+}
+
 void MainWindow::on_pushButton_sendMessage_clicked()
 {
-    if(socket)
+    if(socket->state() == QAbstractSocket::ConnectedState)
     {
         if(socket->isOpen())
         {
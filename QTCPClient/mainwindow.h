@@ -9,6 +9,7 @@
 #include <QMetaType>
 #include <QString>
 #include <QTcpSocket>
+#include "reconnector.h"
 
 namespace Ui {
 class MainWindow;
@@ -19,13 +20,15 @@ class MainWindow : public QMainWindow
     Q_OBJECT
 
 public:
-    explicit MainWindow(QWidget *parent = nullptr);
+    explicit MainWindow(const QList<Reconnector::Server> &servers, int reconnectMaxMs, QWidget *parent = nullptr);
     ~MainWindow();
 signals:
     void newMessage(QString);
 private slots:
     void readSocket();
     void discardSocket();
+    void socketConnected();
+    void connectAttempt(const QString &host, quint16 port, int number);
 
     void displayMessage(const QString& str);
     void on_pushButton_sendMessage_clicked();
@@ -33,6 +36,7 @@ private:
     Ui::MainWindow *ui;
 
     QTcpSocket* socket;
+    Reconnector *link;
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,106 @@
+#include "ratecontrol.h"
+#include <QtGlobal>
+
+// Frames this much older than the lowest recent age are queueing somewhere
+static const quint32 QUEUE_DELAY_US = 20000;
+// Unsent data in either direction that counts as a backlog
+static const qint64 QUEUED_BYTES = 4096;
+
+RateControl::RateControl() :
+    m_minHz(1), m_maxHz(1), m_minThreshold(0), m_maxThreshold(0)
+{
+    reset();
+}
+
+void RateControl::setBounds(int minHz, int maxHz, int minThreshold, int maxThreshold)
+{
+    m_maxHz = qMax(1, maxHz);
+    m_minHz = qBound(1, minHz, m_maxHz);
+    m_minThreshold = qMax(0, minThreshold);
+    m_maxThreshold = qMax(m_minThreshold, maxThreshold);
+    reset();
+}
+
+void RateControl::reset()
+{
+    m_rateHz = m_maxHz;
+    m_threshold = m_minThreshold;
+    m_hasPrevious = false;
+    m_previousSent = 0;
+    m_coolDown = false;
+    m_ageCount = 0;
+    m_ageNext = 0;
+}
+
+RateControl::Verdict RateControl::update(const Feedback &feedback, quint32 sent, qint64 localQueued, QString &reason)
+{
+    // A new connection on the server, e.g. it forgot this UDP sender
+    if (m_hasPrevious && feedback.received < m_previous.received)
+        m_hasPrevious = false;
+    if (!m_hasPrevious)
+    {
+        m_hasPrevious = true;
+        m_previous = feedback;
+        m_previousSent = sent;
+        return Unchanged;
+    }
+
+    // Counters wrap, differences don't
+    quint32 received = feedback.received - m_previous.received;
+    quint32 missed = (feedback.lost - m_previous.lost) + (feedback.late - m_previous.late);
+    quint32 coalesced = feedback.coalesced - m_previous.coalesced;
+    // Sent since the previous report but neither arrived nor known lost,
+    // more than 200 ms worth is a queue growing
+    qint64 behind = qint64(sent - m_previousSent) - qint64(received) - qint64(feedback.lost - m_previous.lost);
+    m_previous = feedback;
+    m_previousSent = sent;
+
+    quint32 queueDelayUs = 0;
+    if (feedback.ageUs != Feedback::NO_AGE)
+    {
+        m_ages[m_ageNext] = feedback.ageUs;
+        m_ageNext = (m_ageNext + 1) % AGE_HISTORY;
+        if (m_ageCount < AGE_HISTORY) m_ageCount++;
+        quint32 base = feedback.ageUs;
+        for (int i=0; i<m_ageCount; i++) base = qMin(base, m_ages[i]);
+        queueDelayUs = feedback.ageUs - base;
+    }
+
+    reason.clear();
+    if (missed > 0)
+        reason = QString("%1 frames lost or late").arg(missed);
+    else if (queueDelayUs > QUEUE_DELAY_US)
+        reason = QString("frames %1 ms later than usual").arg(queueDelayUs / 1000.0, 0, 'f', 1);
+    else if (localQueued > QUEUED_BYTES || qint64(feedback.queuedBytes) > QUEUED_BYTES)
+        reason = QString("%1 bytes queued here, %2 on the server").arg(localQueued).arg(feedback.queuedBytes);
+    else if (behind > qMax(4, m_rateHz / 5))
+        reason = QString("%1 frames more sent than arrived").arg(behind);
+
+    if (!reason.isEmpty())
+    {
+        // One step per round trip of rate change and report
+        if (m_coolDown)
+        {
+            m_coolDown = false;
+            return Unchanged;
+        }
+        int rate = qMax(m_minHz, m_rateHz * 3 / 4);
+        int threshold = qMin(m_maxThreshold, qMax(m_threshold + 1, m_threshold * 3 / 2));
+        if (rate == m_rateHz && threshold == m_threshold) return Unchanged;
+        m_rateHz = rate;
+        m_threshold = threshold;
+        m_coolDown = true;
+        return BackedOff;
+    }
+
+    m_coolDown = false;
+    // The mixer already drops frames, a higher rate would only add more
+    if (received > 0 && coalesced * 2 > received) return Unchanged;
+
+    int rate = qMin(m_maxHz, m_rateHz + qMax(1, m_maxHz / 20));
+    int threshold = qMax(m_minThreshold, m_threshold - qMax(1, (m_maxThreshold - m_minThreshold) / 10));
+    if (rate == m_rateHz && threshold == m_threshold) return Unchanged;
+    m_rateHz = rate;
+    m_threshold = threshold;
+    return SteppedUp;
+}
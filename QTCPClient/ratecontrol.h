@@ -0,0 +1,63 @@
+#ifndef RATECONTROL_H
+#define RATECONTROL_H
+
+#include <QString>
+#include "joystickprotocol.h"
+
+// Send rate and delta threshold of a sender, adapted to the server's
+// feedback with additive increase and multiplicative decrease.
+// The link counts as congested when frames were lost or came late, when
+// their age rose well above the lowest age seen lately (clock offset
+// errors cancel out, what is left is queueing) or when data piles up in
+// either direction. Then the rate drops by a quarter and the threshold
+// grows by half, and on a clean link they step back towards the full rate
+// and the finest threshold. Frames the server's mixer never saw only stop
+// the rate from growing, sending slower wouldn't help the link.
+class RateControl
+{
+public:
+    RateControl();
+
+    // The rate floats between minHz and maxHz, the threshold between
+    // minThreshold and maxThreshold, equal bounds leave it alone
+    void setBounds(int minHz, int maxHz, int minThreshold, int maxThreshold);
+    bool isEnabled() const { return m_minHz < m_maxHz || m_minThreshold < m_maxThreshold; }
+
+    // Back at the full rate, for a new connection
+    void reset();
+
+    enum Verdict
+    {
+        Unchanged,
+        BackedOff,      // reason says why
+        SteppedUp
+    };
+
+    // sent counts the channel frames sent on the connection, localQueued
+    // is what the socket still holds
+    Verdict update(const Feedback &feedback, quint32 sent, qint64 localQueued, QString &reason);
+
+    int rateHz() const { return m_rateHz; }
+    int threshold() const { return m_threshold; }
+    bool isFull() const { return m_rateHz == m_maxHz && m_threshold == m_minThreshold; }
+
+private:
+    static const int AGE_HISTORY = 16;
+
+    int m_minHz;
+    int m_maxHz;
+    int m_minThreshold;
+    int m_maxThreshold;
+    int m_rateHz;
+    int m_threshold;
+
+    bool m_hasPrevious;
+    Feedback m_previous;
+    quint32 m_previousSent;
+    bool m_coolDown;            // the next report may still show the old rate
+    quint32 m_ages[AGE_HISTORY];
+    int m_ageCount;
+    int m_ageNext;
+};
+
+#endif // RATECONTROL_H
@@ -0,0 +1,127 @@
+#include "reconnector.h"
+#include <QStringList>
+
+static const int FIRST_BACKOFF_MS = 100;
+static const int CONNECT_TIMEOUT_MS = 3000;
+// A connection that lasted this long resets the backoff
+static const int STABLE_MS = 1000;
+
+bool Reconnector::parseServers(const QString &list, quint16 defaultPort, QList<Server> &servers, QString &error)
+{
+    servers.clear();
+    foreach (QString entry, list.split(',', Qt::SkipEmptyParts))
+    {
+        entry = entry.trimmed();
+        Server server;
+        server.host = entry;
+        server.port = defaultPort;
+
+        // The last colon, unless it is part of an IPv6 address
+        int colon = entry.lastIndexOf(':');
+        if (colon > 0 && entry.indexOf(':') == colon)
+        {
+            bool ok = false;
+            uint port = entry.mid(colon + 1).toUInt(&ok);
+            if (!ok || port == 0 || port > 65535)
+            {
+                error = QString("Invalid port in '%1'").arg(entry);
+                return false;
+            }
+            server.host = entry.left(colon);
+            server.port = quint16(port);
+        }
+        servers << server;
+    }
+
+    if (servers.isEmpty())
+    {
+        error = "No server to connect to";
+        return false;
+    }
+    return true;
+}
+
+Reconnector::Reconnector(QAbstractSocket *socket, const QList<Server> &servers, int maxBackoffMs, QObject *parent) :
+    QObject(parent), m_socket(socket), m_servers(servers), m_index(-1), m_maxBackoffMs(qMax(FIRST_BACKOFF_MS, maxBackoffMs)),
+    m_backoffMs(0), m_attempts(0), m_upSinceMs(-1), m_downSinceMs(-1), m_lastOutageMs(0)
+{
+    m_retryTimer = new QTimer(this);
+    m_retryTimer->setSingleShot(true);
+    connect(m_retryTimer, &QTimer::timeout, this, &Reconnector::connectNext);
+
+    m_connectTimer = new QTimer(this);
+    m_connectTimer->setSingleShot(true);
+    m_connectTimer->setInterval(CONNECT_TIMEOUT_MS);
+    connect(m_connectTimer, &QTimer::timeout, this, &Reconnector::connectTimeout);
+
+    connect(m_socket, &QAbstractSocket::connected, this, &Reconnector::socketConnected);
+    connect(m_socket, &QAbstractSocket::disconnected, this, &Reconnector::socketDisconnected);
+    connect(m_socket, SIGNAL(error(QAbstractSocket::SocketError)), this, SLOT(socketError(QAbstractSocket::SocketError)));
+    m_clock.start();
+}
+
+void Reconnector::start()
+{
+    m_downSinceMs = m_clock.elapsed();
+    connectNext();
+}
+
+void Reconnector::reconnect()
+{
+    // A connected socket reports the drop through disconnected()
+    bool wasConnected = m_socket->state() == QAbstractSocket::ConnectedState;
+    m_socket->abort();
+    if (!wasConnected) schedule();
+}
+
+void Reconnector::connectNext()
+{
+    m_index = (m_index + 1) % m_servers.count();
+    m_attempts++;
+    emit attempt(server().host, server().port, m_attempts);
+
+    m_socket->abort();
+    m_connectTimer->start();
+    m_socket->connectToHost(server().host, server().port);
+}
+
+void Reconnector::socketConnected()
+{
+    m_connectTimer->stop();
+    m_attempts = 0;
+    m_upSinceMs = m_clock.elapsed();
+    if (m_downSinceMs >= 0) m_lastOutageMs = m_upSinceMs - m_downSinceMs;
+    m_downSinceMs = -1;
+}
+
+void Reconnector::socketDisconnected()
+{
+    qint64 now = m_clock.elapsed();
+    if (m_upSinceMs >= 0 && now - m_upSinceMs >= STABLE_MS) m_backoffMs = 0;
+    m_upSinceMs = -1;
+    if (m_downSinceMs < 0) m_downSinceMs = now;
+    schedule();
+}
+
+// Connection refused, host unreachable and the like while connecting,
+// a connected socket also reports disconnected()
+void Reconnector::socketError(QAbstractSocket::SocketError)
+{
+    if (m_socket->state() == QAbstractSocket::ConnectedState) return;
+    m_connectTimer->stop();
+    schedule();
+}
+
+void Reconnector::connectTimeout()
+{
+    m_socket->abort();
+    schedule();
+}
+
+void Reconnector::schedule()
+{
+    if (m_retryTimer->isActive()) return;
+
+    m_retryTimer->start(m_backoffMs);
+    m_backoffMs = m_backoffMs ? qMin(m_backoffMs * 2, m_maxBackoffMs) : FIRST_BACKOFF_MS;
+}
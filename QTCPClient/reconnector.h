@@ -0,0 +1,67 @@
+#ifndef RECONNECTOR_H
+#define RECONNECTOR_H
+
+#include <QObject>
+#include <QAbstractSocket>
+#include <QElapsedTimer>
+#include <QList>
+#include <QString>
+#include <QTimer>
+
+// Keeps a socket connected to one of a list of servers without blocking.
+// Each attempt goes to the next server in the list. A dropped connection is
+// retried at once, then after a backoff doubling from 100 ms up to the
+// maximum, reset by a connection that lasted a second. An attempt that
+// hasn't connected within the connect timeout is given up.
+class Reconnector : public QObject
+{
+    Q_OBJECT
+public:
+    struct Server
+    {
+        QString host;
+        quint16 port;
+    };
+
+    // Comma separated host or host:port, defaultPort without one
+    static bool parseServers(const QString &list, quint16 defaultPort, QList<Server> &servers, QString &error);
+
+    Reconnector(QAbstractSocket *socket, const QList<Server> &servers, int maxBackoffMs, QObject *parent = nullptr);
+
+    // First attempt at once
+    void start();
+    // Drops a connection that looks dead and connects again
+    void reconnect();
+
+    const Server &server() const { return m_servers.at(m_index); }
+    // How long the last outage lasted, from the drop to the new connection
+    qint64 lastOutageMs() const { return m_lastOutageMs; }
+
+signals:
+    void attempt(const QString &host, quint16 port, int number);
+
+private slots:
+    void connectNext();
+    void socketConnected();
+    void socketDisconnected();
+    void socketError(QAbstractSocket::SocketError error);
+    void connectTimeout();
+
+private:
+    void schedule();
+
+    QAbstractSocket *m_socket;
+    QList<Server> m_servers;
+    int m_index;
+    int m_maxBackoffMs;
+    int m_backoffMs;            // before the next attempt
+    int m_attempts;             // since the last connection
+    QTimer *m_retryTimer;
+    QTimer *m_connectTimer;
+    QElapsedTimer m_clock;
+    qint64 m_upSinceMs;         // -1 while not connected
+    qint64 m_downSinceMs;       // -1 while connected
+    qint64 m_lastOutageMs;
+};
+
+#endif // RECONNECTOR_H
@@ -7,6 +7,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <QtGlobal>
+#include <sbus/sbus_tty.h>
 
 unsigned long millis()
 {
@@ -15,15 +16,38 @@ unsigned long millis()
     return (ts.tv_sec * 1000 + ts.tv_nsec / 1000000L);
 }
 
-long map(long x, long in_min, long in_max, long out_min, long out_max)
+uint64_t micros()
 {
-    return (x-in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t(ts.tv_sec) * 1000000ULL + ts.tv_nsec / 1000L);
+}
+
+CrsfSerial::CrsfSerial() :
+    _port(-1), _rxBufPos(0), _crc(0xd5), _baud(CRSF_BAUDRATE),
+    _lastReceive(0), _lastChannelsPacket(0), _linkIsUp(false),
+    _passthroughMode(false),
+    _goodFrames(0), _crcErrors(0), _bytesDiscarded(0), _resyncs(0),
+    _channelFrames(0), _linkDown(0),
+    _intervalMinUs(0), _intervalMaxUs(0), _intervalSumUs(0), _intervalCount(0),
+    _inSync(false), _lastChannelsPacketUs(0)
+{
+    memset(_channels, 0, sizeof(_channels));
+}
+
+CrsfSerial::CrsfSerial(int fd) : CrsfSerial()
+{
+    _port = fd;
 }
 
 CrsfSerial::CrsfSerial(const char path[], bool blocking, uint32_t baud, uint8_t timeout) :
-     _crc(0xd5), _baud(baud),
+     _rxBufPos(0), _crc(0xd5), _baud(baud),
     _lastReceive(0), _lastChannelsPacket(0), _linkIsUp(false),
-    _passthroughMode(false)
+    _passthroughMode(false),
+    _goodFrames(0), _crcErrors(0), _bytesDiscarded(0), _resyncs(0),
+    _channelFrames(0), _linkDown(0),
+    _intervalMinUs(0), _intervalMaxUs(0), _intervalSumUs(0), _intervalCount(0),
+    _inSync(false), _lastChannelsPacketUs(0)
 {
     // Crsf serial is 420000 baud for V2
     _port = open(path, O_RDWR | O_NOCTTY | (blocking ? 0 : O_NONBLOCK));
@@ -39,6 +63,7 @@ CrsfSerial::CrsfSerial(const char path[], bool blocking, uint32_t baud, uint8_t
         _port = -1;
         return;
     }
+    tcflag_t speed = options.c_cflag & CBAUD;
 
     // sbus options
     // see man termios(3)
@@ -98,15 +123,20 @@ CrsfSerial::CrsfSerial(const char path[], bool blocking, uint32_t baud, uint8_t
 
     if (ioctl(_port, TCSETS2, &options))
     {
-        close(_port);
-        _port = -1;
-        return;
+        // Keeps the speed it had, as sbus_install() does
+        options.c_cflag = (options.c_cflag & ~CBAUD) | speed;
+        if (!sbus_is_pty(_port) || ioctl(_port, TCSETS2, &options))
+        {
+            close(_port);
+            _port = -1;
+            return;
+        }
     }
 }
 
 CrsfSerial::~CrsfSerial()
 {
-    if (_port>0) close(_port);
+    if (_port>=0) close(_port);
 }
 
 // Call from main loop to update
@@ -117,9 +147,32 @@ void CrsfSerial::loop()
 
 void CrsfSerial::handleSerialIn()
 {
-    uint8_t b;
-    while (read(_port,&b,1)>0)
+    uint8_t buf[64];
+    ssize_t n;
+    while ((n = read(_port, buf, sizeof(buf))) > 0)
+    {
+        if (onRawBytes)
+            onRawBytes(buf, size_t(n));
+        processBytes(buf, size_t(n));
+    }
+
+    checkPacketTimeout();
+    checkLinkDown();
+}
+
+void CrsfSerial::feed(const uint8_t *buf, size_t len)
+{
+    processBytes(buf, len);
+
+    checkPacketTimeout();
+    checkLinkDown();
+}
+
+void CrsfSerial::processBytes(const uint8_t *buf, size_t len)
+{
+    for (size_t i=0; i<len; i++)
     {
+        uint8_t b = buf[i];
         _lastReceive = millis();
 
         if (_passthroughMode)
@@ -135,12 +188,11 @@ void CrsfSerial::handleSerialIn()
         if (_rxBufPos == (sizeof(_rxBuf)/sizeof(_rxBuf[0])))
         {
             // Packet buffer filled and no valid packet found, dump the whole thing
+            bump(_bytesDiscarded, _rxBufPos);
+            countResync();
             _rxBufPos = 0;
         }
     }
-
-    checkPacketTimeout();
-    checkLinkDown();
 }
 
 void CrsfSerial::handleByteReceived()
@@ -155,6 +207,8 @@ void CrsfSerial::handleByteReceived()
             // Sanity check the declared length, can't be shorter than Type, X, CRC
             if (len < 3 || len > CRSF_MAX_PACKET_LEN)
             {
+                bump(_bytesDiscarded);
+                countResync();
                 shiftRxBuffer(1);
                 reprocess = true;
             }
@@ -165,12 +219,17 @@ void CrsfSerial::handleByteReceived()
                 uint8_t crc = _crc.calc(&_rxBuf[2], len - 1);
                 if (crc == inCrc)
                 {
+                    bump(_goodFrames);
+                    _inSync = true;
                     processPacketIn(len);
                     shiftRxBuffer(len + 2);
                     reprocess = true;
                 }
                 else
                 {
+                    bump(_crcErrors);
+                    bump(_bytesDiscarded);
+                    countResync();
                     shiftRxBuffer(1);
                     reprocess = true;
                 }
@@ -183,8 +242,11 @@ void CrsfSerial::checkPacketTimeout()
 {
     // If we haven't received data in a long time, flush the buffer a byte at a time (to trigger shiftyByte)
     if (_rxBufPos > 0 && millis() - _lastReceive > CRSF_PACKET_TIMEOUT_MS)
+    {
+        bump(_bytesDiscarded, _rxBufPos);
         while (_rxBufPos)
             shiftRxBuffer(1);
+    }
 }
 
 void CrsfSerial::checkLinkDown()
@@ -194,6 +256,7 @@ void CrsfSerial::checkLinkDown()
         if (onLinkDown)
             onLinkDown();
         _linkIsUp = false;
+        bump(_linkDown);
     }
 }
 
@@ -257,13 +320,11 @@ void CrsfSerial::packetChannelsPacked(const crsf_header_t *p)
     _channels[14] = ch->ch14;
     _channels[15] = ch->ch15;
 
-    for (unsigned int i=0; i<4; ++i)
-        _channels[i] = map(_channels[i], CRSF_CHANNEL_VALUE_MIN, CRSF_CHANNEL_VALUE_MAX, CRSF_CHANNEL_VALUE_1000, CRSF_CHANNEL_VALUE_2000);
-
     if (!_linkIsUp && onLinkUp)
         onLinkUp();
     _linkIsUp = true;
     _lastChannelsPacket = millis();
+    countChannelInterval(micros());
 
     if (onPacketChannels)
         onPacketChannels();
@@ -296,8 +357,17 @@ void CrsfSerial::queuePacket(uint8_t addr, uint8_t type, const void *payload, ui
         return;
     if (_passthroughMode)
         return;
+
+    // Busywait until the serial port seems free
+    //while (millis() - _lastReceive < 2)
+    //    loop();
+    writePacket(addr, type, payload, len);
+}
+
+bool CrsfSerial::writePacket(uint8_t addr, uint8_t type, const void *payload, uint8_t len)
+{
     if (len > CRSF_MAX_PACKET_LEN)
-        return;
+        return false;
 
     uint8_t buf[CRSF_MAX_PACKET_LEN+4];
     buf[0] = addr;
@@ -306,10 +376,7 @@ void CrsfSerial::queuePacket(uint8_t addr, uint8_t type, const void *payload, ui
     memcpy(&buf[3], payload, len);
     buf[len+3] = _crc.calc(&buf[2], len + 1);
 
-    // Busywait until the serial port seems free
-    //while (millis() - _lastReceive < 2)
-    //    loop();
-    write(buf, len + 4);
+    return ::write(_port, buf, len + 4) == ssize_t(len + 4);
 }
 
 void CrsfSerial::setPassthroughMode(bool val, unsigned int baud)
@@ -317,3 +384,55 @@ void CrsfSerial::setPassthroughMode(bool val, unsigned int baud)
     _passthroughMode = val;
     Q_UNUSED(baud);
 }
+
+void CrsfSerial::bump(std::atomic<uint32_t> &counter, uint32_t n)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+void CrsfSerial::countResync()
+{
+    if (_inSync)
+    {
+        bump(_resyncs);
+        _inSync = false;
+    }
+}
+
+void CrsfSerial::countChannelInterval(uint64_t nowUs)
+{
+    bump(_channelFrames);
+
+    if (_lastChannelsPacketUs != 0)
+    {
+        uint64_t us = nowUs - _lastChannelsPacketUs;
+        uint32_t interval = us > UINT32_MAX ? UINT32_MAX : uint32_t(us);
+
+        uint32_t count = _intervalCount.load(std::memory_order_relaxed);
+        if (count == 0 || interval < _intervalMinUs.load(std::memory_order_relaxed))
+            _intervalMinUs.store(interval, std::memory_order_relaxed);
+        if (interval > _intervalMaxUs.load(std::memory_order_relaxed))
+            _intervalMaxUs.store(interval, std::memory_order_relaxed);
+        _intervalSumUs.store(_intervalSumUs.load(std::memory_order_relaxed) + interval, std::memory_order_relaxed);
+        _intervalCount.store(count + 1, std::memory_order_relaxed);
+    }
+
+    _lastChannelsPacketUs = nowUs;
+}
+
+crsfSerialStats_t CrsfSerial::getStats() const
+{
+    crsfSerialStats_t s;
+    s.goodFrames = _goodFrames.load(std::memory_order_relaxed);
+    s.crcErrors = _crcErrors.load(std::memory_order_relaxed);
+    s.bytesDiscarded = _bytesDiscarded.load(std::memory_order_relaxed);
+    s.resyncs = _resyncs.load(std::memory_order_relaxed);
+    s.channelFrames = _channelFrames.load(std::memory_order_relaxed);
+    s.linkDown = _linkDown.load(std::memory_order_relaxed);
+
+    uint32_t count = _intervalCount.load(std::memory_order_relaxed);
+    s.intervalMinUs = count ? _intervalMinUs.load(std::memory_order_relaxed) : 0;
+    s.intervalMaxUs = count ? _intervalMaxUs.load(std::memory_order_relaxed) : 0;
+    s.intervalMeanUs = count ? uint32_t(_intervalSumUs.load(std::memory_order_relaxed) / count) : 0;
+    return s;
+}
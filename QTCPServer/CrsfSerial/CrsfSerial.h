@@ -1,12 +1,27 @@
 #pragma once
 
 #include <QObject>
+#include <atomic>
 #include <functional>
 #include <crc8.h>
 #include "crsf_protocol.h"
 
 enum eFailsafeAction { fsaNoPulses, fsaHold };
 
+// Snapshot of the parser health counters, cumulative since the port was opened
+typedef struct crsfSerialStats_s
+{
+    uint32_t goodFrames;      // frames with a valid CRC
+    uint32_t crcErrors;       // frames with a plausible length but bad CRC
+    uint32_t bytesDiscarded;  // bytes dropped while searching for a frame
+    uint32_t resyncs;         // times a locked stream lost frame alignment
+    uint32_t channelFrames;   // RC channel frames handled
+    uint32_t linkDown;        // link down (failsafe stage 1) events
+    uint32_t intervalMinUs;   // time between RC channel frames
+    uint32_t intervalMeanUs;
+    uint32_t intervalMaxUs;
+} crsfSerialStats_t;
+
 class CrsfSerial : public QObject
 {
     Q_OBJECT
@@ -15,21 +30,33 @@ public:
     static const unsigned int CRSF_PACKET_TIMEOUT_MS = 100;
     static const unsigned int CRSF_FAILSAFE_STAGE1_MS = 300;
 
+    // Without a port, bytes are only parsed through feed()
+    CrsfSerial();
+    // Takes over an open descriptor, e.g. a pty master, and closes it when done
+    explicit CrsfSerial(int fd);
     CrsfSerial(const char path[], bool blocking, uint32_t baud = CRSF_BAUDRATE, uint8_t timeout = 0);
     ~CrsfSerial();
 
     void loop();
-    bool isPortOpen() { return _port>0; }
+    // Parse bytes that did not come from the port, e.g. a recording
+    void feed(const uint8_t *buf, size_t len);
+    bool isPortOpen() { return _port>=0; }
+    // Readable when loop() has bytes to parse, -1 without a port
+    int portFd() const { return _port; }
     void write(uint8_t b);
     void write(const uint8_t *buf, size_t len);
     void queuePacket(uint8_t addr, uint8_t type, const void *payload, uint8_t len);
+    // Writes a frame regardless of link state, for using the port as an output
+    bool writePacket(uint8_t addr, uint8_t type, const void *payload, uint8_t len);
 
-    // Return current channel value (1-based) in us
+    // Return current channel value (1-based), raw CRSF units (172..1811)
     int getChannel(unsigned int ch) const { return _channels[ch - 1]; }
     const crsfLinkStatistics_t *getLinkStatistics() const { return &_linkStatistics; }
     bool isLinkUp() const { return _linkIsUp; }
     bool getPassthroughMode() const { return _passthroughMode; }
     void setPassthroughMode(bool val, unsigned int baud = 0);
+    // Lock free, may be called from any thread while loop() is running
+    crsfSerialStats_t getStats() const;
 
     // Event Handlers
     std::function<void()> onLinkUp;
@@ -37,6 +64,8 @@ public:
     std::function<void(uint8_t)> onShiftyByte;
     std::function<void()> onPacketChannels;
     std::function<void(crsfLinkStatistics_t *)> onPacketLinkStatistics;
+    // Raw bytes of every port read, before they are parsed
+    std::function<void(const uint8_t *, size_t)> onRawBytes;
 
 signals:
     void OnPacket();
@@ -54,7 +83,26 @@ private:
     bool _passthroughMode;
     int _channels[CRSF_NUM_CHANNELS];
 
+    // Only written from the thread calling loop(), relaxed load/store is enough
+    std::atomic<uint32_t> _goodFrames;
+    std::atomic<uint32_t> _crcErrors;
+    std::atomic<uint32_t> _bytesDiscarded;
+    std::atomic<uint32_t> _resyncs;
+    std::atomic<uint32_t> _channelFrames;
+    std::atomic<uint32_t> _linkDown;
+    std::atomic<uint32_t> _intervalMinUs;
+    std::atomic<uint32_t> _intervalMaxUs;
+    std::atomic<uint64_t> _intervalSumUs;
+    std::atomic<uint32_t> _intervalCount;
+    bool _inSync;
+    uint64_t _lastChannelsPacketUs;
+
+    static void bump(std::atomic<uint32_t> &counter, uint32_t n = 1);
+    void countResync();
+    void countChannelInterval(uint64_t nowUs);
+
     void handleSerialIn();
+    void processBytes(const uint8_t *buf, size_t len);
     void handleByteReceived();
     void shiftRxBuffer(uint8_t cnt);
     void processPacketIn(uint8_t len);
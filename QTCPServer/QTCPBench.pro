@@ -0,0 +1,28 @@
+#-------------------------------------------------
+#
+# Latency and throughput bench on pseudo terminals, no UART needed
+#
+#-------------------------------------------------
+
+QT       += core network
+QT       -= gui
+
+TARGET = QTCPBench
+TEMPLATE = app
+
+CONFIG+=sdk_no_version_check
+CONFIG += console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+CONFIG += c++11
+
+include(engine.pri)
+
+SOURCES += \
+        benchutil.cpp \
+        main_bench.cpp
+
+HEADERS += \
+        benchutil.h
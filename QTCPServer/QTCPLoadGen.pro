@@ -0,0 +1,28 @@
+#-------------------------------------------------
+#
+# Load generator for the network inputs, many clients at high rates
+#
+#-------------------------------------------------
+
+QT       += core network
+QT       -= gui
+
+TARGET = QTCPLoadGen
+TEMPLATE = app
+
+CONFIG+=sdk_no_version_check
+CONFIG += console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+CONFIG += c++11
+
+include(engine.pri)
+
+SOURCES += \
+        benchutil.cpp \
+        main_loadgen.cpp
+
+HEADERS += \
+        benchutil.h
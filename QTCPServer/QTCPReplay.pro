@@ -0,0 +1,28 @@
+#-------------------------------------------------
+#
+# Replays recordings made with QTCPServer --record
+#
+#-------------------------------------------------
+
+QT       += core network
+QT       -= gui
+
+TARGET = QTCPReplay
+TEMPLATE = app
+
+CONFIG+=sdk_no_version_check
+CONFIG += console
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+CONFIG += c++11
+
+include(engine.pri)
+
+SOURCES += \
+        benchutil.cpp \
+        main_replay.cpp
+
+HEADERS += \
+        benchutil.h
@@ -26,32 +26,18 @@ DEFINES += QT_DEPRECATED_WARNINGS
 
 CONFIG += c++11
 
+include(engine.pri)
+
 SOURCES += \
         main.cpp \
-    mainwindow.cpp \
-    qsbusthreadworker.cpp \
-    CrsfSerial/CrsfSerial.cpp \
-    crc8/crc8.cpp
+    mainwindow.cpp
 
 HEADERS += \
-    mainwindow.h \
-    qsbusthreadworker.h \
-    CrsfSerial/crsf_protocol.h \
-    CrsfSerial/CrsfSerial.h \
-    crc8/crc8.h
+    mainwindow.h
 
 FORMS += \
     mainwindow.ui
 
-INCLUDEPATH += $$PWD/raspberry-sbus/src/driver/include
-INCLUDEPATH += $$PWD/raspberry-sbus/src/common/include
-INCLUDEPATH += $$PWD/raspberry-sbus/src/decoder/include
-INCLUDEPATH += $$PWD/raspberry-sbus/src/tty/include
-INCLUDEPATH += $$PWD/CrsfSerial
-INCLUDEPATH += $$PWD/crc8
-
-LIBS += -L$$PWD/raspberry-sbus/build/debug/src -llibsbus
-
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
 else: unix:!android: target.path = /opt/$${TARGET}/bin
@@ -0,0 +1,141 @@
+#include "benchutil.h"
+#include <QtGlobal>
+#include <QCommandLineParser>
+#include <QSettings>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <SBUS.h>
+#include "bridgeconfig.h"
+#include "monotime.h"
+#include "sbus/packet_decoder.h"
+
+int decodeSeq(int value)
+{
+    int slot = qRound(double(value - SEQ_BASE) / SEQ_STEP);
+    return slot >= 0 && slot < SEQ_SLOTS ? slot : -1;
+}
+
+bool Pty::open()
+{
+    master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (master < 0 || grantpt(master) || unlockpt(master))
+        return false;
+
+    const char *name = ptsname(master);
+    slave = ::open(name, O_RDWR | O_NOCTTY);
+    if (slave < 0)
+        return false;
+
+    // Raw until the bridge configures it, no echo back into the master
+    struct termios t;
+    tcgetattr(slave, &t);
+    cfmakeraw(&t);
+    tcsetattr(slave, TCSANOW, &t);
+
+    port = QString(name).mid(5);
+    return true;
+}
+
+Pty::~Pty()
+{
+    if (slave >= 0) ::close(slave);
+    if (master >= 0) ::close(master);
+}
+
+void writeSbus(int fd, const int *values)
+{
+    sbus_packet_t packet;
+    packet.failsafe = false;
+    packet.frameLost = false;
+    packet.ch17 = false;
+    packet.ch18 = false;
+    for (int i=0; i<SBUS_NUM_CHANNELS; i++) packet.channels[i] = uint16_t(values[i]);
+
+    uint8_t buf[SBUS_PACKET_SIZE];
+    sbus_encode(buf, &packet);
+    if (::write(fd, buf, sizeof(buf)) != ssize_t(sizeof(buf))) {}
+}
+
+int connectClient(bool udp, quint32 address, quint16 port)
+{
+    int fd = ::socket(AF_INET, udp ? SOCK_DGRAM : SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    int one = 1;
+    if (!udp) setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(address);
+    if (::connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0)
+    {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void sleepUntil(qint64 ns)
+{
+    struct timespec ts;
+    ts.tv_sec = time_t(ns / 1000000000);
+    ts.tv_nsec = long(ns % 1000000000);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) != 0) {}
+}
+
+bool loadConfig(const QCommandLineParser &parser, BridgeConfig &config, QString &error)
+{
+    if (parser.isSet("config"))
+    {
+        QSettings settings(parser.value("config"), QSettings::IniFormat);
+        config.load(settings);
+    }
+    return config.applyOptions(parser, error);
+}
+
+void SbusReceiver::run(int fd, const std::atomic<bool> &running, const std::atomic<qint64> *sentNs)
+{
+    SBUS sbus;
+    sbus_frame_t frames[SBUS::MAX_FRAMES_PER_READ];
+    uint8_t buf[256];
+    int lastSlot = -1;
+
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    while (running.load(std::memory_order_relaxed))
+    {
+        if (poll(&pfd, 1, 100) <= 0) continue;
+        ssize_t n = ::read(fd, buf, sizeof(buf));
+        qint64 now = monotonicNs();
+        if (n <= 0) continue;
+
+        int nFrames = 0;
+        sbus.decode(buf, int(n), frames, SBUS::MAX_FRAMES_PER_READ, &nFrames);
+        for (int i=0; i<nFrames; i++)
+        {
+            packets.fetch_add(1, std::memory_order_relaxed);
+            int slot = decodeSeq(frames[i].packet.channels[0]);
+            if (slot < 0 || slot == lastSlot || frames[i].packet.failsafe) continue;
+            lastSlot = slot;
+
+            qint64 sentAt = sentNs[slot].load(std::memory_order_acquire);
+            if (sentAt == 0 || now - sentAt > msToNs(1000))
+            {
+                stale.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            latency.record(now - sentAt);
+            updates.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef BENCHUTIL_H
+#define BENCHUTIL_H
+
+#include <QString>
+#include <atomic>
+#include "latency.h"
+
+class QCommandLineParser;
+struct BridgeConfig;
+
+// Shared by the bench and the load generator, which both run the bridge
+// with its SBUS output on a pseudo terminal and time frames through it,
+// and by the replay tool.
+
+// Channel 1 of a measured frame carries a sequence number, in steps that
+// survive the unit conversions of the pipeline
+static const int SEQ_SLOTS = 100;
+static const int SEQ_BASE = 172;
+static const int SEQ_STEP = 16;
+static const int CENTER = 992;
+
+inline int encodeSeq(quint32 seq)
+{
+    return SEQ_BASE + int(seq % SEQ_SLOTS) * SEQ_STEP;
+}
+
+// Slot of a channel value, -1 if it doesn't carry one
+int decodeSeq(int value);
+
+struct Pty
+{
+    int master = -1;
+    int slave = -1;     // held open so the pty survives the bridge reopening it
+    QString port;       // slave name relative to /dev/, e.g. pts/3
+
+    bool open();
+    ~Pty();
+};
+
+// One SBUS packet with values[0..15]
+void writeSbus(int fd, const int *values);
+
+// Blocking connect to an IPv4 address in host byte order, -1 on failure
+int connectClient(bool udp, quint32 address, quint16 port);
+
+void sleepUntil(qint64 ns);
+
+// Settings from --config and the command line only, the user settings would
+// make runs depend on whoever ran the bridge last. False with error set.
+bool loadConfig(const QCommandLineParser &parser, BridgeConfig &config, QString &error);
+
+// Decoded SBUS output of the bridge, one latency sample per new sequence
+// number seen. When frames come faster than the mixer ticks most are
+// replaced by a newer one before the next tick, those are never seen.
+struct SbusReceiver
+{
+    std::atomic<quint64> packets;
+    std::atomic<quint64> updates;   // new sequence numbers with a known send time
+    std::atomic<quint64> stale;     // sequence numbers not sent within the last second
+    LatencyHistogram latency;
+
+    SbusReceiver() : packets(0), updates(0), stale(0) {}
+
+    // Reads the pty master fd until running is cleared, sentNs holds the
+    // send time of each sequence slot
+    void run(int fd, const std::atomic<bool> &running, const std::atomic<qint64> *sentNs);
+};
+
+#endif // BENCHUTIL_H
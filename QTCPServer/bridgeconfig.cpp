@@ -0,0 +1,393 @@
+#include "bridgeconfig.h"
+
+void BridgeConfig::load(QSettings &settings)
+{
+    tcpPort = quint16(settings.value("TcpPort", tcpPort).toUInt());
+    serialPort = settings.value("SerialPort", serialPort).toString();
+    serialPort2 = settings.value("SerialPort2", serialPort2).toString();
+    parseSecondaryType(settings.value("SecondaryType", secondaryTypeName(secondaryType)).toString(), secondaryType);
+    sources = settings.value("Sources", sources).toStringList();
+    sinks = settings.value("Sinks", sinks).toStringList();
+    mixerTickMs = settings.value("MixerTickMs", mixerTickMs).toInt();
+    RealtimeConfig::parse(settings.value("MixerRt", mixerRt.toString()).toString(), mixerRt);
+    RealtimeConfig::parse(settings.value("NetworkRt", networkRt.toString()).toString(), networkRt);
+    lockMemory = settings.value("LockMemory", lockMemory).toBool();
+    prefaultStackKb = settings.value("PrefaultStackKb", prefaultStackKb).toInt();
+    ChannelPipeline::parseUnit(settings.value("NetworkUnit", ChannelPipeline::unitName(networkUnit)).toString(), networkUnit);
+    primaryTimeoutMs = settings.value("PrimaryTimeoutMs", primaryTimeoutMs).toInt();
+    secondaryTimeoutMs = settings.value("SecondaryTimeoutMs", secondaryTimeoutMs).toInt();
+    failsafeDelayMs = settings.value("FailsafeDelayMs", failsafeDelayMs).toInt();
+    shmTimeoutMs = settings.value("ShmTimeoutMs", shmTimeoutMs).toInt();
+    forwardOnReceive = settings.value("ForwardOnReceive", forwardOnReceive).toBool();
+    outputSpacingUs = settings.value("OutputSpacingUs", outputSpacingUs).toInt();
+    ownerTimeoutMs = settings.value("OwnerTimeoutMs", ownerTimeoutMs).toInt();
+    requireHello = settings.value("RequireHello", requireHello).toBool();
+    sendQueueKb = settings.value("SendQueueKb", sendQueueKb).toInt();
+    clientStallMs = settings.value("ClientStallMs", clientStallMs).toInt();
+    pingIntervalMs = settings.value("PingIntervalMs", pingIntervalMs).toInt();
+    maxFrameAgeMs = settings.value("MaxFrameAgeMs", maxFrameAgeMs).toInt();
+    feedbackIntervalMs = settings.value("FeedbackIntervalMs", feedbackIntervalMs).toInt();
+    guiRefreshHz = settings.value("GuiRefreshHz", guiRefreshHz).toInt();
+    telemetryHz = settings.value("TelemetryHz", telemetryHz).toInt();
+    logFile = settings.value("LogFile", logFile).toString();
+    logRateLimitMs = settings.value("LogRateLimitMs", logRateLimitMs).toInt();
+    logViewLines = settings.value("LogViewLines", logViewLines).toInt();
+    latencyReportS = settings.value("LatencyReportS", latencyReportS).toInt();
+    recordFile = settings.value("RecordFile", recordFile).toString();
+    recordSizeMb = settings.value("RecordSizeMb", recordSizeMb).toInt();
+
+    for (int i=0; i<channels.count(); i++)
+    {
+        ChannelTransform &t = channels[i];
+        settings.beginGroup(QString("Channel%1").arg(i + 1));
+        t.input = settings.value("Input", t.input + 1).toInt() - 1;
+        t.reverse = settings.value("Reverse", t.reverse).toBool();
+        t.deadband = settings.value("Deadband", t.deadband).toInt();
+        t.expo = settings.value("Expo", t.expo).toDouble();
+        t.endpointLow = settings.value("EndpointLow", t.endpointLow).toInt();
+        t.endpointHigh = settings.value("EndpointHigh", t.endpointHigh).toInt();
+        t.trim = settings.value("Trim", t.trim).toInt();
+        t.minUs = settings.value("MinUs", t.minUs).toInt();
+        t.maxUs = settings.value("MaxUs", t.maxUs).toInt();
+        settings.endGroup();
+    }
+}
+
+void BridgeConfig::save(QSettings &settings) const
+{
+    settings.setValue("TcpPort", tcpPort);
+    settings.setValue("SerialPort", serialPort);
+    settings.setValue("SerialPort2", serialPort2);
+    settings.setValue("SecondaryType", secondaryTypeName(secondaryType));
+    settings.setValue("Sources", sources);
+    settings.setValue("Sinks", sinks);
+    settings.setValue("MixerTickMs", mixerTickMs);
+    settings.setValue("MixerRt", mixerRt.toString());
+    settings.setValue("NetworkRt", networkRt.toString());
+    settings.setValue("LockMemory", lockMemory);
+    settings.setValue("PrefaultStackKb", prefaultStackKb);
+    settings.setValue("NetworkUnit", ChannelPipeline::unitName(networkUnit));
+    settings.setValue("PrimaryTimeoutMs", primaryTimeoutMs);
+    settings.setValue("SecondaryTimeoutMs", secondaryTimeoutMs);
+    settings.setValue("FailsafeDelayMs", failsafeDelayMs);
+    settings.setValue("ShmTimeoutMs", shmTimeoutMs);
+    settings.setValue("ForwardOnReceive", forwardOnReceive);
+    settings.setValue("OutputSpacingUs", outputSpacingUs);
+    settings.setValue("OwnerTimeoutMs", ownerTimeoutMs);
+    settings.setValue("RequireHello", requireHello);
+    settings.setValue("SendQueueKb", sendQueueKb);
+    settings.setValue("ClientStallMs", clientStallMs);
+    settings.setValue("PingIntervalMs", pingIntervalMs);
+    settings.setValue("MaxFrameAgeMs", maxFrameAgeMs);
+    settings.setValue("FeedbackIntervalMs", feedbackIntervalMs);
+    settings.setValue("GuiRefreshHz", guiRefreshHz);
+    settings.setValue("TelemetryHz", telemetryHz);
+    settings.setValue("LogFile", logFile);
+    settings.setValue("LogRateLimitMs", logRateLimitMs);
+    settings.setValue("LogViewLines", logViewLines);
+    settings.setValue("LatencyReportS", latencyReportS);
+    settings.setValue("RecordFile", recordFile);
+    settings.setValue("RecordSizeMb", recordSizeMb);
+
+    for (int i=0; i<channels.count(); i++)
+    {
+        const ChannelTransform &t = channels.at(i);
+        settings.beginGroup(QString("Channel%1").arg(i + 1));
+        settings.setValue("Input", t.input + 1);
+        settings.setValue("Reverse", t.reverse);
+        settings.setValue("Deadband", t.deadband);
+        settings.setValue("Expo", t.expo);
+        settings.setValue("EndpointLow", t.endpointLow);
+        settings.setValue("EndpointHigh", t.endpointHigh);
+        settings.setValue("Trim", t.trim);
+        settings.setValue("MinUs", t.minUs);
+        settings.setValue("MaxUs", t.maxUs);
+        settings.endGroup();
+    }
+    settings.sync();
+}
+
+void BridgeConfig::addOptions(QCommandLineParser &parser)
+{
+    parser.addOption(QCommandLineOption("config", "Read settings from an ini <file> instead of the user settings.", "file"));
+    parser.addOption(QCommandLineOption("port", "TCP <port> to listen on.", "port"));
+    parser.addOption(QCommandLineOption("sbus-port", "SBUS output <tty>, e.g. ttyAMA1.", "tty"));
+    parser.addOption(QCommandLineOption("secondary-port", "Secondary input <tty>, e.g. ttyAMA3.", "tty"));
+    parser.addOption(QCommandLineOption("secondary-type", "Secondary input <type>: none, sbus or crsf.", "type"));
+    parser.addOption(QCommandLineOption("sources", "Comma separated mixer inputs, highest priority first, e.g. tcp,crsf:ttyAMA3,sbus:ttyAMA2.", "list"));
+    parser.addOption(QCommandLineOption("sinks", "Comma separated mixer outputs, e.g. sbus:ttyAMA1,crsf:ttyUSB0.", "list"));
+    parser.addOption(QCommandLineOption("mixer-tick", "Mixer period in <ms>.", "ms"));
+    parser.addOption(QCommandLineOption("mixer-rt", "Mixer thread scheduling <spec>, policy[:priority][@cpus], e.g. fifo:80@3.", "spec"));
+    parser.addOption(QCommandLineOption("network-rt", "Network thread scheduling <spec>, e.g. rr:50@2.", "spec"));
+    parser.addOption(QCommandLineOption("mlock", "Lock all memory with mlockall() at startup."));
+    parser.addOption(QCommandLineOption("network-unit", "<unit> of the channel values clients send: sbus, crsf or us.", "unit"));
+    parser.addOption(QCommandLineOption("channel-map", "Comma separated input channel (1 based) for each output channel, e.g. 2,1,3,4.", "list"));
+    parser.addOption(QCommandLineOption("primary-timeout", "Network input is stale after <ms> without an update.", "ms"));
+    parser.addOption(QCommandLineOption("secondary-timeout", "Secondary input is stale after <ms> without an update.", "ms"));
+    parser.addOption(QCommandLineOption("failsafe-delay", "Hold the last values for <ms> after both inputs went stale, then set failsafe.", "ms"));
+    parser.addOption(QCommandLineOption("shm-timeout", "Shared memory inputs are stale after <ms> without a heartbeat.", "ms"));
+    parser.addOption(QCommandLineOption("forward", "Write each new input frame to the outputs at once, the mixer tick only keeps them alive."));
+    parser.addOption(QCommandLineOption("output-spacing", "With --forward, write the outputs at most every <us>.", "us"));
+    parser.addOption(QCommandLineOption("owner-timeout", "A controlling client loses control after <ms> without a frame.", "ms"));
+    parser.addOption(QCommandLineOption("require-hello", "Clients that don't announce themselves as controller only observe."));
+    parser.addOption(QCommandLineOption("send-queue", "Queue up to <kb> of outbound data per client, then drop the oldest telemetry.", "kb"));
+    parser.addOption(QCommandLineOption("client-stall", "Disconnect a client that hasn't taken its queued data for <ms>, 0 never.", "ms"));
+    parser.addOption(QCommandLineOption("ping-interval", "Ping announced clients every <ms> to track their clock offset, 0 to disable.", "ms"));
+    parser.addOption(QCommandLineOption("max-frame-age", "Drop channel frames older than <ms> when they arrive, 0 keeps all.", "ms"));
+    parser.addOption(QCommandLineOption("feedback-interval", "Tell each sender every <ms> how its frames arrived, so it can adapt its rate, 0 to disable.", "ms"));
+    parser.addOption(QCommandLineOption("gui-refresh", "Channel display refresh rate in <hz>, 0 to disable.", "hz"));
+    parser.addOption(QCommandLineOption("telemetry-rate", "Telemetry broadcast rate to subscribed clients in <hz>, 0 to disable.", "hz"));
+    parser.addOption(QCommandLineOption("log-file", "Also append status messages to <file>.", "file"));
+    parser.addOption(QCommandLineOption("latency-report", "Log per stage latency percentiles every <s> seconds, 0 only on exit.", "s"));
+    parser.addOption(QCommandLineOption("log-rate-limit", "Minimum <ms> between repeated error messages, 0 to disable.", "ms"));
+    parser.addOption(QCommandLineOption("record", "Record all raw input to <file> for the replay tool.", "file"));
+    parser.addOption(QCommandLineOption("record-size", "Recording capacity in <mb>.", "mb"));
+}
+
+bool BridgeConfig::applyOptions(const QCommandLineParser &parser, QString &error)
+{
+    if (parser.isSet("port"))
+    {
+        bool ok = false;
+        uint port = parser.value("port").toUInt(&ok);
+        if (!ok || port == 0 || port > 65535)
+        {
+            error = QString("Invalid port '%1'").arg(parser.value("port"));
+            return false;
+        }
+        tcpPort = quint16(port);
+    }
+
+    if (parser.isSet("sbus-port"))
+        serialPort = parser.value("sbus-port");
+
+    if (parser.isSet("secondary-port"))
+        serialPort2 = parser.value("secondary-port");
+
+    if (parser.isSet("secondary-type") && !parseSecondaryType(parser.value("secondary-type"), secondaryType))
+    {
+        error = QString("Invalid secondary type '%1'").arg(parser.value("secondary-type"));
+        return false;
+    }
+
+    if (parser.isSet("sources"))
+    {
+        sources = parser.value("sources").split(",");
+        sources.removeAll(QString());
+    }
+
+    if (parser.isSet("sinks"))
+    {
+        sinks = parser.value("sinks").split(",");
+        sinks.removeAll(QString());
+    }
+
+    if (parser.isSet("mixer-rt") && !RealtimeConfig::parse(parser.value("mixer-rt"), mixerRt))
+    {
+        error = QString("Invalid mixer scheduling '%1'").arg(parser.value("mixer-rt"));
+        return false;
+    }
+
+    if (parser.isSet("network-rt") && !RealtimeConfig::parse(parser.value("network-rt"), networkRt))
+    {
+        error = QString("Invalid network scheduling '%1'").arg(parser.value("network-rt"));
+        return false;
+    }
+
+    if (parser.isSet("mlock"))
+        lockMemory = true;
+
+    if (parser.isSet("network-unit") && !ChannelPipeline::parseUnit(parser.value("network-unit"), networkUnit))
+    {
+        error = QString("Invalid network unit '%1'").arg(parser.value("network-unit"));
+        return false;
+    }
+
+    if (parser.isSet("channel-map"))
+    {
+        QStringList map = parser.value("channel-map").split(",");
+        if (map.count() > channels.count())
+        {
+            error = QString("Invalid channel map '%1'").arg(parser.value("channel-map"));
+            return false;
+        }
+        for (int i=0; i<map.count(); i++)
+        {
+            bool ok = false;
+            int input = map.at(i).toInt(&ok);
+            if (!ok || input < 1 || input > ChannelModel::MAX_CHANNELS)
+            {
+                error = QString("Invalid channel map '%1'").arg(parser.value("channel-map"));
+                return false;
+            }
+            channels[i].input = input - 1;
+        }
+    }
+
+    if (!applyMsOption(parser, "mixer-tick", mixerTickMs, error) ||
+        !applyMsOption(parser, "primary-timeout", primaryTimeoutMs, error) ||
+        !applyMsOption(parser, "secondary-timeout", secondaryTimeoutMs, error) ||
+        !applyMsOption(parser, "failsafe-delay", failsafeDelayMs, error) ||
+        !applyMsOption(parser, "shm-timeout", shmTimeoutMs, error) ||
+        !applyMsOption(parser, "owner-timeout", ownerTimeoutMs, error) ||
+        !applyMsOption(parser, "client-stall", clientStallMs, error) ||
+        !applyMsOption(parser, "ping-interval", pingIntervalMs, error) ||
+        !applyMsOption(parser, "max-frame-age", maxFrameAgeMs, error) ||
+        !applyMsOption(parser, "feedback-interval", feedbackIntervalMs, error))
+        return false;
+
+    if (parser.isSet("require-hello"))
+        requireHello = true;
+
+    if (parser.isSet("forward"))
+        forwardOnReceive = true;
+
+    if (parser.isSet("output-spacing"))
+    {
+        bool ok = false;
+        outputSpacingUs = parser.value("output-spacing").toInt(&ok);
+        if (!ok || outputSpacingUs < 0)
+        {
+            error = QString("Invalid output spacing '%1'").arg(parser.value("output-spacing"));
+            return false;
+        }
+    }
+
+    if (parser.isSet("send-queue"))
+    {
+        bool ok = false;
+        sendQueueKb = parser.value("send-queue").toInt(&ok);
+        if (!ok || sendQueueKb <= 0)
+        {
+            error = QString("Invalid send queue size '%1'").arg(parser.value("send-queue"));
+            return false;
+        }
+    }
+
+    if (parser.isSet("gui-refresh"))
+    {
+        bool ok = false;
+        guiRefreshHz = parser.value("gui-refresh").toInt(&ok);
+        if (!ok || guiRefreshHz < 0)
+        {
+            error = QString("Invalid refresh rate '%1'").arg(parser.value("gui-refresh"));
+            return false;
+        }
+    }
+
+    if (parser.isSet("telemetry-rate"))
+    {
+        bool ok = false;
+        telemetryHz = parser.value("telemetry-rate").toInt(&ok);
+        if (!ok || telemetryHz < 0 || telemetryHz > 1000)
+        {
+            error = QString("Invalid telemetry rate '%1'").arg(parser.value("telemetry-rate"));
+            return false;
+        }
+    }
+
+    if (parser.isSet("log-file"))
+        logFile = parser.value("log-file");
+
+    if (parser.isSet("latency-report"))
+    {
+        bool ok = false;
+        latencyReportS = parser.value("latency-report").toInt(&ok);
+        if (!ok || latencyReportS < 0)
+        {
+            error = QString("Invalid latency report interval '%1'").arg(parser.value("latency-report"));
+            return false;
+        }
+    }
+
+    if (parser.isSet("log-rate-limit"))
+    {
+        bool ok = false;
+        logRateLimitMs = parser.value("log-rate-limit").toInt(&ok);
+        if (!ok || logRateLimitMs < 0)
+        {
+            error = QString("Invalid log rate limit '%1'").arg(parser.value("log-rate-limit"));
+            return false;
+        }
+    }
+
+    if (parser.isSet("record"))
+        recordFile = parser.value("record");
+
+    if (parser.isSet("record-size"))
+    {
+        bool ok = false;
+        recordSizeMb = parser.value("record-size").toInt(&ok);
+        if (!ok || recordSizeMb <= 0)
+        {
+            error = QString("Invalid recording size '%1'").arg(parser.value("record-size"));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+QStringList BridgeConfig::effectiveSources() const
+{
+    if (!sources.isEmpty())
+        return sources;
+
+    QStringList list;
+    list << "tcp";
+    if (secondaryType != SecondaryNone)
+        list << secondaryTypeName(secondaryType) + ":" + serialPort2;
+    return list;
+}
+
+QStringList BridgeConfig::effectiveSinks() const
+{
+    if (!sinks.isEmpty())
+        return sinks;
+
+    return QStringList() << "sbus:" + serialPort;
+}
+
+void BridgeConfig::splitEndpoint(const QString &spec, QString &type, QString &port)
+{
+    int colon = spec.indexOf(':');
+    type = (colon < 0 ? spec : spec.left(colon)).trimmed().toLower();
+    port = colon < 0 ? QString() : spec.mid(colon + 1).trimmed();
+}
+
+bool BridgeConfig::applyMsOption(const QCommandLineParser &parser, const QString &name, int &value, QString &error)
+{
+    if (!parser.isSet(name))
+        return true;
+
+    bool ok = false;
+    int ms = parser.value(name).toInt(&ok);
+    if (!ok || ms < 0)
+    {
+        error = QString("Invalid %1 '%2'").arg(name, parser.value(name));
+        return false;
+    }
+    value = ms;
+    return true;
+}
+
+QString BridgeConfig::secondaryTypeName(SecondaryType type)
+{
+    switch (type)
+    {
+        case SecondaryNone: return "none";
+        case SecondarySbus: return "sbus";
+        case SecondaryCrsf: return "crsf";
+    }
+    return "none";
+}
+
+bool BridgeConfig::parseSecondaryType(const QString &name, SecondaryType &type)
+{
+    QString lower = name.toLower();
+    if (lower == "none") type = SecondaryNone;
+    else if (lower == "sbus") type = SecondarySbus;
+    else if (lower == "crsf") type = SecondaryCrsf;
+    else return false;
+    return true;
+}
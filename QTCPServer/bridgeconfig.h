@@ -0,0 +1,75 @@
+#ifndef BRIDGECONFIG_H
+#define BRIDGECONFIG_H
+
+#include <QString>
+#include <QStringList>
+#include <QSettings>
+#include <QCommandLineParser>
+#include <QVector>
+#include "channelpipeline.h"
+#include "realtime.h"
+
+// Engine configuration, read from QSettings (registry style or an ini file)
+// and optionally overridden from the command line.
+struct BridgeConfig
+{
+    enum SecondaryType { SecondaryNone, SecondarySbus, SecondaryCrsf };
+
+    quint16 tcpPort = 9001;
+    QString serialPort = "ttyAMA1";     // SBUS output
+    QString serialPort2 = "ttyAMA3";    // secondary input
+    SecondaryType secondaryType = SecondaryCrsf;
+    // Mixer inputs, highest priority first, and outputs as "type[:port]".
+    // Inputs: tcp, udp[:udpport], sbus:tty, crsf:tty. Outputs: sbus:tty, crsf:tty.
+    // Empty lists fall back to tcp plus the secondary input, and the SBUS output.
+    QStringList sources;
+    QStringList sinks;
+    int mixerTickMs = 10;
+    RealtimeConfig mixerRt;             // scheduling of the mixer (I/O) thread
+    RealtimeConfig networkRt;           // scheduling of the network thread
+    bool lockMemory = false;            // mlockall() at startup
+    int prefaultStackKb = 256;          // stack touched in each thread with a realtime config
+    ChannelUnit networkUnit = UnitSbus;  // unit of the values clients send
+    // Output channel transforms, settings groups [Channel1]..[Channel16]
+    QVector<ChannelTransform> channels = QVector<ChannelTransform>(ChannelModel::MAX_CHANNELS);
+    int primaryTimeoutMs = 500;         // network input is stale after this
+    int secondaryTimeoutMs = 500;       // secondary input is stale after this
+    int failsafeDelayMs = 0;            // hold last values this long before failsafe
+    int shmTimeoutMs = 100;             // shared memory inputs are stale after this
+    bool forwardOnReceive = false;      // write a new input frame at once instead of on the next tick
+    int outputSpacingUs = 4000;         // minimum time between forwarded writes
+    int ownerTimeoutMs = 300;           // a quiet controlling client loses control after this
+    bool requireHello = false;          // clients that didn't announce a role only observe
+    int sendQueueKb = 64;               // outbound data queued per client, then telemetry is dropped
+    int clientStallMs = 2000;           // a client whose queue hasn't drained for this long is disconnected, 0 never
+    int pingIntervalMs = 1000;          // clock offset pings to announced clients, 0 disables them
+    int maxFrameAgeMs = 0;              // frames older than this on arrival are dropped, 0 keeps all
+    int feedbackIntervalMs = 200;       // delivery feedback to announced senders, 0 disables it
+    int guiRefreshHz = 30;              // channel display rate, 0 disables it
+    int telemetryHz = 20;               // telemetry broadcast rate, 0 disables it
+    QString logFile;                    // status messages are also appended here if set
+    int logRateLimitMs = 1000;          // minimum time between repeated error messages
+    int logViewLines = 1000;            // lines kept in the GUI message view
+    int latencyReportS = 0;             // latency percentiles are logged this often, 0 only on exit
+    QString recordFile;                 // raw input is recorded here for replay if set
+    int recordSizeMb = 256;             // recording capacity, later input is dropped
+
+    void load(QSettings &settings);
+    void save(QSettings &settings) const;
+
+    static void addOptions(QCommandLineParser &parser);
+    // Returns false and fills error if an option value is invalid
+    bool applyOptions(const QCommandLineParser &parser, QString &error);
+
+    QStringList effectiveSources() const;
+    QStringList effectiveSinks() const;
+    static void splitEndpoint(const QString &spec, QString &type, QString &port);
+
+    static QString secondaryTypeName(SecondaryType type);
+    static bool parseSecondaryType(const QString &name, SecondaryType &type);
+
+private:
+    static bool applyMsOption(const QCommandLineParser &parser, const QString &name, int &value, QString &error);
+};
+
+#endif // BRIDGECONFIG_H
@@ -0,0 +1,700 @@
+#include "bridgeengine.h"
+#include "crc32c.h"
+#include "monotime.h"
+#include "serialio.h"
+#include "shminput.h"
+#include "textprotocol.h"
+
+// UDP senders whose delta state is kept before it is forgotten
+static const int UDP_MAX_PEERS = 64;
+// Queued data goes to a socket while Qt holds less than this for it
+static const qint64 SOCKET_WRITE_LIMIT = 16 * 1024;
+
+BridgeEngine::BridgeEngine(const BridgeConfig &config, QSettings *settings, QObject *parent) :
+    QObject(parent), ClientProtocol(config, m_netStats, &m_latency), m_config(config), m_settings(settings),
+    m_udpSocket(nullptr), m_nextConnectionId(1), m_telemetrySeq(0),
+    m_tcpInput(nullptr), m_udpInput(nullptr), m_udpPort(0), m_tcpIndex(-1), m_udpIndex(-1)
+{
+    m_server = new QTcpServer(this);
+    m_tcpControl.setTimeout(msToNs(m_config.ownerTimeoutMs));
+    m_udpControl.setTimeout(msToNs(m_config.ownerTimeoutMs));
+
+    m_log.setDefaultRateLimit(m_config.logRateLimitMs);
+    if (!m_log.setFile(m_config.logFile))
+        statusMsg(EventLog::General, QString("Unable to open log file '%1'").arg(m_config.logFile));
+
+    // Messages are posted without signalling and picked up here
+    m_logTimer = new QTimer(this);
+    m_logTimer->setInterval(100);
+    connect(m_logTimer, &QTimer::timeout, this, &BridgeEngine::drainLog);
+    m_logTimer->start();
+
+    if (m_config.latencyReportS > 0)
+    {
+        QTimer *latencyTimer = new QTimer(this);
+        latencyTimer->setInterval(m_config.latencyReportS * 1000);
+        connect(latencyTimer, &QTimer::timeout, this, &BridgeEngine::postLatencyReport);
+        latencyTimer->start();
+    }
+
+    if (m_config.clientStallMs > 0)
+    {
+        QTimer *stallTimer = new QTimer(this);
+        stallTimer->setInterval(qMax(50, m_config.clientStallMs / 4));
+        connect(stallTimer, &QTimer::timeout, this, &BridgeEngine::checkSendQueues);
+        stallTimer->start();
+    }
+
+    if (m_config.telemetryHz > 0)
+    {
+        QTimer *telemetryTimer = new QTimer(this);
+        telemetryTimer->setTimerType(Qt::PreciseTimer);
+        telemetryTimer->setInterval(qMax(1, 1000 / m_config.telemetryHz));
+        connect(telemetryTimer, &QTimer::timeout, this, &BridgeEngine::broadcastTelemetry);
+        telemetryTimer->start();
+    }
+
+    if (m_config.pingIntervalMs > 0)
+    {
+        QTimer *pingTimer = new QTimer(this);
+        pingTimer->setInterval(m_config.pingIntervalMs);
+        connect(pingTimer, &QTimer::timeout, this, &BridgeEngine::pingClients);
+        pingTimer->start();
+    }
+
+    if (m_config.feedbackIntervalMs > 0)
+    {
+        QTimer *feedbackTimer = new QTimer(this);
+        feedbackTimer->setInterval(m_config.feedbackIntervalMs);
+        connect(feedbackTimer, &QTimer::timeout, this, &BridgeEngine::sendFeedback);
+        feedbackTimer->start();
+    }
+
+    createEndpoints();
+}
+
+void BridgeEngine::createEndpoints()
+{
+    QList<InputSource*> sources;
+    QList<OutputSink*> sinks;
+    QString type, port;
+
+    if (!m_config.recordFile.isEmpty())
+    {
+        QString error;
+        if (m_recorder.open(m_config.recordFile, qint64(m_config.recordSizeMb) << 20, error))
+            statusMsg(EventLog::General, QString("Recording input to '%1'").arg(m_config.recordFile));
+        else
+            m_errorString = error;
+    }
+
+    m_sourceSpecs = m_config.effectiveSources();
+    foreach (const QString &spec, m_sourceSpecs)
+    {
+        BridgeConfig::splitEndpoint(spec, type, port);
+        if (type == "tcp" && !m_tcpInput)
+        {
+            m_tcpIndex = sources.count();
+            m_tcpInput = new NetworkInput("tcp");
+            m_tcpInput->setUnit(m_config.networkUnit);
+            addSource(sources, m_tcpInput);
+        }
+        else if (type == "udp" && !m_udpInput)
+        {
+            m_udpIndex = sources.count();
+            m_udpPort = port.isEmpty() ? m_config.tcpPort : quint16(port.toUInt());
+            m_udpInput = new NetworkInput("udp", QString::number(m_udpPort));
+            m_udpInput->setUnit(m_config.networkUnit);
+            addSource(sources, m_udpInput);
+        }
+        else if (type == "sbus")
+        {
+            addSource(sources, new SbusInput(port));
+        }
+        else if (type == "crsf")
+        {
+            addSource(sources, new CrsfInput(port));
+        }
+        else if (type == "shm")
+        {
+            m_shmIndexes << sources.count();
+            ShmInput *shm = new ShmInput(port.isEmpty() ? "qtcpserver" : port);
+            shm->setUnit(m_config.networkUnit);
+            addSource(sources, shm);
+        }
+        else
+        {
+            m_errorString = QString("Invalid input '%1'").arg(spec);
+        }
+    }
+
+    m_sinkSpecs = m_config.effectiveSinks();
+    foreach (const QString &spec, m_sinkSpecs)
+    {
+        BridgeConfig::splitEndpoint(spec, type, port);
+        if (type == "sbus")
+            sinks << new SbusOutput(port);
+        else if (type == "crsf")
+            sinks << new CrsfOutput(port);
+        else
+            m_errorString = QString("Invalid output '%1'").arg(spec);
+    }
+
+    m_mixer = new ChannelMixer(sources, sinks);
+    m_mixer->setChannelModel(&m_channelModel);
+    m_mixer->setEventLog(&m_log);
+    m_mixer->setLatencyMonitor(&m_latency);
+    m_mixer->setTickInterval(m_config.mixerTickMs);
+    m_mixer->setRealtime(m_config.mixerRt, m_config.prefaultStackKb);
+    m_mixer->setTransforms(m_config.channels);
+    m_mixer->setTimeouts(m_config.primaryTimeoutMs, m_config.secondaryTimeoutMs, m_config.failsafeDelayMs);
+    foreach (int index, m_shmIndexes) m_mixer->setSourceTimeout(index, m_config.shmTimeoutMs);
+    m_mixer->setTelemetry(&m_telemetry, m_config.telemetryHz);
+    m_mixer->setForwarding(m_config.forwardOnReceive, m_config.outputSpacingUs);
+    m_mixer->moveToThread(&mixerThread);
+    connect(&mixerThread, &QThread::finished, m_mixer, &QObject::deleteLater);
+    connect(this, &BridgeEngine::startMixer, m_mixer, &ChannelMixer::start);
+    connect(this, &BridgeEngine::reopenSource, m_mixer, &ChannelMixer::reopenSource);
+    connect(this, &BridgeEngine::reopenSink, m_mixer, &ChannelMixer::reopenSink);
+    connect(m_mixer, &ChannelMixer::linkHealth, this, &BridgeEngine::linkHealth);
+}
+
+void BridgeEngine::addSource(QList<InputSource*> &sources, InputSource *source)
+{
+    // The replay tool recreates the sources from these records
+    if (m_recorder.isOpen())
+    {
+        QByteArray desc = QString("%1:%2;%3").arg(source->type(), source->port(),
+                                                  ChannelPipeline::unitName(source->unit())).toUtf8();
+        m_recorder.append(StreamRecorder::KindSource, sources.count(), desc.constData(), desc.size(), monotonicNs());
+        source->setRecorder(&m_recorder, sources.count());
+    }
+    sources << source;
+}
+
+BridgeEngine::~BridgeEngine()
+{
+    // Final numbers end up in the log file, while every client is still there
+    postLatencyReport();
+
+    if (mixerThread.isRunning())
+    {
+        mixerThread.quit();
+        mixerThread.wait();
+    }
+    else
+    {
+        delete m_mixer;
+    }
+
+    foreach (QTcpSocket* socket, connection_list)
+    {
+        socket->close();
+        socket->deleteLater();
+    }
+    // Closing a socket with bytes left to write doesn't disconnect it at once
+    QList<Connection*> clients = m_connections.values() + m_udpPeers.values();
+    foreach (Connection *connection, clients) removeClient(connection);
+    qDeleteAll(clients);
+    m_connections.clear();
+    m_udpPeers.clear();
+
+    m_server->close();
+
+    if (m_recorder.isOpen())
+    {
+        if (m_recorder.dropped() > 0)
+            statusMsg(EventLog::General, QString("Recording full, %1 reads not recorded").arg(m_recorder.dropped()));
+        m_recorder.close();
+    }
+}
+
+void BridgeEngine::postLatencyReport()
+{
+    foreach (const QString &line, m_latency.report())
+        statusMsg(EventLog::Latency, line);
+
+    const NetworkStats &n = m_netStats;
+    statusMsg(EventLog::Latency, QString("network: %1 clients (peak %2, %3 connects, %4 resumed), %5 accepted, %6 refused, %7 rejected, %8 stale, %9 duplicates, %10 too old, %11 kB")
+              .arg(n.clients).arg(n.peakClients).arg(n.connects).arg(n.resumed)
+              .arg(n.accepted).arg(n.refused).arg(n.rejected).arg(n.stale).arg(n.duplicates).arg(n.tooOld).arg(n.bytes / 1024));
+    statusMsg(EventLog::Latency, QString("outbound: %1 dropped, %2 stalled clients").arg(n.dropped).arg(n.stalled));
+
+    // Which path of each dual path client won, and by how much
+    foreach (const Session *session, sessions())
+    {
+        QStringList paths;
+        for (int i=0; i<FRAME_PATHS; i++)
+        {
+            const PathDedup::PathStats &p = session->dedup.stats(i);
+            const Connection *connection = static_cast<const Connection*>(session->paths[i]);
+            paths << QString("%1 %2 won %3 (lead avg %4 max %5 ms), %6 solo, %7 late")
+                     .arg(i).arg(connection ? (connection->socket ? "tcp" : "udp") : "gone")
+                     .arg(p.wins).arg(p.caught ? p.leadSumNs / 1e6 / p.caught : 0.0, 0, 'f', 2)
+                     .arg(p.leadMaxNs / 1e6, 0, 'f', 2).arg(p.solo).arg(p.late);
+        }
+        statusMsg(EventLog::Latency, QString("session %1: %2, %3 duplicates dropped")
+                  .arg(session->id, 8, 16, QChar('0')).arg(paths.join("; ")).arg(session->dedup.stats(0).losses + session->dedup.stats(1).losses));
+    }
+
+    foreach (const ClientStats &c, clientStats())
+    {
+        if (c.synced)
+            statusMsg(EventLog::Latency, QString("%1: clock offset %2 ms, RTT %3 ms, last frame %4")
+                      .arg(c.name).arg(c.offsetUs / 1000.0, 0, 'f', 1).arg(c.rttUs / 1000.0, 0, 'f', 1)
+                      .arg(c.ageUs < 0 ? QString("unstamped") : QString("%1 ms old").arg(c.ageUs / 1000.0, 0, 'f', 1)));
+        // Only the clients that fell behind at some point
+        if (c.queued == 0 && c.dropped == 0) continue;
+        statusMsg(EventLog::Latency, QString("%1: %2 queued (%3 bytes), %4 dropped, %5 kB sent")
+                  .arg(c.name).arg(c.queued).arg(c.queuedBytes).arg(c.dropped).arg(c.bytesSent / 1024));
+    }
+}
+
+bool BridgeEngine::start()
+{
+    if (!m_errorString.isEmpty())
+        return false;
+
+    bool ok = true;
+    if (m_config.lockMemory)
+    {
+        QString report = lockMemory(ok);
+        statusMsg(EventLog::General, ok ? report : "Warning: " + report);
+    }
+
+    QString report = applyRealtime("Network", m_config.networkRt, m_config.networkRt.isDefault() ? 0 : m_config.prefaultStackKb, ok);
+    statusMsg(EventLog::General, ok ? report : "Warning: " + report);
+    statusMsg(EventLog::General, QString("Frame CRC32C: %1").arg(crc32cImplementation()));
+
+    if (m_tcpInput)
+    {
+        if (!m_server->listen(QHostAddress::Any, m_config.tcpPort))
+        {
+            m_errorString = m_server->errorString();
+            return false;
+        }
+
+        connect(m_server, &QTcpServer::newConnection, this, &BridgeEngine::newConnection);
+        statusMsg(EventLog::General, QString("Server is listening on port %1").arg(m_config.tcpPort));
+    }
+
+    if (m_udpInput)
+    {
+        m_udpSocket = new QUdpSocket(this);
+        if (!m_udpSocket->bind(QHostAddress::Any, m_udpPort))
+        {
+            m_errorString = m_udpSocket->errorString();
+            return false;
+        }
+
+        connect(m_udpSocket, &QUdpSocket::readyRead, this, &BridgeEngine::readDatagrams);
+        statusMsg(EventLog::General, QString("Listening for UDP on port %1").arg(m_udpPort));
+    }
+
+    mixerThread.start();
+    emit startMixer();
+
+    return true;
+}
+
+void BridgeEngine::drainLog()
+{
+    QStringList lines = m_log.drain();
+    if (!lines.isEmpty())
+        emit statusMessages(lines);
+}
+
+void BridgeEngine::setSerialPort(const QString &port)
+{
+    QString type, oldPort;
+    for (int i=0; i<m_sinkSpecs.count(); i++)
+    {
+        BridgeConfig::splitEndpoint(m_sinkSpecs.at(i), type, oldPort);
+        if (type != "sbus") continue;
+
+        m_sinkSpecs[i] = type + ":" + port;
+        m_config.serialPort = port;
+        if (!m_config.sinks.isEmpty()) m_config.sinks = m_sinkSpecs;
+        if (m_settings)
+        {
+            m_settings->setValue("SerialPort",port);
+            if (!m_config.sinks.isEmpty()) m_settings->setValue("Sinks",m_config.sinks);
+            m_settings->sync();
+        }
+
+        emit reopenSink(i, port);
+        return;
+    }
+}
+
+void BridgeEngine::setSerialPort2(const QString &port)
+{
+    QString type, oldPort;
+    for (int i=0; i<m_sourceSpecs.count(); i++)
+    {
+        BridgeConfig::splitEndpoint(m_sourceSpecs.at(i), type, oldPort);
+        if (type != "sbus" && type != "crsf") continue;
+
+        m_sourceSpecs[i] = type + ":" + port;
+        m_config.serialPort2 = port;
+        if (!m_config.sources.isEmpty()) m_config.sources = m_sourceSpecs;
+        if (m_settings)
+        {
+            m_settings->setValue("SerialPort2",port);
+            if (!m_config.sources.isEmpty()) m_settings->setValue("Sources",m_config.sources);
+            m_settings->sync();
+        }
+
+        emit reopenSource(i, port);
+        return;
+    }
+}
+
+void BridgeEngine::newConnection()
+{
+    while (m_server->hasPendingConnections())
+        appendToSocketList(m_server->nextPendingConnection());
+}
+
+BridgeEngine::Connection *BridgeEngine::createConnection(ControlArbiter *arbiter, NetworkInput *input)
+{
+    Connection *connection = new Connection;
+    initClient(*connection, arbiter);
+    connection->id = m_nextConnectionId++;
+    connection->descriptor = -1;
+    connection->socket = nullptr;
+    connection->port = 0;
+    connection->lastRxNs = 0;
+    connection->telemetryEvery = 0;
+    connection->telemetryCountdown = 0;
+    connection->queue.setLimit(m_config.sendQueueKb * 1024);
+    connection->behindSinceNs = 0;
+    connection->dropped = 0;
+    connection->bytesSent = 0;
+    connection->input = input;
+    return connection;
+}
+
+void BridgeEngine::appendToSocketList(QTcpSocket* socket)
+{
+    Connection *connection = createConnection(&m_tcpControl, m_tcpInput);
+    connection->descriptor = socket->socketDescriptor();
+    connection->socket = socket;
+    connection->peer = QString("%1:%2").arg(socket->peerAddress().toString()).arg(socket->peerPort());
+    socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+    connection_list.append(socket);
+    m_connections.insert(socket, connection);
+    m_netStats.connects++;
+    m_netStats.clients = m_connections.count();
+    m_netStats.peakClients = qMax(m_netStats.peakClients, m_netStats.clients);
+    connect(socket, &QTcpSocket::readyRead, this, &BridgeEngine::readSocket);
+    connect(socket, &QTcpSocket::disconnected, this, &BridgeEngine::discardSocket);
+    connect(socket, &QTcpSocket::bytesWritten, this, &BridgeEngine::socketBytesWritten);
+    emit clientConnected(socket->socketDescriptor());
+}
+
+void BridgeEngine::readSocket()
+{
+    QTcpSocket* socket = reinterpret_cast<QTcpSocket*>(sender());
+
+    Connection *connection = m_connections.value(socket);
+    if (!connection) return;
+
+    qint64 rxNs = monotonicNs();
+    QByteArray block = socket->readAll();
+    m_netStats.bytes += quint64(block.size());
+    if (m_recorder.isOpen())
+        m_recorder.append(StreamRecorder::KindNetwork, m_tcpIndex, block.constData(), block.size(), rxNs, connection->id);
+
+    connection->reader.append(block);
+    processStream(*connection, rxNs);
+}
+
+void BridgeEngine::readDatagrams()
+{
+    while (m_udpSocket->hasPendingDatagrams())
+    {
+        QByteArray block;
+        QHostAddress address;
+        quint16 port = 0;
+        block.resize(int(m_udpSocket->pendingDatagramSize()));
+        m_udpSocket->readDatagram(block.data(), block.size(), &address, &port);
+        qint64 rxNs = monotonicNs();
+        m_netStats.bytes += quint64(block.size());
+
+        // Delta frames need the sender's previous state, kept per address
+        // and port like a connection
+        QString peer = QString("%1:%2").arg(address.toString()).arg(port);
+        Connection *connection = m_udpPeers.value(peer);
+        if (!connection)
+        {
+            // Senders come and go without disconnecting, forget the one
+            // heard from longest ago rather than grow without bound. The
+            // owner keeps its hello and its control.
+            if (m_udpPeers.count() >= UDP_MAX_PEERS)
+            {
+                Connection *quietest = nullptr;
+                foreach (Connection *known, m_udpPeers)
+                    if (known->arbiter->owner() != known && (!quietest || known->lastRxNs < quietest->lastRxNs))
+                        quietest = known;
+                if (quietest)
+                {
+                    removeClient(quietest);
+                    m_udpPeers.remove(quietest->peer);
+                    delete quietest;
+                }
+            }
+            connection = createConnection(&m_udpControl, m_udpInput);
+            connection->address = address;
+            connection->port = port;
+            connection->peer = peer;
+            m_udpPeers.insert(peer, connection);
+        }
+
+        if (m_recorder.isOpen())
+            m_recorder.append(StreamRecorder::KindNetwork, m_udpIndex, block.constData(), block.size(), rxNs, connection->id);
+
+        connection->lastRxNs = rxNs;
+        // Each datagram stands alone, a partial message is dropped with it
+        connection->reader.clear();
+        connection->reader.append(block);
+        processStream(*connection, rxNs);
+    }
+}
+
+void BridgeEngine::discardSocket()
+{
+    QTcpSocket* socket = reinterpret_cast<QTcpSocket*>(sender());
+
+    connection_list.removeOne(socket);
+    Connection *connection = m_connections.take(socket);
+    m_netStats.clients = m_connections.count();
+    if (connection)
+    {
+        if (removeClient(connection))
+            statusMsg(EventLog::Network, QString("%1 disconnected while in control").arg(clientName(*connection)));
+        emit clientDisconnected(connection->descriptor);
+        delete connection;
+    }
+
+    socket->deleteLater();
+}
+
+void BridgeEngine::sendMessage(qintptr descriptor, const QString &str)
+{
+    foreach (QTcpSocket* socket, connection_list)
+    {
+        if (descriptor == -1 || socket->socketDescriptor() == descriptor)
+        {
+            sendMessage(socket, str);
+            if (descriptor != -1) return;
+        }
+    }
+
+    if (descriptor != -1)
+        statusMsg(EventLog::Network, QString("Not connected to '%1'").arg(descriptor));
+}
+
+void BridgeEngine::sendMessage(QTcpSocket* socket, const QString &str)
+{
+    Connection *connection = m_connections.value(socket);
+    if (connection && socket->isOpen())
+    {
+        send(*connection, writeTextMessage(str));
+    }
+    else
+        statusMsg(EventLog::Network, "Socket doesn't seem to be opened");
+}
+
+void BridgeEngine::subscribe(Client &client, int rateHz)
+{
+    Connection &connection = static_cast<Connection&>(client);
+    if (m_config.telemetryHz <= 0)
+    {
+        statusMsg(EventLog::Network, QString("%1 asked for telemetry, which is disabled").arg(clientName(connection)));
+        return;
+    }
+
+    // Every nth broadcast tick, so all subscribers share the same frame
+    connection.telemetryEvery = rateHz > 0 ? qMax(1, qRound(double(m_config.telemetryHz) / rateHz)) : 0;
+    connection.telemetryCountdown = 0;
+    if (connection.telemetryEvery > 0)
+        statusMsg(EventLog::Network, QString("%1 subscribed to telemetry at %2 Hz")
+                  .arg(clientName(connection)).arg(m_config.telemetryHz / double(connection.telemetryEvery), 0, 'f', 1));
+    else
+        statusMsg(EventLog::Network, QString("%1 unsubscribed from telemetry").arg(clientName(connection)));
+}
+
+void BridgeEngine::dropClient(Client *client)
+{
+    Connection *connection = static_cast<Connection*>(client);
+    if (connection->socket)
+    {
+        // Deletes it through discardSocket
+        connection->socket->abort();
+    }
+    else
+    {
+        removeClient(connection);
+        m_udpPeers.remove(connection->peer);
+        delete connection;
+    }
+}
+
+bool BridgeEngine::submitToInput(Client &client, const int *values, int count, qint64 rxNs)
+{
+    qint64 parsedNs = monotonicNs();
+    m_latency.record(LatencyMonitor::StageParse, parsedNs - rxNs);
+    return static_cast<Connection&>(client).input->submit(values, count, rxNs, parsedNs);
+}
+
+void BridgeEngine::sendControl(Client &client)
+{
+    // Clients without a hello may only understand text
+    if (!client.announced) return;
+
+    ControlArbiter::Client *owner = client.arbiter->owner();
+    QByteArray frame;
+    appendControlFrame(frame, owner == &client, owner ? owner->priority : 0, owner ? owner->id : 0);
+    send(static_cast<Connection&>(client), frame);
+}
+
+void BridgeEngine::send(Connection &connection, const QByteArray &data, bool droppable)
+{
+    if (!connection.socket)
+    {
+        // A datagram either fits the kernel buffer or is lost anyway
+        if (m_udpSocket && m_udpSocket->writeDatagram(data, connection.address, connection.port) == data.size())
+            connection.bytesSent += quint64(data.size());
+        else
+            connection.dropped++;
+        return;
+    }
+
+    int dropped = connection.queue.push(data, droppable);
+    connection.dropped += quint64(dropped);
+    m_netStats.dropped += quint64(dropped);
+    flushQueue(connection);
+}
+
+void BridgeEngine::flushQueue(Connection &connection)
+{
+    SendQueue &queue = connection.queue;
+    while (!queue.isEmpty() && connection.socket->bytesToWrite() < SOCKET_WRITE_LIMIT)
+    {
+        connection.bytesSent += quint64(queue.front().size());
+        connection.socket->write(queue.front());
+        queue.pop();
+    }
+
+    if (queue.isEmpty())
+        connection.behindSinceNs = 0;
+    else if (connection.behindSinceNs == 0)
+        connection.behindSinceNs = monotonicNs();
+}
+
+void BridgeEngine::socketBytesWritten()
+{
+    Connection *connection = m_connections.value(reinterpret_cast<QTcpSocket*>(sender()));
+    if (connection) flushQueue(*connection);
+}
+
+// A client that hasn't drained its queue for the stall time is cut off, so
+// its backlog can't grow with control frames and text that aren't dropped
+void BridgeEngine::checkSendQueues()
+{
+    qint64 now = monotonicNs();
+    qint64 stallNs = msToNs(m_config.clientStallMs);
+    foreach (QTcpSocket *socket, connection_list)
+    {
+        Connection *connection = m_connections.value(socket);
+        if (!connection || connection->behindSinceNs == 0 || now - connection->behindSinceNs < stallNs) continue;
+
+        m_netStats.stalled++;
+        statusMsg(EventLog::Network, QString("%1 stalled with %2 messages (%3 bytes) queued, disconnecting")
+                  .arg(clientName(*connection)).arg(connection->queue.depth()).arg(connection->queue.bytes()));
+        connection->queue.clear();
+        socket->abort();
+    }
+}
+
+QList<BridgeEngine::ClientStats> BridgeEngine::clientStats() const
+{
+    QList<ClientStats> list;
+    QList<Connection*> clients = m_connections.values() + m_udpPeers.values();
+    foreach (const Connection *connection, clients)
+    {
+        ClientStats stats;
+        stats.id = connection->id;
+        stats.name = clientName(*connection);
+        stats.queued = connection->queue.depth();
+        stats.queuedBytes = connection->queue.bytes();
+        stats.dropped = connection->dropped;
+        stats.bytesSent = connection->bytesSent;
+        stats.synced = connection->clock.isValid();
+        stats.offsetUs = connection->clock.offsetUs();
+        stats.rttUs = connection->clock.rttUs();
+        stats.ageUs = connection->ageUs;
+        list << stats;
+    }
+    return list;
+}
+
+void BridgeEngine::broadcastTelemetry()
+{
+    char payload[TelemetrySlot::BYTES];
+    int size = 0;
+    if (m_telemetry.sample(payload, size) == 0) return;
+
+    // Framed once, the same bytes go to every subscriber due this tick
+    QByteArray frame;
+    QList<Connection*> clients = m_connections.values() + m_udpPeers.values();
+    foreach (Connection *connection, clients)
+    {
+        if (connection->telemetryEvery <= 0 || --connection->telemetryCountdown > 0) continue;
+        connection->telemetryCountdown = connection->telemetryEvery;
+        if (frame.isEmpty()) appendFrame(frame, FrameTelemetry, m_telemetrySeq++, payload, size);
+        send(*connection, frame, true);
+    }
+}
+
+// Clients without a hello may not know the frame, the others answer with
+// their own clock, the same ping goes to all of them
+void BridgeEngine::pingClients()
+{
+    QByteArray frame;
+    QList<Connection*> clients = m_connections.values() + m_udpPeers.values();
+    foreach (Connection *connection, clients)
+    {
+        if (!connection->announced) continue;
+        if (frame.isEmpty()) appendPingFrame(frame, quint64(monotonicNs() / 1000));
+        send(*connection, frame, true);
+    }
+}
+
+// Senders adapt their rate to how their frames arrive, clients that only
+// listen get none
+void BridgeEngine::sendFeedback()
+{
+    QList<Connection*> clients = m_connections.values() + m_udpPeers.values();
+    foreach (Connection *connection, clients)
+    {
+        if (!connection->announced || connection->framesReceived == 0) continue;
+
+        Feedback feedback;
+        feedback.received = connection->framesReceived;
+        feedback.lost = connection->state.lost();
+        feedback.late = connection->framesLate;
+        feedback.coalesced = connection->framesCoalesced;
+        feedback.ageUs = connection->ageCount > 0 ? quint32(qMin(connection->ageSumUs / connection->ageCount, qint64(Feedback::NO_AGE - 1)))
+                                                  : Feedback::NO_AGE;
+        feedback.queuedBytes = quint32(connection->queue.bytes() + (connection->socket ? connection->socket->bytesToWrite() : 0));
+        connection->ageSumUs = 0;
+        connection->ageCount = 0;
+
+        QByteArray frame;
+        appendFeedbackFrame(frame, feedback);
+        send(*connection, frame, true);
+    }
+}
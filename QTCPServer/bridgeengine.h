@@ -0,0 +1,189 @@
+#ifndef BRIDGEENGINE_H
+#define BRIDGEENGINE_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QUdpSocket>
+#include <QThread>
+#include <QTimer>
+#include <QSettings>
+#include "bridgeconfig.h"
+#include "channelmixer.h"
+#include "clientprotocol.h"
+#include "channelmodel.h"
+#include "controlarbiter.h"
+#include "eventlog.h"
+#include "joystickprotocol.h"
+#include "latency.h"
+#include "networkinput.h"
+#include "recorder.h"
+#include "sendqueue.h"
+#include "telemetryslot.h"
+
+// Network to SBUS bridge without any GUI dependency.
+// Owns the TCP/UDP sockets and the mixer thread with the configured inputs
+// and outputs. A GUI (or the daemon entry point) observes it through its
+// signals and changes it through its slots.
+class BridgeEngine : public QObject, private ClientProtocol
+{
+    Q_OBJECT
+public:
+    // settings may be null, then port changes are not persisted
+    explicit BridgeEngine(const BridgeConfig &config, QSettings *settings = nullptr, QObject *parent = nullptr);
+    ~BridgeEngine();
+
+    // Starts listening and opens the configured ports, false if the server can't listen.
+    // Runs the network in the calling thread.
+    Q_INVOKABLE bool start();
+
+    const BridgeConfig &config() const { return m_config; }
+    QString errorString() const { return m_errorString; }
+
+    // Latest output channel values for display, written without signalling
+    const ChannelModel &channelModel() const { return m_channelModel; }
+
+    // Per stage latency percentiles, callable from any thread
+    QStringList latencyReport() const { return m_latency.report(); }
+    LatencyHistogram::Summary latencySummary(LatencyMonitor::Stage stage) const { return m_latency.summary(stage); }
+
+    // Network traffic since start, this thread only
+    struct NetworkStats : ClientProtocol::Stats
+    {
+        quint64 bytes = 0;
+        quint64 connects = 0;
+        quint64 dropped = 0;        // outbound telemetry dropped for slow clients
+        quint64 stalled = 0;        // clients disconnected for not taking their data
+        int clients = 0;
+        int peakClients = 0;
+    };
+    const NetworkStats &networkStats() const { return m_netStats; }
+
+    // Outbound state of each client, this thread only
+    struct ClientStats
+    {
+        quint16 id;
+        QString name;
+        int queued;                 // messages waiting for the socket
+        int queuedBytes;
+        quint64 dropped;
+        quint64 bytesSent;
+        bool synced;                // answered a ping, the times below are known
+        qint64 offsetUs;            // client clock minus server clock
+        qint64 rttUs;
+        qint64 ageUs;               // of its last frame with a sender time, -1 none yet
+    };
+    QList<ClientStats> clientStats() const;
+
+signals:
+    // Status messages from all threads, collected and rate limited by the
+    // event log and delivered in batches
+    void statusMessages(const QStringList &lines);
+    // Once a second, health of the inputs and outputs
+    void linkHealth(const QStringList &lines);
+    void clientConnected(qintptr descriptor);
+    void clientDisconnected(qintptr descriptor);
+
+    // Internal, queued to the mixer thread
+    void startMixer();
+    void reopenSource(int index, const QString &port);
+    void reopenSink(int index, const QString &port);
+
+public slots:
+    // Port of the first SBUS output
+    void setSerialPort(const QString &port);
+    // Port of the first serial input
+    void setSerialPort2(const QString &port);
+    // Send a text message to one client, or to every client if descriptor is -1
+    void sendMessage(qintptr descriptor, const QString &str);
+
+private slots:
+    void newConnection();
+    void readSocket();
+    void readDatagrams();
+    void discardSocket();
+    void drainLog();
+    void postLatencyReport();
+    void broadcastTelemetry();
+    void socketBytesWritten();
+    void checkSendQueues();
+    void pingClients();
+    void sendFeedback();
+
+private:
+    void createEndpoints();
+    void addSource(QList<InputSource*> &sources, InputSource *source);
+    void appendToSocketList(QTcpSocket *socket);
+    void sendMessage(QTcpSocket *socket, const QString &str);
+    struct Connection;
+    Connection *createConnection(ControlArbiter *arbiter, NetworkInput *input);
+    bool submitToInput(Client &client, const int *values, int count, qint64 rxNs) override;
+    void sendControl(Client &client) override;
+    void subscribe(Client &client, int rateHz) override;
+    void dropClient(Client *client) override;
+    // Droppable data is telemetry, which a slow client may miss
+    void send(Connection &connection, const QByteArray &data, bool droppable = false);
+    void flushQueue(Connection &connection);
+    void statusMsg(EventLog::Type type, const QString &msg) override { m_log.post(type, msg); }
+
+    BridgeConfig m_config;
+    QSettings *m_settings;
+    QString m_errorString;
+
+    QTcpServer *m_server;
+    QUdpSocket *m_udpSocket;
+    // What the engine keeps of a client on top of the protocol state
+    struct Connection : ClientProtocol::Client
+    {
+        qintptr descriptor;     // -1 for a UDP sender
+        QTcpSocket *socket;     // null for a UDP sender
+        QHostAddress address;   // of a UDP sender
+        quint16 port;
+        qint64 lastRxNs;        // last datagram of a UDP sender
+        int telemetryEvery;     // telemetry ticks per snapshot sent, 0 not subscribed
+        int telemetryCountdown;
+        SendQueue queue;        // TCP only, UDP is sent at once or dropped
+        qint64 behindSinceNs;   // queue not empty since, 0 when drained
+        quint64 dropped;
+        quint64 bytesSent;
+        NetworkInput *input;
+    };
+
+    QList<QTcpSocket*> connection_list;
+    QHash<QTcpSocket*, Connection*> m_connections;
+    QHash<QString, Connection*> m_udpPeers;     // by address:port
+    quint16 m_nextConnectionId;
+    // One controlling client per network input
+    ControlArbiter m_tcpControl;
+    ControlArbiter m_udpControl;
+    NetworkStats m_netStats;
+    ChannelModel m_channelModel;
+    EventLog m_log;
+    QTimer *m_logTimer;
+    LatencyMonitor m_latency;
+    // Encoded by the mixer, framed once per tick for all subscribers
+    TelemetrySlot m_telemetry;
+    quint32 m_telemetrySeq;
+
+    // Owned by the mixer, fed from this thread
+    NetworkInput *m_tcpInput;
+    NetworkInput *m_udpInput;
+    quint16 m_udpPort;
+    int m_tcpIndex;
+    int m_udpIndex;
+    QList<int> m_shmIndexes;
+    QStringList m_sourceSpecs;
+    QStringList m_sinkSpecs;
+
+    // Written from this and the mixer thread while recording
+    StreamRecorder m_recorder;
+
+    ChannelMixer *m_mixer;
+    QThread mixerThread;
+};
+
+#endif // BRIDGEENGINE_H
@@ -0,0 +1,104 @@
+#ifndef CHANNELIO_H
+#define CHANNELIO_H
+
+#include <QString>
+#include "channelmodel.h"
+#include "eventlog.h"
+#include "joystickprotocol.h"
+#include "monotime.h"
+#include "recorder.h"
+
+// Unit of the values a source delivers, see ChannelPipeline
+enum ChannelUnit { UnitSbus, UnitCrsf, UnitMicroseconds, UnitCount };
+
+// One set of channel values as it travels from a source through the mixer to
+// the sinks. Sources deliver their own unit, after the mixer's pipeline
+// values are in SBUS units (0..2047).
+struct ChannelFrame
+{
+    int count;
+    int channels[ChannelModel::MAX_CHANNELS];
+    bool failsafe;
+    qint64 rxNs;        // monotonicNs() when the bytes were read, 0 if unknown
+    qint64 readyNs;     // monotonicNs() when the values were handed to the mixer
+};
+
+// Base of InputSource and OutputSink, "type:port" endpoint plus the event log
+class ChannelEndpoint
+{
+public:
+    ChannelEndpoint(const QString &type, const QString &port) :
+        m_type(type), m_port(port), m_log(nullptr), m_isOpen(false) {}
+    virtual ~ChannelEndpoint() {}
+
+    QString type() const { return m_type; }
+    QString port() const { return m_port; }
+    QString name() const { return m_port.isEmpty() ? m_type : m_type + ":" + m_port; }
+    bool isOpen() const { return m_isOpen; }
+
+    void setPort(const QString &port) { m_port = port; }
+    void setEventLog(EventLog *log) { m_log = log; }
+
+    // Called from the mixer thread
+    virtual bool open() = 0;
+    virtual void close() { m_isOpen = false; }
+
+    // Link health for the status bar, empty if there is nothing to report
+    virtual QString health() const { return QString(); }
+
+protected:
+    void statusMsg(EventLog::Type type, const QString &msg) { if (m_log) m_log->post(type, msg); }
+
+    QString m_type;
+    QString m_port;
+    EventLog *m_log;
+    bool m_isOpen;
+};
+
+// A channel input. The mixer polls every source once per tick from its own
+// thread, so sources never need a thread or a signal of their own.
+class InputSource : public ChannelEndpoint
+{
+public:
+    InputSource(const QString &type, const QString &port, ChannelUnit unit) :
+        ChannelEndpoint(type, port), m_unit(unit), m_recorder(nullptr), m_index(0) {}
+
+    ChannelUnit unit() const { return m_unit; }
+    void setUnit(ChannelUnit unit) { m_unit = unit; }
+    // Raw input is appended to recorder as source index, call before open()
+    void setRecorder(StreamRecorder *recorder, int index) { m_recorder = recorder; m_index = index; }
+
+    // Reads everything that arrived since the last poll, returns true and the
+    // newest values if there was a new (non failsafe) frame
+    virtual bool poll(ChannelFrame &frame) = 0;
+
+    // Counters for the telemetry snapshot, in is zeroed, mixer thread
+    virtual void telemetry(TelemetryInput &in) const { in.type = TelemetryInput::Network; }
+
+    // Readable when a frame may be waiting, so a forwarding mixer polls the
+    // source at once instead of on its next tick. -1 if it can only be
+    // polled. Mixer thread, after open().
+    virtual int readyFd() { return -1; }
+
+protected:
+    bool isRecording() const { return m_recorder != nullptr; }
+    void record(StreamRecorder::Kind kind, const void *data, int size)
+    {
+        if (m_recorder) m_recorder->append(kind, m_index, data, size, monotonicNs());
+    }
+
+    ChannelUnit m_unit;
+    StreamRecorder *m_recorder;
+    int m_index;
+};
+
+// A channel output, written once per mixer tick
+class OutputSink : public ChannelEndpoint
+{
+public:
+    OutputSink(const QString &type, const QString &port) : ChannelEndpoint(type, port) {}
+
+    virtual bool write(const ChannelFrame &frame) = 0;
+};
+
+#endif // CHANNELIO_H
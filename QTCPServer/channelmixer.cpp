@@ -0,0 +1,368 @@
+#include "channelmixer.h"
+#include "monotime.h"
+
+// Wakeups in a row without a frame before a source is left to the tick, a
+// port in an error state is readable all the time
+static const int MAX_IDLE_WAKEUPS = 100;
+
+ChannelMixer::ChannelMixer(const QList<InputSource*> &sources, const QList<OutputSink*> &sinks, QObject *parent) :
+    QObject(parent), m_sinks(sinks), m_channelModel(nullptr), m_log(nullptr), m_latency(nullptr),
+    m_tickTimer(nullptr), m_spacingTimer(nullptr), m_forward(false), m_spacingNs(0), m_lastWriteNs(0),
+    m_healthTimer(nullptr), m_telemetryTimer(nullptr), m_telemetry(nullptr),
+    m_telemetryHz(0), m_tickMs(10), m_prefaultKb(0), m_failsafeDelayNs(0),
+    m_selected(-1), m_isFailSafe(false)
+{
+    foreach (InputSource *source, sources)
+    {
+        Input input;
+        input.source = source;
+        input.timeoutNs = 0;
+        input.lastUpdateNs = 0;
+        input.unsent = false;
+        input.notifier = nullptr;
+        input.idleWakeups = 0;
+        input.frame.count = 0;
+        input.frame.failsafe = false;
+        input.frame.rxNs = input.frame.readyNs = 0;
+        m_inputs.append(input);
+    }
+
+    m_output.count = 0;
+    m_output.failsafe = false;
+    m_output.rxNs = m_output.readyNs = 0;
+
+    setTimeouts(500, 500, 0);
+}
+
+ChannelMixer::~ChannelMixer()
+{
+    for (int i=0; i<m_inputs.count(); i++)
+    {
+        delete m_inputs[i].notifier;
+        m_inputs[i].source->close();
+        delete m_inputs[i].source;
+    }
+
+    foreach (OutputSink *sink, m_sinks)
+    {
+        sink->close();
+        delete sink;
+    }
+}
+
+void ChannelMixer::setEventLog(EventLog *log)
+{
+    m_log = log;
+    for (int i=0; i<m_inputs.count(); i++) m_inputs[i].source->setEventLog(log);
+    foreach (OutputSink *sink, m_sinks) sink->setEventLog(log);
+}
+
+void ChannelMixer::setTimeouts(int primaryMs, int secondaryMs, int failsafeDelayMs)
+{
+    for (int i=0; i<m_inputs.count(); i++)
+        m_inputs[i].timeoutNs = msToNs(i == 0 ? primaryMs : secondaryMs);
+    m_failsafeDelayNs = msToNs(failsafeDelayMs);
+}
+
+void ChannelMixer::setSourceTimeout(int index, int ms)
+{
+    if (index >= 0 && index < m_inputs.count())
+        m_inputs[index].timeoutNs = msToNs(ms);
+}
+
+void ChannelMixer::start()
+{
+    bool ok = true;
+    QString report = applyRealtime("Mixer", m_realtime, m_realtime.isDefault() ? 0 : m_prefaultKb, ok);
+    statusMsg(EventLog::General, ok ? report : "Warning: " + report);
+
+    open();
+
+    m_tickTimer = new QTimer(this);
+    m_tickTimer->setTimerType(Qt::PreciseTimer);
+    m_tickTimer->setInterval(qMax(1, m_tickMs));
+    connect(m_tickTimer, &QTimer::timeout, this, &ChannelMixer::tick);
+    m_tickTimer->start();
+
+    if (m_forward)
+    {
+        m_spacingTimer = new QTimer(this);
+        m_spacingTimer->setTimerType(Qt::PreciseTimer);
+        m_spacingTimer->setSingleShot(true);
+        connect(m_spacingTimer, &QTimer::timeout, this, &ChannelMixer::writePending);
+        for (int i=0; i<m_inputs.count(); i++) watchInput(i);
+        statusMsg(EventLog::General, QString("Forwarding input frames, at least %1 ms apart").arg(m_spacingNs / 1e6, 0, 'f', 1));
+    }
+
+    m_healthTimer = new QTimer(this);
+    m_healthTimer->setInterval(1000);
+    connect(m_healthTimer, &QTimer::timeout, this, &ChannelMixer::reportHealth);
+    m_healthTimer->start();
+
+    if (m_telemetry && m_telemetryHz > 0)
+    {
+        m_telemetryTimer = new QTimer(this);
+        m_telemetryTimer->setTimerType(Qt::PreciseTimer);
+        m_telemetryTimer->setInterval(qMax(1, 1000 / m_telemetryHz));
+        connect(m_telemetryTimer, &QTimer::timeout, this, &ChannelMixer::publishTelemetry);
+        m_telemetryTimer->start();
+    }
+}
+
+void ChannelMixer::open()
+{
+    for (int i=0; i<m_inputs.count(); i++) m_inputs[i].source->open();
+    foreach (OutputSink *sink, m_sinks) sink->open();
+}
+
+void ChannelMixer::reopenSource(int index, const QString &port)
+{
+    if (index < 0 || index >= m_inputs.count()) return;
+
+    Input &input = m_inputs[index];
+    if (input.source->isOpen() && input.source->port() == port) return;
+
+    // The descriptor goes away with the port
+    delete input.notifier;
+    input.notifier = nullptr;
+    input.source->close();
+    input.source->setPort(port);
+    input.lastUpdateNs = 0;
+    input.source->open();
+    if (m_forward) watchInput(index);
+}
+
+void ChannelMixer::watchInput(int index)
+{
+    Input &input = m_inputs[index];
+    input.idleWakeups = 0;
+    int fd = input.source->isOpen() ? input.source->readyFd() : -1;
+    if (fd < 0) return;
+
+    input.notifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(input.notifier, SIGNAL(activated(int)), this, SLOT(inputReady(int)));
+}
+
+void ChannelMixer::reopenSink(int index, const QString &port)
+{
+    if (index < 0 || index >= m_sinks.count()) return;
+
+    OutputSink *sink = m_sinks[index];
+    if (sink->isOpen() && sink->port() == port) return;
+
+    sink->close();
+    sink->setPort(port);
+    sink->open();
+}
+
+void ChannelMixer::tick()
+{
+    if (!m_forward)
+    {
+        process(monotonicNs());
+        return;
+    }
+
+    // Sources without a descriptor only come in here
+    qint64 now = monotonicNs();
+    bool fresh = false;
+    for (int i=0; i<m_inputs.count(); i++)
+        if (pollInput(i, now)) fresh = true;
+    if (fresh || now - m_lastWriteNs >= msToNs(m_tickMs) / 2)
+        scheduleWrite(now);
+}
+
+void ChannelMixer::process(qint64 now)
+{
+    qint64 started = monotonicNs();
+    for (int i=0; i<m_inputs.count(); i++) pollInput(i, now);
+    mix(now, started);
+}
+
+bool ChannelMixer::pollInput(int index, qint64 now)
+{
+    Input &input = m_inputs[index];
+    if (!input.source->isOpen() || !input.source->poll(input.frame))
+        return false;
+
+    input.lastUpdateNs = now;
+    input.unsent = true;
+    // Frames again after it was left to the tick
+    if (input.notifier && !input.notifier->isEnabled())
+    {
+        input.idleWakeups = 0;
+        input.notifier->setEnabled(true);
+    }
+    if (m_latency && input.frame.readyNs != 0)
+        m_latency->record(LatencyMonitor::StageHandoff, now - input.frame.readyNs);
+    return true;
+}
+
+void ChannelMixer::inputReady(int fd)
+{
+    int index = 0;
+    while (index < m_inputs.count() && !(m_inputs[index].notifier && m_inputs[index].notifier->socket() == fd)) index++;
+    if (index == m_inputs.count()) return;
+
+    Input &input = m_inputs[index];
+    qint64 now = monotonicNs();
+    if (!pollInput(index, now))
+    {
+        // Partial frames wake it too, only a long run means trouble
+        if (++input.idleWakeups >= MAX_IDLE_WAKEUPS)
+        {
+            input.notifier->setEnabled(false);
+            statusMsg(EventLog::ReadFailed, QString("'%1' keeps waking without frames, polled on the tick only").arg(input.source->name()));
+        }
+        return;
+    }
+    input.idleWakeups = 0;
+
+    // Not the input in use while a higher priority one is fresh
+    for (int i=0; i<index; i++)
+        if (m_inputs[i].lastUpdateNs != 0 && now - m_inputs[i].lastUpdateNs <= m_inputs[i].timeoutNs) return;
+    scheduleWrite(now);
+}
+
+// Now, or once the spacing since the previous write has passed
+void ChannelMixer::scheduleWrite(qint64 now)
+{
+    qint64 waitNs = m_lastWriteNs + m_spacingNs - now;
+    if (waitNs <= 0)
+    {
+        m_spacingTimer->stop();
+        mix(now, now);
+        return;
+    }
+    if (!m_spacingTimer->isActive())
+        m_spacingTimer->start(int((waitNs + 999999) / 1000000));
+}
+
+void ChannelMixer::writePending()
+{
+    qint64 now = monotonicNs();
+    mix(now, now);
+}
+
+void ChannelMixer::mix(qint64 now, qint64 started)
+{
+    // Highest priority fresh input, and the newest one as fallback
+    int selected = -1;
+    int newest = -1;
+    qint64 staleSince = 0;
+    for (int i=0; i<m_inputs.count(); i++)
+    {
+        const Input &input = m_inputs[i];
+        if (input.lastUpdateNs == 0) continue;
+
+        if (newest < 0 || input.lastUpdateNs > m_inputs[newest].lastUpdateNs)
+            newest = i;
+        if (selected < 0 && now - input.lastUpdateNs <= input.timeoutNs)
+            selected = i;
+        staleSince = qMax(staleSince, input.lastUpdateNs + input.timeoutNs);
+    }
+
+    // Nothing received yet, keep the outputs quiet
+    if (newest < 0) return;
+
+    bool failsafe = false;
+    if (selected < 0)
+    {
+        // All stale, hold the newest values until the failsafe delay ran out
+        selected = newest;
+        failsafe = now - staleSince >= m_failsafeDelayNs;
+    }
+
+    if (failsafe && !m_isFailSafe)
+    {
+        m_isFailSafe = true;
+        statusMsg(EventLog::Failsafe, QString("Failsafe occured"));
+    }
+    else if (!failsafe && m_isFailSafe)
+    {
+        m_isFailSafe = false;
+        statusMsg(EventLog::Failsafe, QString("Failsafe cleared by '%1'").arg(m_inputs[selected].source->name()));
+    }
+    else if (!failsafe && selected != m_selected)
+    {
+        statusMsg(EventLog::General, QString("Using input '%1'").arg(m_inputs[selected].source->name()));
+    }
+    m_selected = selected;
+
+    ChannelFrame frame;
+    m_pipeline.apply(m_inputs[selected].source->unit(), m_inputs[selected].frame, frame);
+    frame.failsafe = failsafe;
+
+    qint64 written = monotonicNs();
+    if (m_latency)
+        m_latency->record(LatencyMonitor::StageMix, written - started);
+
+    foreach (OutputSink *sink, m_sinks)
+    {
+        if (!sink->isOpen()) continue;
+
+        qint64 start = written;
+        sink->write(frame);
+        written = monotonicNs();
+        if (m_latency)
+            m_latency->record(LatencyMonitor::StageWrite, written - start);
+    }
+
+    // End to end only once, for the first write of the frame
+    if (m_latency && frame.rxNs != 0 && m_inputs[selected].unsent)
+        m_latency->record(LatencyMonitor::StageTotal, written - frame.rxNs);
+    for (int i=0; i<m_inputs.count(); i++) m_inputs[i].unsent = false;
+
+    m_output = frame;
+    m_lastWriteNs = written;
+
+    if (m_channelModel)
+    {
+        // Published for the UI, sampled by the GUI at its own rate
+        m_channelModel->publish(selected, frame.channels, frame.count);
+    }
+}
+
+void ChannelMixer::reportHealth()
+{
+    QStringList lines;
+    for (int i=0; i<m_inputs.count(); i++)
+    {
+        QString health = m_inputs[i].source->health();
+        if (!health.isEmpty()) lines << health;
+    }
+    foreach (OutputSink *sink, m_sinks)
+    {
+        QString health = sink->health();
+        if (!health.isEmpty()) lines << health;
+    }
+
+    if (!lines.isEmpty())
+        emit linkHealth(lines);
+}
+
+// Encoded here, where the serial statistics live, so the network thread only
+// copies bytes
+void ChannelMixer::publishTelemetry()
+{
+    Telemetry telemetry;
+    telemetry.failsafe = m_isFailSafe;
+    telemetry.source = m_selected;
+    telemetry.count = m_output.count;
+    for (int i=0; i<m_output.count; i++) telemetry.channels[i] = m_output.channels[i];
+
+    qint64 now = monotonicNs();
+    telemetry.inputCount = qMin(m_inputs.count(), TELEMETRY_MAX_INPUTS);
+    for (int i=0; i<telemetry.inputCount; i++)
+    {
+        const Input &input = m_inputs[i];
+        TelemetryInput &in = telemetry.inputs[i];
+        in = TelemetryInput();
+        input.source->telemetry(in);
+        if (input.source->isOpen()) in.flags |= TelemetryInput::Open;
+        if (input.lastUpdateNs != 0 && now - input.lastUpdateNs <= input.timeoutNs) in.flags |= TelemetryInput::Fresh;
+    }
+
+    char payload[TelemetrySlot::BYTES];
+    m_telemetry->publish(payload, encodeTelemetry(telemetry, payload));
+}
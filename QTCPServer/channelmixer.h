@@ -0,0 +1,119 @@
+#ifndef CHANNELMIXER_H
+#define CHANNELMIXER_H
+
+#include <QObject>
+#include <QList>
+#include <QSocketNotifier>
+#include <QStringList>
+#include <QTimer>
+#include "channelio.h"
+#include "channelmodel.h"
+#include "channelpipeline.h"
+#include "eventlog.h"
+#include "latency.h"
+#include "realtime.h"
+#include "telemetryslot.h"
+
+// Merges any number of input sources into any number of output sinks.
+// Runs on one thread: every tick it polls all sources, picks the highest
+// priority one that is fresh, runs its values through the channel pipeline
+// and writes them to every sink. When all
+// sources are stale the newest values are held for the failsafe delay, then
+// the sinks get failsafe.
+// With forwarding, sources with a descriptor to wait on are also read as
+// soon as it is readable, and a new frame of the input in use goes to the
+// sinks at once, no sooner than the output spacing after the previous
+// write. The tick then only writes when nothing went out for half a tick,
+// as a keep-alive and to run the failsafe timing.
+class ChannelMixer : public QObject
+{
+    Q_OBJECT
+public:
+    // Takes ownership of sources (highest priority first) and sinks
+    ChannelMixer(const QList<InputSource*> &sources, const QList<OutputSink*> &sinks, QObject *parent = nullptr);
+    ~ChannelMixer();
+
+    // Call before the mixer thread starts
+    void setChannelModel(ChannelModel *model) { m_channelModel = model; }
+    void setEventLog(EventLog *log);
+    void setLatencyMonitor(LatencyMonitor *latency) { m_latency = latency; }
+    void setTickInterval(int ms) { m_tickMs = ms; }
+    // Applied from start() on the mixer thread itself
+    void setRealtime(const RealtimeConfig &config, int prefaultKb) { m_realtime = config; m_prefaultKb = prefaultKb; }
+    void setTransforms(const QVector<ChannelTransform> &transforms) { m_pipeline.build(transforms); }
+    // The first source is stale after primaryMs, the others after secondaryMs
+    void setTimeouts(int primaryMs, int secondaryMs, int failsafeDelayMs);
+    // Own timeout for one source, after setTimeouts()
+    void setSourceTimeout(int index, int ms);
+    // Forward frames as they arrive, spacingUs apart at least
+    void setForwarding(bool enabled, int spacingUs) { m_forward = enabled; m_spacingNs = qint64(spacingUs) * 1000; }
+    // Publishes a telemetry snapshot to slot hz times a second, 0 disables
+    void setTelemetry(TelemetrySlot *slot, int hz) { m_telemetry = slot; m_telemetryHz = hz; }
+
+    // Opens all sources and sinks, start() does this on the mixer thread
+    void open();
+    // One tick at now (monotonicNs() or a replayed time), the timer calls it
+    void process(qint64 now);
+
+signals:
+    // Once a second, one line per source with something to report
+    void linkHealth(const QStringList &lines);
+
+public slots:
+    // Opens everything and starts ticking, queued from the owning thread
+    void start();
+    void reopenSource(int index, const QString &port);
+    void reopenSink(int index, const QString &port);
+
+private slots:
+    void tick();
+    void inputReady(int fd);
+    void writePending();
+    void reportHealth();
+    void publishTelemetry();
+
+private:
+    void statusMsg(EventLog::Type type, const QString &msg) { if (m_log) m_log->post(type, msg); }
+    // True if the source had a new frame
+    bool pollInput(int index, qint64 now);
+    // Selects an input and writes its values to the sinks
+    void mix(qint64 now, qint64 started);
+    void scheduleWrite(qint64 now);
+    void watchInput(int index);
+
+    struct Input
+    {
+        InputSource *source;
+        qint64 timeoutNs;
+        qint64 lastUpdateNs;    // monotonicNs(), 0 before the first frame
+        bool unsent;            // frame not written to the sinks yet
+        QSocketNotifier *notifier;  // forwarding only
+        int idleWakeups;        // readable without a new frame, in a row
+        ChannelFrame frame;
+    };
+
+    QList<Input> m_inputs;
+    QList<OutputSink*> m_sinks;
+    ChannelPipeline m_pipeline;
+    ChannelModel *m_channelModel;
+    EventLog *m_log;
+    LatencyMonitor *m_latency;
+    QTimer *m_tickTimer;
+    QTimer *m_spacingTimer;     // holds a forwarded frame back for the spacing
+    bool m_forward;
+    qint64 m_spacingNs;
+    qint64 m_lastWriteNs;
+    QTimer *m_healthTimer;
+    QTimer *m_telemetryTimer;
+    TelemetrySlot *m_telemetry;
+    int m_telemetryHz;
+    ChannelFrame m_output;      // last frame written to the sinks
+    int m_tickMs;
+    RealtimeConfig m_realtime;
+    int m_prefaultKb;
+    qint64 m_failsafeDelayNs;
+    int m_selected;
+    bool m_isFailSafe;
+};
+
+#endif // CHANNELMIXER_H
@@ -0,0 +1,90 @@
+#ifndef CHANNELMODEL_H
+#define CHANNELMODEL_H
+
+#include <QtGlobal>
+#include <atomic>
+
+// Latest channel values for display.
+// The control path writes into it without emitting signals, the GUI samples
+// it on its own timer. Readers never block writers (seqlock), writers only
+// spin against each other for the duration of a 16 value copy.
+class ChannelModel
+{
+public:
+    static const int MAX_CHANNELS = 16;
+
+    struct Snapshot
+    {
+        quint32 seq;
+        int source;         // index of the input in priority order, -1 if none
+        qint64 rxNs;        // optional monotonicNs() stamps carried with the values
+        qint64 readyNs;
+        int count;
+        int channels[MAX_CHANNELS];
+    };
+
+    ChannelModel() : m_seq(0), m_source(-1), m_count(0)
+    {
+        m_writer.clear();
+        m_rxNs.store(0, std::memory_order_relaxed);
+        m_readyNs.store(0, std::memory_order_relaxed);
+        for (int i=0; i<MAX_CHANNELS; i++) m_channels[i].store(0, std::memory_order_relaxed);
+    }
+
+    void publish(int source, const int *channels, int count, qint64 rxNs = 0, qint64 readyNs = 0)
+    {
+        if (count > MAX_CHANNELS) count = MAX_CHANNELS;
+
+        while (m_writer.test_and_set(std::memory_order_acquire)) {}
+
+        quint32 seq = m_seq.load(std::memory_order_relaxed);
+        m_seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        m_source.store(source, std::memory_order_relaxed);
+        m_rxNs.store(rxNs, std::memory_order_relaxed);
+        m_readyNs.store(readyNs, std::memory_order_relaxed);
+        m_count.store(count, std::memory_order_relaxed);
+        for (int i=0; i<count; i++)
+            m_channels[i].store(channels[i], std::memory_order_relaxed);
+
+        m_seq.store(seq + 2, std::memory_order_release);
+        m_writer.clear(std::memory_order_release);
+    }
+
+    // Even between publishes, what sample() returns as seq
+    quint32 seq() const { return m_seq.load(std::memory_order_acquire); }
+
+    // Copy out a consistent snapshot, seq changes on every publish
+    Snapshot sample() const
+    {
+        Snapshot snapshot;
+        quint32 before, after;
+        do
+        {
+            before = m_seq.load(std::memory_order_acquire);
+            snapshot.source = m_source.load(std::memory_order_relaxed);
+            snapshot.rxNs = m_rxNs.load(std::memory_order_relaxed);
+            snapshot.readyNs = m_readyNs.load(std::memory_order_relaxed);
+            snapshot.count = m_count.load(std::memory_order_relaxed);
+            for (int i=0; i<snapshot.count; i++)
+                snapshot.channels[i] = m_channels[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = m_seq.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+
+        snapshot.seq = before;
+        return snapshot;
+    }
+
+private:
+    std::atomic<quint32> m_seq;
+    std::atomic_flag m_writer;
+    std::atomic<int> m_source;
+    std::atomic<qint64> m_rxNs;
+    std::atomic<qint64> m_readyNs;
+    std::atomic<int> m_count;
+    std::atomic<int> m_channels[MAX_CHANNELS];
+};
+
+#endif // CHANNELMODEL_H
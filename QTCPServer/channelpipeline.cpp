@@ -0,0 +1,110 @@
+#include "channelpipeline.h"
+#include <QtMath>
+
+// SBUS and CRSF share the same raw scale, 172..1811 is 988..2012 us
+static const double RAW_CENTER = 992.0;
+static const double RAW_PER_US = 1.6;
+
+ChannelPipeline::ChannelPipeline() : m_count(ChannelModel::MAX_CHANNELS)
+{
+    for (int u=0; u<UnitCount; u++)
+        m_center[u] = u == UnitMicroseconds ? 1500 : int(RAW_CENTER);
+
+    build(QVector<ChannelTransform>(ChannelModel::MAX_CHANNELS));
+}
+
+double ChannelPipeline::toUs(ChannelUnit unit, double value)
+{
+    switch (unit)
+    {
+        case UnitSbus:
+        case UnitCrsf:
+            return (value - RAW_CENTER) / RAW_PER_US + 1500.0;
+        case UnitMicroseconds:
+        case UnitCount:
+            break;
+    }
+    return value;
+}
+
+double ChannelPipeline::sbusFromUs(double us)
+{
+    return (us - 1500.0) * RAW_PER_US + RAW_CENTER;
+}
+
+static double transform(const ChannelTransform &t, double us)
+{
+    double d = us - 1500.0;
+
+    if (t.reverse)
+        d = -d;
+
+    if (t.deadband > 0)
+    {
+        // Shrink the rest of the travel so the endpoints stay where they were
+        double band = qMin(double(t.deadband), 499.0);
+        double mag = qAbs(d) <= band ? 0.0 : (qAbs(d) - band) * 500.0 / (500.0 - band);
+        d = d < 0 ? -mag : mag;
+    }
+
+    if (t.expo > 0.0)
+    {
+        double n = d / 500.0;
+        n = (1.0 - t.expo) * n + t.expo * n * n * n;
+        d = n * 500.0;
+    }
+
+    d *= (d < 0 ? t.endpointLow : t.endpointHigh) / 100.0;
+
+    us = 1500.0 + d + t.trim;
+    return qBound(double(t.minUs), us, double(t.maxUs));
+}
+
+void ChannelPipeline::build(const QVector<ChannelTransform> &transforms)
+{
+    m_count = qMin(transforms.count(), int(ChannelModel::MAX_CHANNELS));
+
+    for (int i=0; i<m_count; i++)
+    {
+        int input = transforms.at(i).input;
+        m_inputs[i] = input >= 0 && input < ChannelModel::MAX_CHANNELS ? input : i;
+    }
+
+    for (int u=0; u<UnitCount; u++)
+    {
+        QVector<quint16> &lut = m_luts[u];
+        lut.resize(m_count * LUT_SIZE);
+
+        for (int i=0; i<m_count; i++)
+        {
+            const ChannelTransform &t = transforms.at(i);
+            for (int v=0; v<LUT_SIZE; v++)
+            {
+                double sbus = sbusFromUs(transform(t, toUs(ChannelUnit(u), v)));
+                lut[i * LUT_SIZE + v] = quint16(qBound(0, qRound(sbus), LUT_SIZE - 1));
+            }
+        }
+    }
+}
+
+bool ChannelPipeline::parseUnit(const QString &name, ChannelUnit &unit)
+{
+    QString lower = name.toLower();
+    if (lower == "sbus") unit = UnitSbus;
+    else if (lower == "crsf") unit = UnitCrsf;
+    else if (lower == "us") unit = UnitMicroseconds;
+    else return false;
+    return true;
+}
+
+QString ChannelPipeline::unitName(ChannelUnit unit)
+{
+    switch (unit)
+    {
+        case UnitSbus: return "sbus";
+        case UnitCrsf: return "crsf";
+        case UnitMicroseconds: return "us";
+        case UnitCount: break;
+    }
+    return "sbus";
+}
@@ -0,0 +1,67 @@
+#ifndef CHANNELPIPELINE_H
+#define CHANNELPIPELINE_H
+
+#include <QString>
+#include <QVector>
+#include "channelio.h"
+
+// Per output channel transform, applied in this order:
+// input unit remap, reverse, deadband, expo, endpoints, trim, clamp.
+// Values are in microseconds around a 1500 us center.
+struct ChannelTransform
+{
+    int input = -1;             // 0 based input channel, -1 keeps the channel's own
+    bool reverse = false;
+    int deadband = 0;           // us around center that map to center
+    double expo = 0.0;          // 0 linear .. 1 fully cubic
+    int endpointLow = 100;      // travel in percent below center
+    int endpointHigh = 100;     // travel in percent above center
+    int trim = 0;               // us added after scaling
+    int minUs = 0;              // hard limits, defaults cover the full SBUS range
+    int maxUs = 2160;
+};
+
+// Channel transforms compiled into lookup tables.
+// build() evaluates the whole curve once for every possible input value, so
+// apply() costs one table read per channel no matter what is configured.
+// Tables are built per input unit, outputs are always in SBUS units.
+class ChannelPipeline
+{
+public:
+    static const int LUT_SIZE = 2048;    // input values are clamped to 0..LUT_SIZE-1
+
+    ChannelPipeline();
+
+    // Not thread safe, call before the mixer thread starts
+    void build(const QVector<ChannelTransform> &transforms);
+
+    void apply(ChannelUnit unit, const ChannelFrame &in, ChannelFrame &out) const
+    {
+        const quint16 *lut = m_luts[unit].constData();
+        out.count = m_count;
+        out.failsafe = in.failsafe;
+        out.rxNs = in.rxNs;
+        out.readyNs = in.readyNs;
+        for (int i=0; i<m_count; i++)
+        {
+            int src = m_inputs[i];
+            int v = src < in.count ? in.channels[src] : m_center[unit];
+            if (v < 0) v = 0; else if (v >= LUT_SIZE) v = LUT_SIZE - 1;
+            out.channels[i] = lut[i * LUT_SIZE + v];
+        }
+    }
+
+    static bool parseUnit(const QString &name, ChannelUnit &unit);
+    static QString unitName(ChannelUnit unit);
+
+    static double toUs(ChannelUnit unit, double value);
+    static double sbusFromUs(double us);
+
+private:
+    QVector<quint16> m_luts[UnitCount];
+    int m_inputs[ChannelModel::MAX_CHANNELS];
+    int m_center[UnitCount];
+    int m_count;
+};
+
+#endif // CHANNELPIPELINE_H
@@ -0,0 +1,405 @@
+#include "clientprotocol.h"
+#include "textprotocol.h"
+
+ClientProtocol::ClientProtocol(const BridgeConfig &config, Stats &stats, LatencyMonitor *latency) :
+    m_stats(stats), m_latencyMonitor(latency), m_requireHello(config.requireHello), m_maxFrameAgeMs(config.maxFrameAgeMs)
+{
+}
+
+ClientProtocol::~ClientProtocol()
+{
+    qDeleteAll(m_sessions);
+}
+
+void ClientProtocol::initClient(Client &client, ControlArbiter *arbiter)
+{
+    client.controller = !m_requireHello;
+    client.announced = false;
+    client.arbiter = arbiter;
+    client.session = nullptr;
+    client.path = 0;
+    client.resumeToken = 0;
+    client.ageUs = -1;
+    client.framesReceived = 0;
+    client.framesLate = 0;
+    client.framesCoalesced = 0;
+    client.ageSumUs = 0;
+    client.ageCount = 0;
+}
+
+bool ClientProtocol::removeClient(Client *client)
+{
+    // The next controller still sending takes over at once
+    bool wasOwner = client->arbiter->release(client);
+    leaveSession(client);
+    if (client->resumeToken && m_resumeTokens.value(client->resumeToken) == client)
+        m_resumeTokens.remove(client->resumeToken);
+    return wasOwner;
+}
+
+void ClientProtocol::processStream(Client &client, qint64 rxNs)
+{
+    FrameReader &reader = client.reader;
+    for (;;)
+    {
+        switch (reader.next())
+        {
+        case FrameReader::NeedMore:
+            return;
+        case FrameReader::Text:
+            processMessage(reader.text(), client, rxNs);
+            break;
+        case FrameReader::Frame:
+            processFrame(reader.header(), reader.payload(), client, rxNs);
+            break;
+        case FrameReader::Invalid:
+            m_stats.rejected++;
+            statusMsg(EventLog::InvalidFrame, reader.error());
+            break;
+        }
+    }
+}
+
+void ClientProtocol::processMessage(const QString& str, Client &client, qint64 rxNs)
+{
+    int values[TEXT_MAX_CHANNELS];
+    int count = 0;
+    QString error;
+    if (!parseTextMessage(str, values, count, error))
+    {
+        if (!error.isEmpty())
+        {
+            m_stats.rejected++;
+            statusMsg(EventLog::InvalidFrame, error);
+        }
+        return;
+    }
+
+    submitValues(values, count, client, rxNs);
+}
+
+void ClientProtocol::processFrame(const FrameHeader &header, const char *payload, Client &client, qint64 rxNs)
+{
+    if (header.type == FrameHello)
+    {
+        processHello(header, payload, client);
+        return;
+    }
+    if (header.type == FrameRelease)
+    {
+        if (client.arbiter->release(&client))
+        {
+            statusMsg(EventLog::Network, QString("%1 handed back control").arg(clientName(client)));
+            sendControl(client);
+        }
+        return;
+    }
+    if (header.type == FrameSubscribe)
+    {
+        processSubscribe(header, payload, client);
+        return;
+    }
+    if (header.type == FramePath)
+    {
+        processPath(header, payload, client);
+        return;
+    }
+    if (header.type == FrameResume)
+    {
+        processResume(header, payload, client, rxNs);
+        return;
+    }
+    if (header.type == FramePong)
+    {
+        processPong(header, payload, client, rxNs);
+        return;
+    }
+
+    ChannelState &state = client.state;
+    const QString &peer = client.peer;
+    client.framesReceived++;
+    switch (state.apply(header, payload))
+    {
+    case ChannelState::Applied:
+        if (state.lastGap() > 0)
+            statusMsg(EventLog::FrameLoss, QString("%1 frames lost from %2 (%3 total)")
+                      .arg(state.lastGap()).arg(peer).arg(state.lost()));
+        if (!checkFrameAge(client, header.seq, rxNs))
+            break;
+        if (client.session)
+            submitPathValues(client, header.seq, rxNs);
+        else
+            submitValues(state.values(), state.count(), client, rxNs);
+        break;
+    case ChannelState::NoBase:
+        // Joined mid stream, the next heartbeat carries all channels
+        m_stats.stale++;
+        break;
+    case ChannelState::Stale:
+        m_stats.stale++;
+        client.framesLate++;
+        statusMsg(EventLog::FrameLoss, QString("Out of order frame (seq %1) from %2").arg(header.seq).arg(peer));
+        break;
+    case ChannelState::Invalid:
+        m_stats.rejected++;
+        statusMsg(EventLog::InvalidFrame, QString("Invalid frame type %1 (seq %2) from %3")
+                  .arg(header.type).arg(header.seq).arg(peer));
+        break;
+    }
+}
+
+void ClientProtocol::processHello(const FrameHeader &header, const char *payload, Client &client)
+{
+    ControlRole role;
+    int priority = 0;
+    QString name;
+    if (!decodeHello(payload, header.length, role, priority, name))
+    {
+        m_stats.rejected++;
+        statusMsg(EventLog::InvalidFrame, QString("Invalid hello from %1").arg(client.peer));
+        return;
+    }
+
+    client.controller = role == RoleController;
+    client.priority = priority;
+    client.name = name;
+    client.announced = true;
+    statusMsg(EventLog::Network, QString("%1 is %2, priority %3")
+              .arg(clientName(client)).arg(client.controller ? "a controller" : "an observer").arg(priority));
+
+    // A demoted owner lets go at once, a promoted client takes over with its next frame
+    if (!client.controller && client.arbiter->release(&client))
+        statusMsg(EventLog::Network, QString("%1 gave up control").arg(clientName(client)));
+    sendControl(client);
+}
+
+void ClientProtocol::processSubscribe(const FrameHeader &header, const char *payload, Client &client)
+{
+    int rateHz = 0;
+    if (!decodeSubscribe(payload, header.length, rateHz))
+    {
+        m_stats.rejected++;
+        statusMsg(EventLog::InvalidFrame, QString("Invalid subscribe from %1").arg(client.peer));
+        return;
+    }
+    subscribe(client, rateHz);
+}
+
+void ClientProtocol::processPath(const FrameHeader &header, const char *payload, Client &client)
+{
+    quint32 id = 0;
+    int path = 0;
+    if (!decodePath(payload, header.length, id, path))
+    {
+        m_stats.rejected++;
+        statusMsg(EventLog::InvalidFrame, QString("Invalid path frame from %1").arg(client.peer));
+        return;
+    }
+    // Its frames would go out as the session's, past the anchor's arbitration
+    if (!client.controller)
+    {
+        m_stats.refused++;
+        statusMsg(EventLog::Network, QString("%1 is no controller, not joining session %2")
+                  .arg(clientName(client)).arg(id, 8, 16, QChar('0')));
+        return;
+    }
+    if (client.session && client.session->id == id && client.path == path) return;
+
+    leaveSession(&client);
+    Session *&session = m_sessions[id];
+    if (!session)
+    {
+        session = new Session;
+        session->id = id;
+        session->paths[0] = session->paths[1] = nullptr;
+    }
+    // A reconnected path replaces the old connection
+    if (session->paths[path]) session->paths[path]->session = nullptr;
+    session->paths[path] = &client;
+    client.session = session;
+    client.path = path;
+    statusMsg(EventLog::Network, QString("%1 is path %2 of session %3").arg(clientName(client)).arg(path).arg(id, 8, 16, QChar('0')));
+}
+
+// A client back after its link dropped. Its old connection may still look
+// open here (TCP doesn't notice a dead link without data to send, a UDP
+// sender never disconnects) and still be in control: the new one takes over
+// its control at once instead of after the owner timeout, and the old one
+// is closed. Only a client that said what it is may resume, and only a
+// controller may take over or close a connection in control.
+void ClientProtocol::processResume(const FrameHeader &header, const char *payload, Client &client, qint64 rxNs)
+{
+    quint32 token = 0;
+    if (!decodeResume(payload, header.length, token) || token == 0)
+    {
+        m_stats.rejected++;
+        statusMsg(EventLog::InvalidFrame, QString("Invalid resume from %1").arg(client.peer));
+        return;
+    }
+    if (!client.announced) return;
+
+    Client *old = m_resumeTokens.value(token);
+    if (old && old != &client && old->arbiter->owner() == old && !client.controller)
+    {
+        m_stats.refused++;
+        statusMsg(EventLog::Network, QString("%1 is no controller, not resuming %2, which is in control")
+                  .arg(clientName(client), clientName(*old)));
+        return;
+    }
+
+    if (client.resumeToken && m_resumeTokens.value(client.resumeToken) == &client)
+        m_resumeTokens.remove(client.resumeToken);
+    client.resumeToken = token;
+    m_resumeTokens.insert(token, &client);
+    if (!old || old == &client) return;
+
+    m_stats.resumed++;
+    // The values go to the old connection's input, a TCP client may come back over UDP
+    if (old->arbiter == client.arbiter && old->arbiter->transfer(old, &client))
+    {
+        statusMsg(EventLog::Network, QString("%1 resumed %2, in control again %3 ms after its last frame")
+                  .arg(clientName(client), clientName(*old)).arg((rxNs - client.lastNs) / 1e6, 0, 'f', 1));
+        sendControl(client);
+    }
+    else
+    {
+        if (old->arbiter->release(old))
+            statusMsg(EventLog::Network, QString("%1 resumed %2, which was in control on another input")
+                      .arg(clientName(client), clientName(*old)));
+        else
+            statusMsg(EventLog::Network, QString("%1 resumed %2").arg(clientName(client), clientName(*old)));
+    }
+
+    old->resumeToken = 0;
+    dropClient(old);
+}
+
+void ClientProtocol::processPong(const FrameHeader &header, const char *payload, Client &client, qint64 rxNs)
+{
+    quint64 serverUs = 0, receivedUs = 0, sentUs = 0;
+    if (!decodePong(payload, header.length, serverUs, receivedUs, sentUs))
+    {
+        m_stats.rejected++;
+        statusMsg(EventLog::InvalidFrame, QString("Invalid pong from %1").arg(client.peer));
+        return;
+    }
+
+    ClockSync &clock = client.clock;
+    bool first = !clock.isValid();
+    if (!clock.sample(qint64(serverUs), qint64(receivedUs), qint64(sentUs), rxNs / 1000))
+    {
+        m_stats.rejected++;
+        statusMsg(EventLog::InvalidFrame, QString("Inconsistent pong times from %1").arg(client.peer));
+        return;
+    }
+    if (first)
+        statusMsg(EventLog::Network, QString("%1: clock offset %2 ms, RTT %3 ms")
+                  .arg(clientName(client)).arg(clock.offsetUs() / 1000.0, 0, 'f', 1).arg(clock.rttUs() / 1000.0, 0, 'f', 1));
+}
+
+// Age of a frame with a sender time from a client whose clock offset is
+// known, false if it is older than the configured maximum
+bool ClientProtocol::checkFrameAge(Client &client, quint32 seq, qint64 rxNs)
+{
+    quint64 stampUs = client.state.stampUs();
+    if (!stampUs || !client.clock.isValid())
+    {
+        client.ageUs = -1;
+        return true;
+    }
+
+    // Slightly negative when the offset is off by more than the delay
+    qint64 ageUs = qMax(qint64(0), rxNs / 1000 - client.clock.toServerUs(qint64(stampUs)));
+    client.ageUs = ageUs;
+    client.ageSumUs += ageUs;
+    client.ageCount++;
+    if (m_latencyMonitor) m_latencyMonitor->record(LatencyMonitor::StageAge, ageUs * 1000);
+    if (m_maxFrameAgeMs <= 0 || ageUs <= qint64(m_maxFrameAgeMs) * 1000)
+        return true;
+
+    m_stats.tooOld++;
+    client.framesLate++;
+    statusMsg(EventLog::FrameLoss, QString("Frame %1 from %2 is %3 ms old, dropped")
+              .arg(seq).arg(client.peer).arg(ageUs / 1000.0, 0, 'f', 1));
+    return false;
+}
+
+// First copy of each frame wins, whichever path it came on. A path whose
+// client became an observer after joining moves nothing.
+void ClientProtocol::submitPathValues(Client &client, quint32 seq, qint64 rxNs)
+{
+    if (!client.controller)
+    {
+        m_stats.refused++;
+        return;
+    }
+
+    Session *session = client.session;
+    switch (session->dedup.submit(client.path, seq, rxNs))
+    {
+    case PathDedup::First:
+        break;
+    case PathDedup::Duplicate:
+        m_stats.duplicates++;
+        return;
+    case PathDedup::Late:
+        m_stats.stale++;
+        return;
+    }
+
+    submitValues(client.state.values(), client.state.count(), *session->anchor(), rxNs);
+}
+
+void ClientProtocol::leaveSession(Client *client)
+{
+    Session *session = client->session;
+    if (!session) return;
+
+    // The other path carries on, under its own control state
+    if (session->anchor() == client) client->arbiter->release(client);
+    session->paths[client->path] = nullptr;
+    client->session = nullptr;
+    if (!session->anchor())
+    {
+        m_sessions.remove(session->id);
+        delete session;
+    }
+}
+
+void ClientProtocol::submitValues(const int *values, int count, Client &client, qint64 rxNs)
+{
+    ControlArbiter::Client *previous = nullptr;
+    switch (client.arbiter->submit(&client, rxNs, previous))
+    {
+    case ControlArbiter::Refused:
+        m_stats.refused++;
+        return;
+    case ControlArbiter::TookOver:
+        if (previous)
+        {
+            // Every client of an arbiter is one of ours
+            Client *old = static_cast<Client*>(previous);
+            statusMsg(EventLog::Network, QString("%1 took control from %2").arg(clientName(client), clientName(*old)));
+            sendControl(*old);
+        }
+        else
+        {
+            statusMsg(EventLog::Network, QString("%1 took control").arg(clientName(client)));
+        }
+        sendControl(client);
+        break;
+    case ControlArbiter::Owner:
+        break;
+    }
+
+    m_stats.accepted++;
+    if (submitToInput(client, values, count, rxNs))
+        client.framesCoalesced++;
+}
+
+QString ClientProtocol::clientName(const Client &client) const
+{
+    QString name = QString("Client %1 (%2").arg(client.id).arg(client.peer);
+    if (!client.name.isEmpty()) name += ", " + client.name;
+    return name + ")";
+}
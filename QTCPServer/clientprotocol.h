@@ -0,0 +1,126 @@
+#ifndef CLIENTPROTOCOL_H
+#define CLIENTPROTOCOL_H
+
+#include <QHash>
+#include <QString>
+#include "bridgeconfig.h"
+#include "clocksync.h"
+#include "controlarbiter.h"
+#include "eventlog.h"
+#include "joystickprotocol.h"
+#include "latency.h"
+#include "pathdedup.h"
+
+// What the network clients send and the rules applied to it: hellos and
+// handbacks, resumed connections, telemetry subscriptions, dual path
+// sessions, clock offsets from pongs and channel frames through the age
+// check and arbitration. The engine and the replay tool both run their
+// clients through it, so a recording replays the way it went live.
+// The owner keeps the clients and decides through the virtual functions
+// where accepted values go and who hears about control changes.
+class ClientProtocol
+{
+public:
+    // Frames and messages of all clients since start
+    struct Stats
+    {
+        quint64 accepted = 0;       // messages and frames that updated an input
+        quint64 rejected = 0;       // malformed, corrupt or unknown
+        quint64 stale = 0;          // out of order, or a delta before a full frame
+        quint64 refused = 0;        // valid, but the sender isn't in control
+        quint64 duplicates = 0;     // second copies of dual path frames
+        quint64 tooOld = 0;         // older than the maximum frame age on arrival
+        quint64 resumed = 0;        // reconnected clients that took over their old connection
+    };
+
+    // Per client state, TCP delivers messages split across reads and delta
+    // frames build on the sender's previous frames. UDP senders get one too.
+    // The id also tells interleaved clients apart in a recording.
+    struct Session;
+    struct Client : ControlArbiter::Client
+    {
+        QString peer;           // address:port for messages
+        QString name;           // from its hello
+        bool announced;         // sent a hello, understands control frames
+        ControlArbiter *arbiter;
+        Session *session;       // when it is one path of a dual path client
+        int path;
+        quint32 resumeToken;    // the same client's earlier connection had it too, 0 none
+        ClockSync clock;        // from the pings it answered
+        qint64 ageUs;           // of its last frame with a sender time, -1 none yet
+        // Channel frames, reported back in its feedback
+        quint32 framesReceived;
+        quint32 framesLate;
+        quint32 framesCoalesced;
+        qint64 ageSumUs;        // since the last feedback
+        int ageCount;
+        FrameReader reader;
+        ChannelState state;
+    };
+
+    // A client sending every frame over two connections. The values go
+    // through the first path still connected, so they feed one input and
+    // one arbitration whichever path wins.
+    struct Session
+    {
+        quint32 id;
+        Client *paths[FRAME_PATHS];
+        PathDedup dedup;
+
+        Client *anchor() const { return paths[0] ? paths[0] : paths[1]; }
+    };
+
+    // Counts into stats, which the owner may extend, and records frame ages
+    // in latency if given
+    ClientProtocol(const BridgeConfig &config, Stats &stats, LatencyMonitor *latency = nullptr);
+    virtual ~ClientProtocol();
+
+    const QHash<quint32, Session*> &sessions() const { return m_sessions; }
+
+protected:
+    // A new client, controlling through arbiter
+    void initClient(Client &client, ControlArbiter *arbiter);
+    // Everything complete in the client's reader, rxNs when it was read
+    void processStream(Client &client, qint64 rxNs);
+    // A client gone, lets go of its control, its path and its resume token,
+    // true if it was in control
+    bool removeClient(Client *client);
+
+    QString clientName(const Client &client) const;
+    virtual void statusMsg(EventLog::Type type, const QString &msg) = 0;
+
+    // Values of client, which won arbitration (the anchor of a dual path
+    // session), for its input. True if the previous values were replaced
+    // before the mixer took them.
+    virtual bool submitToInput(Client &client, const int *values, int count, qint64 rxNs) = 0;
+    // The owner of the client's input or the client's role changed
+    virtual void sendControl(Client &) {}
+    // Telemetry every rateHz, 0 stops it
+    virtual void subscribe(Client &, int) {}
+    // The old connection of a resumed client, its control already passed on
+    // or released: close it, and remove and delete it unless closing does
+    virtual void dropClient(Client *client) = 0;
+
+    Stats &m_stats;
+
+private:
+    void processMessage(const QString &str, Client &client, qint64 rxNs);
+    void processFrame(const FrameHeader &header, const char *payload, Client &client, qint64 rxNs);
+    void processHello(const FrameHeader &header, const char *payload, Client &client);
+    void processSubscribe(const FrameHeader &header, const char *payload, Client &client);
+    void processPath(const FrameHeader &header, const char *payload, Client &client);
+    void processResume(const FrameHeader &header, const char *payload, Client &client, qint64 rxNs);
+    void processPong(const FrameHeader &header, const char *payload, Client &client, qint64 rxNs);
+    bool checkFrameAge(Client &client, quint32 seq, qint64 rxNs);
+    void submitPathValues(Client &client, quint32 seq, qint64 rxNs);
+    void submitValues(const int *values, int count, Client &client, qint64 rxNs);
+    void leaveSession(Client *client);
+
+    LatencyMonitor *m_latencyMonitor;
+    bool m_requireHello;
+    int m_maxFrameAgeMs;
+    QHash<quint32, Session*> m_sessions;
+    QHash<quint32, Client*> m_resumeTokens;     // latest connection of each client sending one
+};
+
+#endif // CLIENTPROTOCOL_H
@@ -0,0 +1,65 @@
+#ifndef CLOCKSYNC_H
+#define CLOCKSYNC_H
+
+#include <QtGlobal>
+
+// Offset of a client's monotonic clock from the server's, NTP style.
+// For one ping, t1 server send, t2 client receive, t3 client send and
+// t4 server receive, in microseconds of either clock:
+//   rtt = (t4 - t1) - (t3 - t2), offset = ((t2 - t1) + (t3 - t4)) / 2
+// The offset is exact when both directions take as long, queueing only adds
+// delay, so of the last SAMPLES pings the one with the lowest RTT is used.
+class ClockSync
+{
+public:
+    static const int SAMPLES = 8;
+
+    ClockSync() : m_next(0), m_count(0), m_offsetUs(0), m_rttUs(0), m_lastRttUs(0) {}
+
+    // False if the times can't be from one exchange
+    bool sample(qint64 t1, qint64 t2, qint64 t3, qint64 t4)
+    {
+        qint64 rtt = (t4 - t1) - (t3 - t2);
+        if (rtt < 0 || t3 < t2) return false;
+
+        Sample &s = m_samples[m_next];
+        s.rttUs = rtt;
+        s.offsetUs = ((t2 - t1) + (t3 - t4)) / 2;
+        m_next = (m_next + 1) % SAMPLES;
+        if (m_count < SAMPLES) m_count++;
+        m_lastRttUs = rtt;
+
+        const Sample *best = &m_samples[0];
+        for (int i=1; i<m_count; i++)
+            if (m_samples[i].rttUs < best->rttUs) best = &m_samples[i];
+        m_offsetUs = best->offsetUs;
+        m_rttUs = best->rttUs;
+        return true;
+    }
+
+    bool isValid() const { return m_count > 0; }
+    // Client clock minus server clock
+    qint64 offsetUs() const { return m_offsetUs; }
+    // Of the sample the offset comes from, the error bound is half of it
+    qint64 rttUs() const { return m_rttUs; }
+    qint64 lastRttUs() const { return m_lastRttUs; }
+
+    // Server time of a client time
+    qint64 toServerUs(qint64 clientUs) const { return clientUs - m_offsetUs; }
+
+private:
+    struct Sample
+    {
+        qint64 offsetUs;
+        qint64 rttUs;
+    };
+
+    Sample m_samples[SAMPLES];
+    int m_next;
+    int m_count;
+    qint64 m_offsetUs;
+    qint64 m_rttUs;
+    qint64 m_lastRttUs;
+};
+
+#endif // CLOCKSYNC_H
@@ -0,0 +1,83 @@
+#ifndef CONTROLARBITER_H
+#define CONTROLARBITER_H
+
+#include <QtGlobal>
+
+// Decides which network client moves the vehicle through one input.
+// One client owns the input at a time:
+// - a controller with a higher priority than the owner takes over at its
+//   next frame
+// - one with the same or a lower priority only once the owner hands back or
+//   has sent nothing for the owner timeout, so when the owner goes quiet the
+//   first controller still sending takes over, and a higher one preempts it
+// - observers never own it
+// Each frame looks at its sender and the owner only, O(1) whatever the
+// number of clients.
+class ControlArbiter
+{
+public:
+    struct Client
+    {
+        quint16 id = 0;
+        bool controller = true;
+        int priority = 0;
+        qint64 lastNs = 0;      // last frame accepted from it as the owner
+    };
+
+    enum Result
+    {
+        Owner,      // already in control
+        TookOver,   // in control from this frame on
+        Refused
+    };
+
+    ControlArbiter() : m_owner(nullptr), m_timeoutNs(0) {}
+
+    void setTimeout(qint64 ns) { m_timeoutNs = ns; }
+
+    // A channel frame from client, previous is set to the replaced owner
+    // (or null) on TookOver
+    Result submit(Client *client, qint64 nowNs, Client *&previous)
+    {
+        if (client == m_owner)
+        {
+            client->lastNs = nowNs;
+            return Owner;
+        }
+        if (!client->controller)
+            return Refused;
+        if (m_owner && client->priority <= m_owner->priority && nowNs - m_owner->lastNs <= m_timeoutNs)
+            return Refused;
+
+        previous = m_owner;
+        m_owner = client;
+        client->lastNs = nowNs;
+        return TookOver;
+    }
+
+    // Handback, disconnect or demotion to observer, true if client was the owner
+    bool release(Client *client)
+    {
+        if (client != m_owner) return false;
+        m_owner = nullptr;
+        return true;
+    }
+
+    // A client's new connection replacing its old one, true if from was the
+    // owner and to is in control now, whatever the priorities
+    bool transfer(Client *from, Client *to)
+    {
+        if (from != m_owner || !to->controller) return false;
+        m_owner = to;
+        to->lastNs = from->lastNs;
+        return true;
+    }
+
+    Client *owner() const { return m_owner; }
+
+private:
+    Client *m_owner;
+    qint64 m_timeoutNs;
+};
+
+#endif // CONTROLARBITER_H
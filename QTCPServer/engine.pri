@@ -0,0 +1,60 @@
+# Bridge engine without GUI dependencies, shared by the GUI and the headless daemon
+
+QT += network
+
+SOURCES += \
+    $$PWD/bridgeconfig.cpp \
+    $$PWD/bridgeengine.cpp \
+    $$PWD/channelmixer.cpp \
+    $$PWD/channelpipeline.cpp \
+    $$PWD/clientprotocol.cpp \
+    $$PWD/eventlog.cpp \
+    $$PWD/latency.cpp \
+    $$PWD/realtime.cpp \
+    $$PWD/recorder.cpp \
+    $$PWD/serialio.cpp \
+    $$PWD/shminput.cpp \
+    $$PWD/textprotocol.cpp \
+    $$PWD/CrsfSerial/CrsfSerial.cpp \
+    $$PWD/crc8/crc8.cpp
+
+HEADERS += \
+    $$PWD/bridgeconfig.h \
+    $$PWD/bridgeengine.h \
+    $$PWD/channelio.h \
+    $$PWD/channelmixer.h \
+    $$PWD/channelmodel.h \
+    $$PWD/clientprotocol.h \
+    $$PWD/clocksync.h \
+    $$PWD/channelpipeline.h \
+    $$PWD/controlarbiter.h \
+    $$PWD/eventlog.h \
+    $$PWD/latency.h \
+    $$PWD/monotime.h \
+    $$PWD/networkinput.h \
+    $$PWD/pathdedup.h \
+    $$PWD/realtime.h \
+    $$PWD/recorder.h \
+    $$PWD/sendqueue.h \
+    $$PWD/serialio.h \
+    $$PWD/shmchannels.h \
+    $$PWD/shminput.h \
+    $$PWD/telemetryslot.h \
+    $$PWD/textprotocol.h \
+    $$PWD/CrsfSerial/crsf_protocol.h \
+    $$PWD/CrsfSerial/CrsfSerial.h \
+    $$PWD/crc8/crc8.h
+
+INCLUDEPATH += $$PWD
+INCLUDEPATH += $$PWD/raspberry-sbus/src/driver/include
+INCLUDEPATH += $$PWD/raspberry-sbus/src/common/include
+INCLUDEPATH += $$PWD/raspberry-sbus/src/decoder/include
+INCLUDEPATH += $$PWD/raspberry-sbus/src/tty/include
+INCLUDEPATH += $$PWD/CrsfSerial
+INCLUDEPATH += $$PWD/crc8
+
+include($$PWD/../JoystickProtocol/joystickprotocol.pri)
+
+LIBS += -L$$PWD/raspberry-sbus/build/debug/src -llibsbus
+# shm_open() lives in librt before glibc 2.34
+LIBS += -lrt
@@ -0,0 +1,215 @@
+#include "eventlog.h"
+#include <QDateTime>
+#include <QTextStream>
+#include "monotime.h"
+#include <limits>
+#include <string.h>
+
+EventLog::EventLog() : m_head(0), m_tail(0), m_dropped(0)
+{
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+
+    for (int i=0; i<CAPACITY; i++)
+        m_slots[i].seq.store(quint32(i), std::memory_order_relaxed);
+
+    for (int i=0; i<TypeCount; i++)
+    {
+        // far enough in the past that the first message always passes
+        m_types[i].lastPostNs.store(std::numeric_limits<qint64>::min() / 2, std::memory_order_relaxed);
+        m_types[i].suppressed.store(0, std::memory_order_relaxed);
+        m_types[i].rateLimitMs.store(0, std::memory_order_relaxed);
+        m_types[i].lastDrainNs = 0;
+    }
+
+    setDefaultRateLimit(1000);
+}
+
+EventLog::~EventLog()
+{
+    if (m_file.isOpen())
+    {
+        drain();
+        m_file.close();
+    }
+}
+
+void EventLog::setRateLimit(Type type, int ms)
+{
+    m_types[type].rateLimitMs.store(ms, std::memory_order_relaxed);
+}
+
+void EventLog::setDefaultRateLimit(int ms)
+{
+    setRateLimit(InvalidFrame, ms);
+    setRateLimit(FrameLoss, ms);
+    setRateLimit(PortError, ms);
+    setRateLimit(WriteFailed, ms);
+    setRateLimit(ReadFailed, ms);
+}
+
+bool EventLog::setFile(const QString &path)
+{
+    if (m_file.isOpen())
+        m_file.close();
+
+    if (path.isEmpty())
+        return true;
+
+    m_file.setFileName(path);
+    return m_file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text);
+}
+
+bool EventLog::post(Type type, const QString &msg)
+{
+    TypeState &state = m_types[type];
+    qint64 now = monotonicNs();
+    qint64 limitNs = msToNs(state.rateLimitMs.load(std::memory_order_relaxed));
+
+    qint64 last = state.lastPostNs.load(std::memory_order_relaxed);
+    if (limitNs > 0 &&
+        (now - last < limitNs ||
+         !state.lastPostNs.compare_exchange_strong(last, now, std::memory_order_relaxed)))
+    {
+        // Too soon, or another thread just posted this type
+        state.suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (limitNs <= 0)
+        state.lastPostNs.store(now, std::memory_order_relaxed);
+
+    Entry entry;
+    entry.timeMs = QDateTime::currentMSecsSinceEpoch();
+    entry.type = type;
+    entry.repeats = state.suppressed.exchange(0, std::memory_order_relaxed);
+
+    QByteArray utf8 = msg.toUtf8();
+    int len = qMin(utf8.size(), TEXT_SIZE - 1);
+    // don't cut a multi byte character in half
+    while (len > 0 && len < utf8.size() && (uchar(utf8.at(len)) & 0xC0) == 0x80) len--;
+    memcpy(entry.text, utf8.constData(), size_t(len));
+    entry.text[len] = '\0';
+
+    if (!push(entry))
+    {
+        m_dropped.fetch_add(1 + entry.repeats, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+// Bounded multi producer, single consumer queue, each slot carries the
+// ring position it is ready for so producers only contend on m_head.
+bool EventLog::push(const Entry &entry)
+{
+    quint32 pos = m_head.load(std::memory_order_relaxed);
+    Slot *slot;
+    for (;;)
+    {
+        slot = &m_slots[pos & (CAPACITY - 1)];
+        quint32 seq = slot->seq.load(std::memory_order_acquire);
+        qint32 diff = qint32(seq - pos);
+        if (diff == 0)
+        {
+            if (m_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+        {
+            return false;   // full
+        }
+        else
+        {
+            pos = m_head.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->entry = entry;
+    slot->seq.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+bool EventLog::pop(Entry &entry)
+{
+    Slot *slot = &m_slots[m_tail & (CAPACITY - 1)];
+    quint32 seq = slot->seq.load(std::memory_order_acquire);
+    if (qint32(seq - (m_tail + 1)) < 0)
+        return false;   // empty
+
+    entry = slot->entry;
+    slot->seq.store(m_tail + CAPACITY, std::memory_order_release);
+    m_tail++;
+    return true;
+}
+
+QStringList EventLog::drain(int max)
+{
+    QStringList lines;
+    Entry entry;
+
+    while (lines.count() < max && pop(entry))
+    {
+        TypeState &state = m_types[entry.type];
+        QString text = QString::fromUtf8(entry.text);
+
+        if (entry.repeats > 0 && text == state.lastText)
+        {
+            lines << format(entry.timeMs, text, entry.repeats + 1);
+        }
+        else
+        {
+            if (entry.repeats > 0)
+                lines << format(entry.timeMs, state.lastText, entry.repeats);
+            lines << format(entry.timeMs, text, 1);
+        }
+
+        state.lastText = text;
+    }
+
+    // Report repeats of types that went quiet, otherwise they would only
+    // show up with the next message of the same type
+    qint64 now = monotonicNs();
+    for (int i=0; i<TypeCount; i++)
+    {
+        TypeState &state = m_types[i];
+        qint64 limitNs = msToNs(state.rateLimitMs.load(std::memory_order_relaxed));
+        if (state.suppressed.load(std::memory_order_relaxed) == 0 ||
+            now - state.lastPostNs.load(std::memory_order_relaxed) < limitNs ||
+            now - state.lastDrainNs < limitNs)
+            continue;
+
+        quint32 repeats = state.suppressed.exchange(0, std::memory_order_relaxed);
+        if (repeats > 0)
+        {
+            lines << format(QDateTime::currentMSecsSinceEpoch(),
+                            state.lastText.isEmpty() ? QString("Message type %1").arg(i) : state.lastText,
+                            repeats);
+            state.lastDrainNs = now;
+        }
+    }
+
+    quint32 dropped = m_dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0)
+        lines << format(QDateTime::currentMSecsSinceEpoch(), QString("%1 log messages dropped, log full").arg(dropped), 1);
+
+    writeFile(lines);
+    return lines;
+}
+
+QString EventLog::format(qint64 timeMs, const QString &text, quint32 count) const
+{
+    QString line = QDateTime::fromMSecsSinceEpoch(timeMs).toString("hh:mm:ss.zzz") + " " + text;
+    if (count > 1)
+        line += QString(" (x %1)").arg(count);
+    return line;
+}
+
+void EventLog::writeFile(const QStringList &lines)
+{
+    if (!m_file.isOpen() || lines.isEmpty())
+        return;
+
+    QTextStream out(&m_file);
+    foreach (const QString &line, lines)
+        out << line << "\n";
+    out.flush();
+}
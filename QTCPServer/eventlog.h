@@ -0,0 +1,94 @@
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <atomic>
+
+// Bounded status message log shared by all threads.
+// post() is lock free and never blocks: messages go into a fixed size ring,
+// each message type is rate limited and suppressed repeats are counted
+// instead of queued. A single consumer calls drain() on a timer to format
+// the pending messages, append them to the optional log file and hand them
+// to whatever view is attached.
+class EventLog
+{
+public:
+    enum Type
+    {
+        General,
+        Network,
+        InvalidFrame,
+        PortOpen,
+        PortError,
+        WriteFailed,
+        ReadFailed,
+        Failsafe,
+        Latency,
+        FrameLoss,
+        TypeCount
+    };
+
+    static const int CAPACITY = 256;     // power of two
+    static const int TEXT_SIZE = 160;
+
+    EventLog();
+    ~EventLog();
+
+    // Minimum time between two messages of a type, repeats in between are
+    // collapsed into a "(x N)" count. 0 disables rate limiting for the type.
+    void setRateLimit(Type type, int ms);
+    // Applies ms to every type that floods when a port or link is down
+    void setDefaultRateLimit(int ms);
+
+    // Also append drained messages to a file, empty path closes it
+    bool setFile(const QString &path);
+
+    // Any thread, never blocks. Returns false if the message was dropped
+    // because it was rate limited or the ring was full.
+    bool post(Type type, const QString &msg);
+
+    // Consumer only. Returns at most max formatted lines.
+    QStringList drain(int max = CAPACITY);
+
+private:
+    struct Entry
+    {
+        qint64 timeMs;      // wall clock, for display only
+        int type;
+        quint32 repeats;    // messages of this type suppressed before this one
+        char text[TEXT_SIZE];
+    };
+
+    struct Slot
+    {
+        std::atomic<quint32> seq;
+        Entry entry;
+    };
+
+    struct TypeState
+    {
+        std::atomic<qint64> lastPostNs;
+        std::atomic<quint32> suppressed;
+        std::atomic<int> rateLimitMs;
+        // consumer only
+        QString lastText;
+        qint64 lastDrainNs;
+    };
+
+    bool push(const Entry &entry);
+    bool pop(Entry &entry);
+    QString format(qint64 timeMs, const QString &text, quint32 count) const;
+    void writeFile(const QStringList &lines);
+
+    Slot m_slots[CAPACITY];
+    std::atomic<quint32> m_head;
+    quint32 m_tail;
+    std::atomic<quint32> m_dropped;
+
+    TypeState m_types[TypeCount];
+    QFile m_file;
+};
+
+#endif // EVENTLOG_H
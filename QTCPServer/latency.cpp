@@ -0,0 +1,117 @@
+#include "latency.h"
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+void LatencyHistogram::reset()
+{
+    for (int i=0; i<BUCKETS; i++) m_buckets[i].store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+int LatencyHistogram::bucketOf(quint64 ns)
+{
+    if (ns < 16)
+        return int(ns);
+
+    int exponent = 63 - __builtin_clzll(ns);     // >= 4
+    int sub = int(ns >> (exponent - 3)) & (SUB_BUCKETS - 1);
+    return 16 + (exponent - 4) * SUB_BUCKETS + sub;
+}
+
+qint64 LatencyHistogram::upperBound(int bucket)
+{
+    if (bucket < 16)
+        return bucket;
+
+    int exponent = (bucket - 16) / SUB_BUCKETS + 4;
+    int sub = (bucket - 16) % SUB_BUCKETS;
+    quint64 low = (quint64(SUB_BUCKETS + sub)) << (exponent - 3);
+    return qint64(low + (quint64(1) << (exponent - 3)) - 1);
+}
+
+void LatencyHistogram::record(qint64 ns)
+{
+    if (ns < 0) ns = 0;
+
+    m_buckets[bucketOf(quint64(ns))].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+
+    qint64 max = m_max.load(std::memory_order_relaxed);
+    while (ns > max && !m_max.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {}
+}
+
+LatencyHistogram::Summary LatencyHistogram::summary() const
+{
+    quint32 counts[BUCKETS];
+    quint64 total = 0;
+    for (int i=0; i<BUCKETS; i++)
+    {
+        counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+
+    Summary summary;
+    summary.count = total;
+    summary.maxNs = m_max.load(std::memory_order_relaxed);
+    summary.p50Ns = summary.p99Ns = summary.p999Ns = 0;
+    if (total == 0)
+        return summary;
+
+    // Smallest bucket whose cumulative count reaches the rank
+    const quint64 ranks[3] = { (total * 500 + 999) / 1000, (total * 990 + 999) / 1000, (total * 999 + 999) / 1000 };
+    qint64 *results[3] = { &summary.p50Ns, &summary.p99Ns, &summary.p999Ns };
+    quint64 seen = 0;
+    int next = 0;
+    for (int i=0; i<BUCKETS && next<3; i++)
+    {
+        seen += counts[i];
+        while (next < 3 && seen >= ranks[next])
+        {
+            *results[next] = qMin(upperBound(i), summary.maxNs);
+            next++;
+        }
+    }
+    return summary;
+}
+
+void LatencyMonitor::reset()
+{
+    for (int i=0; i<StageCount; i++) m_stages[i].reset();
+}
+
+QString LatencyMonitor::stageName(Stage stage)
+{
+    switch (stage)
+    {
+        case StageAge: return "age";
+        case StageParse: return "parse";
+        case StageHandoff: return "handoff";
+        case StageMix: return "mix";
+        case StageWrite: return "write";
+        case StageTotal: return "total";
+        case StageCount: break;
+    }
+    return QString();
+}
+
+QStringList LatencyMonitor::report() const
+{
+    QStringList lines;
+    for (int i=0; i<StageCount; i++)
+    {
+        LatencyHistogram::Summary s = m_stages[i].summary();
+        if (s.count == 0) continue;
+
+        lines << QString("Latency %1: n %2 p50 %3 p99 %4 p99.9 %5 max %6 us")
+                 .arg(stageName(Stage(i)), -7).arg(s.count)
+                 .arg(s.p50Ns / 1000.0, 0, 'f', 1)
+                 .arg(s.p99Ns / 1000.0, 0, 'f', 1)
+                 .arg(s.p999Ns / 1000.0, 0, 'f', 1)
+                 .arg(s.maxNs / 1000.0, 0, 'f', 1);
+    }
+    return lines;
+}
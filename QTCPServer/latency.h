@@ -0,0 +1,70 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <QString>
+#include <QStringList>
+#include <atomic>
+
+// Lock free latency histogram in nanoseconds.
+// Log-linear buckets: exact below 16 ns, then 8 sub buckets per power of two
+// (at most 12.5% error), which covers ns to minutes in a few hundred counters.
+// record() may be called from any thread, readers see a relaxed snapshot.
+class LatencyHistogram
+{
+public:
+    static const int SUB_BUCKETS = 8;
+    static const int BUCKETS = 16 + (64 - 4) * SUB_BUCKETS;
+
+    struct Summary
+    {
+        quint64 count;
+        qint64 p50Ns;
+        qint64 p99Ns;
+        qint64 p999Ns;
+        qint64 maxNs;
+    };
+
+    LatencyHistogram();
+
+    void record(qint64 ns);
+    void reset();
+    Summary summary() const;
+
+private:
+    static int bucketOf(quint64 ns);
+    static qint64 upperBound(int bucket);
+
+    std::atomic<quint32> m_buckets[BUCKETS];
+    std::atomic<quint64> m_count;
+    std::atomic<qint64> m_max;
+};
+
+// Per stage latency of frames travelling from the sender to the UART
+class LatencyMonitor
+{
+public:
+    enum Stage
+    {
+        StageAge,       // sender to socket read, for clients with a known clock offset
+        StageParse,     // socket read to parsed values
+        StageHandoff,   // parsed to picked up by the mixer tick
+        StageMix,       // tick start to pipeline done
+        StageWrite,     // encode and write, per sink
+        StageTotal,     // socket read to the last sink written
+        StageCount
+    };
+
+    void record(Stage stage, qint64 ns) { if (ns >= 0) m_stages[stage].record(ns); }
+    LatencyHistogram::Summary summary(Stage stage) const { return m_stages[stage].summary(); }
+    void reset();
+
+    // One line per stage that has samples
+    QStringList report() const;
+
+    static QString stageName(Stage stage);
+
+private:
+    LatencyHistogram m_stages[StageCount];
+};
+
+#endif // LATENCY_H
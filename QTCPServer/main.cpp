@@ -4,10 +4,56 @@
 int main(int argc, char *argv[])
 {
     qRegisterMetaType<QList<int>>("QList<int>>");
+    qRegisterMetaType<qintptr>("qintptr");
 
     QApplication a(argc, argv);
-    MainWindow w;
-    w.show();
 
-    return a.exec();
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Remote joystick to SBUS bridge");
+    parser.addHelpOption();
+    BridgeConfig::addOptions(parser);
+    parser.process(a);
+
+    QSettings *settings = parser.isSet("config")
+            ? new QSettings(parser.value("config"), QSettings::IniFormat, &a)
+            : new QSettings("FA-Tools", "QTCPServer", &a);
+
+    BridgeConfig config;
+    config.load(*settings);
+    QString error;
+    if (!config.applyOptions(parser, error))
+    {
+        QMessageBox::critical(nullptr, "QTCPServer", error);
+        return EXIT_FAILURE;
+    }
+
+    BridgeEngine engine(config, settings);
+    MainWindow w(&engine);
+
+    // Sockets, parsing and control arbitration run in their own thread, a
+    // busy GUI never delays a frame
+    QThread networkThread;
+    networkThread.setObjectName("network");
+    engine.moveToThread(&networkThread);
+    networkThread.start();
+
+    bool started = false;
+    QMetaObject::invokeMethod(&engine, "start", Qt::BlockingQueuedConnection, Q_RETURN_ARG(bool, started));
+
+    int result = EXIT_FAILURE;
+    if (started)
+    {
+        w.show();
+        result = a.exec();
+    }
+    else
+    {
+        QMessageBox::critical(&w, "QTCPServer", QString("Unable to start the server: %1.").arg(engine.errorString()));
+    }
+
+    // Back to this thread, the engine is destroyed here
+    QMetaObject::invokeMethod(&engine, [&engine, &a]() { engine.moveToThread(a.thread()); }, Qt::BlockingQueuedConnection);
+    networkThread.quit();
+    networkThread.wait();
+    return result;
 }
@@ -0,0 +1,245 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <QTimer>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "benchutil.h"
+#include "bridgeengine.h"
+#include "monotime.h"
+#include "serialio.h"
+#include "shmchannels.h"
+#include "textprotocol.h"
+#include "sbus/packet_decoder.h"
+
+// End to end bench without UART hardware. The bridge runs in this process
+// with its SBUS output and SBUS/CRSF inputs on pseudo terminals. Simulated
+// clients (or a synthetic serial stream, or a shared memory producer) send
+// frames whose first channel carries a sequence number, the SBUS output is
+// decoded on the other end of its pty to measure throughput and input to
+// serial latency.
+
+static void writeCrsf(CrsfSerial &crsf, const int *v)
+{
+    crsf_channels_t ch;
+    ch.ch0 = unsigned(v[0]);   ch.ch1 = unsigned(v[1]);   ch.ch2 = unsigned(v[2]);   ch.ch3 = unsigned(v[3]);
+    ch.ch4 = unsigned(v[4]);   ch.ch5 = unsigned(v[5]);   ch.ch6 = unsigned(v[6]);   ch.ch7 = unsigned(v[7]);
+    ch.ch8 = unsigned(v[8]);   ch.ch9 = unsigned(v[9]);   ch.ch10 = unsigned(v[10]); ch.ch11 = unsigned(v[11]);
+    ch.ch12 = unsigned(v[12]); ch.ch13 = unsigned(v[13]); ch.ch14 = unsigned(v[14]); ch.ch15 = unsigned(v[15]);
+    crsf.writePacket(CRSF_ADDRESS_FLIGHT_CONTROLLER, CRSF_FRAMETYPE_RC_CHANNELS_PACKED, &ch, sizeof(ch));
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("QTCPBench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Bridge latency and throughput bench on pseudo terminals");
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("mode", "Measured input <mode>: tcp, udp, shm, sbus or crsf.", "mode", "tcp"));
+    parser.addOption(QCommandLineOption("rate", "Frames per second sent by each client or the serial stream.", "hz", "100"));
+    parser.addOption(QCommandLineOption("clients", "Number of simulated TCP clients.", "n", "1"));
+    parser.addOption(QCommandLineOption("duration", "Bench duration in <s>.", "s", "10"));
+    parser.addOption(QCommandLineOption("hold", "In shm mode, then hold the values with heartbeats only for <s>.", "s", "1"));
+    parser.addOption(QCommandLineOption("verbose", "Print the bridge's status messages."));
+    BridgeConfig::addOptions(parser);
+    parser.process(a);
+
+    QTextStream out(stdout);
+    QString mode = parser.value("mode");
+    int rate = parser.value("rate").toInt();
+    int clients = parser.value("clients").toInt();
+    int duration = parser.value("duration").toInt();
+    int hold = mode == "shm" ? parser.value("hold").toInt() : 0;
+    if ((mode != "tcp" && mode != "udp" && mode != "shm" && mode != "sbus" && mode != "crsf") ||
+        rate <= 0 || clients <= 0 || duration <= 0 || hold < 0)
+    {
+        out << "Invalid mode, rate, clients, duration or hold, see --help\n";
+        return EXIT_FAILURE;
+    }
+
+    BridgeConfig config;
+    QString error;
+    if (!loadConfig(parser, config, error))
+    {
+        out << error << "\n";
+        return EXIT_FAILURE;
+    }
+
+    Pty sbusOut, sbusIn, crsfIn;
+    if (!sbusOut.open() || !sbusIn.open() || !crsfIn.open())
+    {
+        out << "Unable to create pseudo terminals\n";
+        return EXIT_FAILURE;
+    }
+
+    // The measured input has the highest priority, the others run in the
+    // background at their usual rates
+    QString shmName = QString("qtcpbench-%1").arg(getpid());
+    QStringList sources;
+    sources << "tcp" << "udp" << "shm:" + shmName << "sbus:" + sbusIn.port << "crsf:" + crsfIn.port;
+    foreach (const QString &spec, sources)
+        if (spec.startsWith(mode)) { sources.removeOne(spec); sources.prepend(spec); break; }
+    config.sources = sources;
+    config.sinks = QStringList() << "sbus:" + sbusOut.port;
+    config.networkUnit = UnitSbus;
+    // The clients take turns with one numbered stream, each frame takes control
+    config.ownerTimeoutMs = 0;
+
+    BridgeEngine engine(config);
+    if (parser.isSet("verbose"))
+    {
+        QObject::connect(&engine, &BridgeEngine::statusMessages, [&out](const QStringList &lines) {
+            foreach (const QString &line, lines) out << line << "\n";
+            out.flush();
+        });
+    }
+    if (!engine.start())
+    {
+        out << QString("Unable to start the bridge: %1.").arg(engine.errorString()) << "\n";
+        return EXIT_FAILURE;
+    }
+
+    std::atomic<bool> running(true);
+    std::atomic<bool> holding(false);
+    std::atomic<qint64> sentNs[SEQ_SLOTS];
+    for (int i=0; i<SEQ_SLOTS; i++) sentNs[i].store(0);
+    std::atomic<quint64> sent(0);
+    SbusReceiver output;
+
+    // Mapped by the bridge on start, this maps the same region as a producer
+    ShmChannelBlock *shm = shmChannelsMap(("/" + shmName).toLocal8Bit().constData());
+    if (!shm)
+    {
+        out << "Unable to map the shared memory input\n";
+        return EXIT_FAILURE;
+    }
+
+    std::vector<int> sockets;
+    if (mode == "tcp" || mode == "udp")
+    {
+        for (int i=0; i<(mode == "udp" ? 1 : clients); i++)
+        {
+            int fd = connectClient(mode == "udp", INADDR_LOOPBACK, config.tcpPort);
+            if (fd < 0)
+            {
+                out << "Unable to connect to the bridge\n";
+                return EXIT_FAILURE;
+            }
+            sockets.push_back(fd);
+        }
+    }
+
+    // Measured stream, round robin over the clients
+    std::thread sender([&]() {
+        CrsfSerial crsf(dup(crsfIn.master));
+        int values[SBUS_NUM_CHANNELS];
+        for (int i=0; i<SBUS_NUM_CHANNELS; i++) values[i] = CENTER;
+
+        qint64 periodNs = 1000000000LL / (rate * qint64(sockets.empty() ? 1 : sockets.size()));
+        qint64 next = monotonicNs();
+        for (quint32 seq = 0; running.load(std::memory_order_relaxed); seq++)
+        {
+            next += periodNs;
+            sleepUntil(next);
+
+            if (holding.load(std::memory_order_relaxed))
+            {
+                // Alive, the last values stand
+                shmChannelsHeartbeat(shm);
+                continue;
+            }
+
+            values[0] = encodeSeq(seq);
+            sentNs[seq % SEQ_SLOTS].store(monotonicNs(), std::memory_order_release);
+            if (mode == "shm")
+                shmChannelsPublish(shm, values, SBUS_NUM_CHANNELS);
+            else if (mode == "sbus")
+                writeSbus(sbusIn.master, values);
+            else if (mode == "crsf")
+                writeCrsf(crsf, values);
+            else
+            {
+                QByteArray block = writeTextMessage(formatTextMessage(values, SBUS_NUM_CHANNELS));
+                if (::send(sockets[seq % sockets.size()], block.constData(), size_t(block.size()), MSG_NOSIGNAL) < 0)
+                    continue;
+            }
+            sent.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    // Lower priority serial inputs at their native frame rates
+    std::thread background([&]() {
+        CrsfSerial crsf(dup(crsfIn.master));
+        int values[SBUS_NUM_CHANNELS];
+        for (int i=0; i<SBUS_NUM_CHANNELS; i++) values[i] = CENTER;
+
+        qint64 next = monotonicNs();
+        for (int n = 0; running.load(std::memory_order_relaxed); n++)
+        {
+            next += msToNs(4);
+            sleepUntil(next);
+            if (mode != "crsf") writeCrsf(crsf, values);
+            if (mode != "sbus" && n % 3 == 0) writeSbus(sbusIn.master, values);
+        }
+    });
+
+    std::thread receiver([&]() { output.run(sbusOut.master, running, sentNs); });
+
+    QTimer::singleShot(duration * 1000, &a, &QCoreApplication::quit);
+    qint64 startNs = monotonicNs();
+    a.exec();
+    double seconds = (monotonicNs() - startNs) / 1e9;
+
+    // A producer holding still must not look like frames waiting for the
+    // mixer since they were published
+    if (hold > 0)
+    {
+        holding = true;
+        QTimer::singleShot(hold * 1000, &a, &QCoreApplication::quit);
+        a.exec();
+    }
+
+    running = false;
+    sender.join();
+    background.join();
+    receiver.join();
+    for (int fd : sockets) ::close(fd);
+    shmChannelsUnmap(shm);
+    shm_unlink(("/" + shmName).toLocal8Bit().constData());
+
+    LatencyHistogram::Summary s = output.latency.summary();
+    out << QString("Mode %1, %2 s, mixer tick %3 ms").arg(mode).arg(seconds, 0, 'f', 1).arg(config.mixerTickMs) << "\n";
+    out << QString("Sent %1 frames (%2/s), output %3 packets (%4/s), %5 updates seen, %6 coalesced, %7 stale")
+           .arg(sent.load()).arg(sent.load() / seconds, 0, 'f', 1)
+           .arg(output.packets.load()).arg(output.packets.load() / seconds, 0, 'f', 1)
+           .arg(output.updates.load()).arg(qint64(sent.load()) - qint64(output.updates.load() + output.stale.load()))
+           .arg(output.stale.load()) << "\n";
+    out << QString("Input to serial latency: p50 %1 p99 %2 p99.9 %3 max %4 us (n=%5)")
+           .arg(s.p50Ns / 1000.0, 0, 'f', 1).arg(s.p99Ns / 1000.0, 0, 'f', 1)
+           .arg(s.p999Ns / 1000.0, 0, 'f', 1).arg(s.maxNs / 1000.0, 0, 'f', 1)
+           .arg(s.count) << "\n";
+    foreach (const QString &line, engine.latencyReport())
+        out << line << "\n";
+
+    if (hold > 0)
+    {
+        // A new shm frame waits at most one tick, two leave room for jitter
+        LatencyHistogram::Summary handoff = engine.latencySummary(LatencyMonitor::StageHandoff);
+        qint64 limitNs = 2 * msToNs(qMax(1, config.mixerTickMs));
+        out << QString("Handoff p99 after holding the values %1 s: %2 us, limit %3 us")
+               .arg(hold).arg(handoff.p99Ns / 1000.0, 0, 'f', 1).arg(limitNs / 1000.0, 0, 'f', 1) << "\n";
+        if (handoff.p99Ns > limitNs)
+        {
+            out << "Held values were timed as if they had waited since they were published\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,78 @@
+#include "bridgeengine.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QSocketNotifier>
+#include <QTextStream>
+#include <csignal>
+#include <unistd.h>
+#include <sys/socket.h>
+
+// Daemon entry point, runs the bridge without QApplication or an X session.
+
+static int s_signalFd[2];
+
+static void signalHandler(int)
+{
+    char c = 1;
+    ssize_t n = ::write(s_signalFd[0], &c, sizeof(c));
+    Q_UNUSED(n)
+}
+
+int main(int argc, char *argv[])
+{
+    qRegisterMetaType<QList<int>>("QList<int>>");
+
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("QTCPServerd");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Remote joystick to SBUS bridge, headless");
+    parser.addHelpOption();
+    BridgeConfig::addOptions(parser);
+    parser.process(a);
+
+    QSettings *settings = parser.isSet("config")
+            ? new QSettings(parser.value("config"), QSettings::IniFormat, &a)
+            : new QSettings("FA-Tools", "QTCPServer", &a);
+
+    QTextStream out(stdout);
+
+    BridgeConfig config;
+    config.load(*settings);
+    QString error;
+    if (!config.applyOptions(parser, error))
+    {
+        out << error << "\n";
+        return EXIT_FAILURE;
+    }
+
+    // Quit the event loop on SIGINT/SIGTERM so the engine shuts down its threads
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, s_signalFd) == 0)
+    {
+        QSocketNotifier *notifier = new QSocketNotifier(s_signalFd[1], QSocketNotifier::Read, &a);
+        QObject::connect(notifier, SIGNAL(activated(int)), &a, SLOT(quit()));
+        std::signal(SIGINT, signalHandler);
+        std::signal(SIGTERM, signalHandler);
+    }
+
+    BridgeEngine engine(config, settings);
+    QObject::connect(&engine, &BridgeEngine::statusMessages, [&out](const QStringList &lines) {
+        QString date = QDateTime::currentDateTime().toString("yyyy-MM-dd");
+        foreach (const QString &line, lines)
+            out << date << " " << line << "\n";
+        out.flush();
+    });
+
+    if (!engine.start())
+    {
+        out << QString("Unable to start the server: %1.").arg(engine.errorString()) << "\n";
+        return EXIT_FAILURE;
+    }
+
+    int result = a.exec();
+
+    foreach (const QString &line, engine.latencyReport())
+        out << line << "\n";
+
+    return result;
+}
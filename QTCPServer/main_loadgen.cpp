@@ -0,0 +1,330 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QHostAddress>
+#include <QHostInfo>
+#include <QTextStream>
+#include <QTimer>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include "benchutil.h"
+#include "bridgeengine.h"
+#include "joystickprotocol.h"
+#include "monotime.h"
+#include "textprotocol.h"
+
+// Stress test for the bridge's network side. N clients each send frames at
+// M Hz, optionally with a share of corrupted ones. By default the bridge
+// runs in this process with its SBUS output on a pty, which gives the
+// server's acceptance counters, its CPU time and input to serial latency.
+// With --host the clients load a bridge elsewhere, which then reports its
+// side with --latency-report.
+
+struct LoadClient
+{
+    int fd = -1;
+    quint32 seq = 0;
+};
+
+struct LoadCounters
+{
+    std::atomic<quint64> valid;
+    std::atomic<quint64> corrupt;
+    std::atomic<quint64> blocked;       // socket buffer full, the server isn't reading fast enough
+    std::atomic<quint64> failed;        // connection lost
+    std::atomic<qint64> cpuNs;          // of the generator threads
+
+    LoadCounters() : valid(0), corrupt(0), blocked(0), failed(0), cpuNs(0) {}
+};
+
+static qint64 threadCpuNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+static qint64 processCpuNs()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (qint64(usage.ru_utime.tv_sec) + usage.ru_stime.tv_sec) * 1000000000 +
+           (qint64(usage.ru_utime.tv_usec) + usage.ru_stime.tv_usec) * 1000;
+}
+
+// Damages a valid message the way a bad link or a buggy client would
+static void corrupt(QByteArray &block, quint32 n)
+{
+    switch (n % 3)
+    {
+    case 0:     // bit error, fails the CRC
+        block[block.size() / 2] = char(block.at(block.size() / 2) ^ 0x10);
+        break;
+    case 1:     // truncated, the rest arrives as the next message's prefix
+        block.chop(block.size() / 2);
+        break;
+    default:    // line noise in front
+        block.prepend(QByteArray(7, char(0x5A)));
+        break;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("QTCPLoadGen");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Multi client load generator for the bridge's network inputs");
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("clients", "Number of client connections.", "n", "16"));
+    parser.addOption(QCommandLineOption("rate", "Frames per second sent by each client.", "hz", "50"));
+    parser.addOption(QCommandLineOption("duration", "Load duration in <s>.", "s", "10"));
+    parser.addOption(QCommandLineOption("format", "Message <format>: binary or text.", "format", "binary"));
+    parser.addOption(QCommandLineOption("corrupt", "Share of corrupted messages in <percent>.", "percent", "0"));
+    parser.addOption(QCommandLineOption("udp", "Send datagrams instead of TCP streams."));
+    parser.addOption(QCommandLineOption("threads", "Sender threads, the clients are split among them.", "n", "2"));
+    parser.addOption(QCommandLineOption("host", "Load the bridge at <host> instead of one in this process.", "host"));
+    parser.addOption(QCommandLineOption("verbose", "Print the bridge's status messages."));
+    BridgeConfig::addOptions(parser);
+    parser.process(a);
+
+    QTextStream out(stdout);
+    int clients = parser.value("clients").toInt();
+    int rate = parser.value("rate").toInt();
+    int duration = parser.value("duration").toInt();
+    int corruptPercent = parser.value("corrupt").toInt();
+    int threads = qMin(parser.value("threads").toInt(), clients);
+    bool binary = parser.value("format") == "binary";
+    bool udp = parser.isSet("udp");
+    bool local = !parser.isSet("host");
+    if (clients <= 0 || rate <= 0 || duration <= 0 || threads <= 0 ||
+        corruptPercent < 0 || corruptPercent > 100 ||
+        (!binary && parser.value("format") != "text"))
+    {
+        out << "Invalid clients, rate, duration, threads, format or corrupt share, see --help\n";
+        return EXIT_FAILURE;
+    }
+
+    BridgeConfig config;
+    QString error;
+    if (!loadConfig(parser, config, error))
+    {
+        out << error << "\n";
+        return EXIT_FAILURE;
+    }
+
+    quint32 address = QHostAddress(QHostAddress::LocalHost).toIPv4Address();
+    if (!local)
+    {
+        QHostInfo info = QHostInfo::fromName(parser.value("host"));
+        address = 0;
+        foreach (const QHostAddress &candidate, info.addresses())
+        {
+            bool ok = false;
+            address = candidate.toIPv4Address(&ok);
+            if (ok) break;
+        }
+        if (address == 0)
+        {
+            out << QString("Unable to resolve '%1'").arg(parser.value("host")) << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Every client holds a socket
+    struct rlimit files;
+    if (getrlimit(RLIMIT_NOFILE, &files) == 0 && files.rlim_cur < files.rlim_max)
+    {
+        files.rlim_cur = files.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &files);
+    }
+
+    Pty sbusOut;
+    QScopedPointer<BridgeEngine> engine;
+    if (local)
+    {
+        if (!sbusOut.open())
+        {
+            out << "Unable to create a pseudo terminal\n";
+            return EXIT_FAILURE;
+        }
+        config.sources = QStringList() << (udp ? "udp" : "tcp");
+        config.sinks = QStringList() << "sbus:" + sbusOut.port;
+        config.networkUnit = UnitSbus;
+
+        engine.reset(new BridgeEngine(config));
+        if (parser.isSet("verbose"))
+        {
+            QObject::connect(engine.data(), &BridgeEngine::statusMessages, [&out](const QStringList &lines) {
+                foreach (const QString &line, lines) out << line << "\n";
+                out.flush();
+            });
+        }
+        if (!engine->start())
+        {
+            out << QString("Unable to start the bridge: %1.").arg(engine->errorString()) << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::atomic<bool> running(true);
+    std::atomic<qint64> sentNs[SEQ_SLOTS];
+    for (int i=0; i<SEQ_SLOTS; i++) sentNs[i].store(0);
+    std::atomic<quint32> probeSeq(0);
+    std::atomic<int> connected(0), connectFailed(0);
+    std::atomic<qint64> connectNs(0);
+    LoadCounters counters;
+    SbusReceiver output;
+    LatencyHistogram lateness;      // sender behind its schedule
+
+    // Connected from the sender threads while the bridge accepts, a burst
+    // beyond its listen backlog would otherwise stall in SYN retries
+    qint64 startNs = monotonicNs();
+    std::vector<std::thread> senders;
+    for (int t=0; t<threads; t++)
+    {
+        senders.emplace_back([&, t]() {
+            std::vector<LoadClient> own;
+            for (int i=t; i<clients; i+=threads)
+            {
+                LoadClient client;
+                client.fd = connectClient(udp, address, config.tcpPort);
+                if (client.fd < 0)
+                {
+                    connectFailed.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                own.push_back(client);
+                connected.fetch_add(1, std::memory_order_relaxed);
+            }
+            qint64 doneNs = monotonicNs() - startNs;
+            for (qint64 prev = connectNs.load(); prev < doneNs && !connectNs.compare_exchange_weak(prev, doneNs); ) {}
+            if (own.empty()) return;
+
+            // The clients of a thread are spread evenly over the period
+            int values[FRAME_MAX_CHANNELS];
+            for (int i=0; i<FRAME_MAX_CHANNELS; i++) values[i] = CENTER;
+            QByteArray block;
+            qint64 stepNs = 1000000000LL / rate / qint64(own.size());
+            qint64 next = monotonicNs() + stepNs * t / threads;
+            for (quint32 n = 0; running.load(std::memory_order_relaxed); n++)
+            {
+                LoadClient &client = own[n % own.size()];
+                next += stepNs;
+                sleepUntil(next);
+                lateness.record(monotonicNs() - next);
+                if (client.fd < 0) continue;
+
+                bool damaged = corruptPercent > 0 && int((n * 2654435761u) % 100) < corruptPercent;
+                quint32 seq = probeSeq.fetch_add(1, std::memory_order_relaxed);
+                values[0] = encodeSeq(seq);
+
+                block.clear();
+                if (binary)
+                    appendChannelsFrame(block, client.seq++, values, FRAME_MAX_CHANNELS);
+                else
+                    block = writeTextMessage(formatTextMessage(values, FRAME_MAX_CHANNELS));
+                if (damaged)
+                    corrupt(block, n);
+                else
+                    sentNs[seq % SEQ_SLOTS].store(monotonicNs(), std::memory_order_release);
+
+                ssize_t sent = ::send(client.fd, block.constData(), size_t(block.size()), MSG_NOSIGNAL | MSG_DONTWAIT);
+                if (sent == ssize_t(block.size()))
+                {
+                    (damaged ? counters.corrupt : counters.valid).fetch_add(1, std::memory_order_relaxed);
+                }
+                else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || (udp && errno == ECONNREFUSED)))
+                {
+                    counters.blocked.fetch_add(1, std::memory_order_relaxed);
+                }
+                else
+                {
+                    // A partial write would desync the stream, the client is done
+                    counters.failed.fetch_add(1, std::memory_order_relaxed);
+                    ::close(client.fd);
+                    client.fd = -1;
+                }
+            }
+
+            for (const LoadClient &client : own)
+                if (client.fd >= 0) ::close(client.fd);
+            counters.cpuNs.fetch_add(threadCpuNs(), std::memory_order_relaxed);
+        });
+    }
+
+    // SBUS output of the local bridge. With many clients most frames are
+    // replaced by a newer one before the next tick, those are coalesced, not late.
+    std::thread receiver([&]() {
+        if (!local) return;
+        output.run(sbusOut.master, running, sentNs);
+        counters.cpuNs.fetch_add(threadCpuNs(), std::memory_order_relaxed);
+    });
+
+    QTimer::singleShot(duration * 1000, &a, &QCoreApplication::quit);
+    qint64 cpuStartNs = processCpuNs();
+    a.exec();
+    double seconds = (monotonicNs() - startNs) / 1e9;
+
+    running = false;
+    for (std::thread &sender : senders) sender.join();
+    receiver.join();
+
+    // Let the bridge read what is still in flight before counting
+    if (local)
+    {
+        QTimer::singleShot(200, &a, &QCoreApplication::quit);
+        a.exec();
+    }
+    double cpuSeconds = (processCpuNs() - cpuStartNs) / 1e9;
+    double generatorSeconds = counters.cpuNs.load() / 1e9;
+
+    quint64 valid = counters.valid.load();
+    out << QString("%1 %2 clients at %3 Hz, %4 format, %5% corrupt, %6 s")
+           .arg(connected.load()).arg(udp ? "udp" : "tcp").arg(rate).arg(binary ? "binary" : "text")
+           .arg(corruptPercent).arg(seconds, 0, 'f', 1) << "\n";
+    out << QString("Connected in %1 ms, %2 failed to connect")
+           .arg(connectNs.load() / 1e6, 0, 'f', 1).arg(connectFailed.load()) << "\n";
+    out << QString("Sent %1 valid (%2/s), %3 corrupt, %4 blocked by a full socket, %5 clients lost")
+           .arg(valid).arg(valid / seconds, 0, 'f', 1).arg(counters.corrupt.load())
+           .arg(counters.blocked.load()).arg(counters.failed.load()) << "\n";
+
+    LatencyHistogram::Summary late = lateness.summary();
+    out << QString("Sender behind schedule: p50 %1 p99 %2 max %3 us")
+           .arg(late.p50Ns / 1000.0, 0, 'f', 1).arg(late.p99Ns / 1000.0, 0, 'f', 1)
+           .arg(late.maxNs / 1000.0, 0, 'f', 1) << "\n";
+
+    if (!local)
+    {
+        out << QString("Generator CPU %1% of one core, the bridge reports its side with --latency-report")
+               .arg(100.0 * generatorSeconds / seconds, 0, 'f', 1) << "\n";
+        return EXIT_SUCCESS;
+    }
+
+    const BridgeEngine::NetworkStats &n = engine->networkStats();
+    // Only the client in control moves the outputs, the others' valid
+    // frames are refused after parsing
+    out << QString("Bridge parsed %1 (%2% of valid): %3 from the client in control, %4 refused; rejected %5, stale %6, peak %7 clients, %8 kB")
+           .arg(n.accepted + n.refused).arg(valid ? 100.0 * (n.accepted + n.refused) / valid : 0.0, 0, 'f', 2)
+           .arg(n.accepted).arg(n.refused)
+           .arg(n.rejected).arg(n.stale).arg(n.peakClients).arg(n.bytes / 1024) << "\n";
+    out << QString("CPU: bridge %1%, generator %2% of one core")
+           .arg(100.0 * qMax(0.0, cpuSeconds - generatorSeconds) / seconds, 0, 'f', 1)
+           .arg(100.0 * generatorSeconds / seconds, 0, 'f', 1) << "\n";
+    LatencyHistogram::Summary s = output.latency.summary();
+    out << QString("Output %1 packets, %2 updates seen, input to serial latency: p50 %3 p99 %4 p99.9 %5 max %6 us")
+           .arg(output.packets.load()).arg(output.updates.load())
+           .arg(s.p50Ns / 1000.0, 0, 'f', 1).arg(s.p99Ns / 1000.0, 0, 'f', 1)
+           .arg(s.p999Ns / 1000.0, 0, 'f', 1).arg(s.maxNs / 1000.0, 0, 'f', 1) << "\n";
+    foreach (const QString &line, engine->latencyReport())
+        out << line << "\n";
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,385 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QHash>
+#include <QTextStream>
+#include <QVector>
+#include "benchutil.h"
+#include "bridgeconfig.h"
+#include "channelmixer.h"
+#include "clientprotocol.h"
+#include "controlarbiter.h"
+#include "joystickprotocol.h"
+#include "latency.h"
+#include "monotime.h"
+#include "recorder.h"
+#include "serialio.h"
+#include "sbus/packet_decoder.h"
+
+// Feeds a recording made with --record back through the same parsers and
+// mixer as the live bridge, on the recorded clock or as fast as possible.
+// The digest of the produced SBUS packets identifies a run, so two builds or
+// two settings files can be compared on identical input.
+
+// Source recreated from a KindSource record. Serial and shared memory
+// records are decoded here, the values of network clients come from
+// ReplayNetwork once they won arbitration.
+class ReplayInput : public InputSource
+{
+public:
+    ReplayInput(const QString &type, const QString &port, ChannelUnit unit, const BridgeConfig &config) :
+        InputSource(type, port, unit), m_hasFrame(false), m_frames(0), m_errors(0)
+    {
+        m_control.setTimeout(msToNs(config.ownerTimeoutMs));
+        m_crsf.onPacketChannels = [this]() {
+            m_frame.count = CRSF_NUM_CHANNELS;
+            for (int i=0; i<CRSF_NUM_CHANNELS; i++) m_frame.channels[i] = m_crsf.getChannel(unsigned(i + 1));
+            m_hasFrame = true;
+            m_frames++;
+        };
+    }
+
+    bool open() override { m_isOpen = true; return true; }
+
+    void feed(const StreamRecorder::RecordHeader &header, const char *data)
+    {
+        qint64 rxNs = monotonicNs();
+        const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data);
+
+        switch (header.kind)
+        {
+        case StreamRecorder::KindSbus:
+        {
+            sbus_frame_t frames[SBUS::MAX_FRAMES_PER_READ];
+            int nFrames = 0;
+            if (m_sbus.decode(bytes, int(header.size), frames, SBUS::MAX_FRAMES_PER_READ, &nFrames) != SBUS_OK)
+                m_errors++;
+            // Same rule as SbusInput, newest frame unless it is a failsafe frame
+            if (nFrames > 0 && !frames[nFrames - 1].packet.failsafe)
+            {
+                m_frame.count = SBUS_NUM_CHANNELS;
+                for (int i=0; i<SBUS_NUM_CHANNELS; i++) m_frame.channels[i] = frames[nFrames - 1].packet.channels[i];
+                m_hasFrame = true;
+                m_frames++;
+            }
+            break;
+        }
+
+        case StreamRecorder::KindCrsf:
+            m_crsf.feed(bytes, header.size);
+            break;
+
+        case StreamRecorder::KindShm:
+        {
+            // One complete channels frame per update or heartbeat
+            FrameReader reader;
+            reader.append(data, int(header.size));
+            int count = 0;
+            if (reader.next() != FrameReader::Frame ||
+                !decodeChannels(reader.payload(), reader.header().length, m_frame.channels, count))
+            {
+                m_errors++;
+                break;
+            }
+            m_frame.count = count;
+            m_hasFrame = true;
+            m_frames++;
+            break;
+        }
+
+        default:
+            break;
+        }
+
+        m_frame.failsafe = false;
+        m_frame.rxNs = rxNs;
+        m_frame.readyNs = 0;
+    }
+
+    // Values of the network client in control, true if the previous ones
+    // weren't taken yet
+    bool submit(const int *values, int count)
+    {
+        bool coalesced = m_hasFrame;
+        m_frame.count = count;
+        for (int i=0; i<count; i++) m_frame.channels[i] = values[i];
+        m_frame.failsafe = false;
+        m_frame.rxNs = monotonicNs();
+        m_frame.readyNs = 0;
+        m_hasFrame = true;
+        m_frames++;
+        return coalesced;
+    }
+
+    bool poll(ChannelFrame &frame) override
+    {
+        if (!m_hasFrame) return false;
+        frame = m_frame;
+        m_hasFrame = false;
+        return true;
+    }
+
+    // One controlling client per network input, as in the engine
+    ControlArbiter *control() { return &m_control; }
+
+    quint64 frames() const { return m_frames; }
+    quint64 errors() const { return m_errors; }
+
+private:
+    ControlArbiter m_control;
+    SBUS m_sbus;
+    CrsfSerial m_crsf;
+    ChannelFrame m_frame;
+    bool m_hasFrame;
+    quint64 m_frames;
+    quint64 m_errors;
+};
+
+// The clients of the network inputs, one per recorded connection or UDP
+// sender, through the engine's protocol rules on the recorded clock. Their
+// recorded pongs set the clock offsets the frame age check uses.
+class ReplayNetwork : public ClientProtocol
+{
+public:
+    ReplayNetwork(const BridgeConfig &config, EventLog *log, LatencyMonitor *latency) :
+        ClientProtocol(config, m_stats, latency), m_log(log), m_latency(latency) {}
+    ~ReplayNetwork() { qDeleteAll(m_streams); }
+
+    void feed(const StreamRecorder::RecordHeader &header, const char *data, ReplayInput *input)
+    {
+        qint64 startNs = monotonicNs();
+        Stream *&stream = m_streams[header.stream];
+        if (!stream)
+        {
+            stream = new Stream;
+            initClient(*stream, input->control());
+            stream->id = header.stream;
+            stream->peer = QString("%1 stream %2").arg(input->type()).arg(header.stream);
+            stream->input = input;
+        }
+        // Each datagram stands alone, as in the engine
+        if (input->type() == "udp") stream->reader.clear();
+        stream->reader.append(data, int(header.size));
+
+        processStream(*stream, header.timeNs);
+        if (m_latency) m_latency->record(LatencyMonitor::StageParse, monotonicNs() - startNs);
+    }
+
+    const Stats &stats() const { return m_stats; }
+
+private:
+    struct Stream : ClientProtocol::Client
+    {
+        ReplayInput *input;
+    };
+
+    void statusMsg(EventLog::Type type, const QString &msg) override { m_log->post(type, msg); }
+
+    bool submitToInput(Client &client, const int *values, int count, qint64) override
+    {
+        return static_cast<Stream&>(client).input->submit(values, count);
+    }
+
+    // Its connection was closed or forgotten live, so no more records follow
+    void dropClient(Client *client) override
+    {
+        removeClient(client);
+        m_streams.remove(client->id);
+        delete static_cast<Stream*>(client);
+    }
+
+    Stats m_stats;
+    EventLog *m_log;
+    LatencyMonitor *m_latency;
+    QHash<quint16, Stream*> m_streams;
+};
+
+// Hashes every packet the SBUS output would have sent (FNV-1a)
+class DigestSink : public OutputSink
+{
+public:
+    DigestSink() : OutputSink("digest", QString()), m_hash(14695981039346656037ULL), m_packets(0) {}
+
+    bool open() override { m_isOpen = true; return true; }
+
+    bool write(const ChannelFrame &frame) override
+    {
+        sbus_packet_t packet;
+        packet.failsafe = frame.failsafe;
+        packet.frameLost = false;
+        packet.ch17 = false;
+        packet.ch18 = false;
+        for (int i=0; i<SBUS_NUM_CHANNELS; i++)
+            packet.channels[i] = i < frame.count ? uint16_t(frame.channels[i]) : 0;
+
+        uint8_t buf[SBUS_PACKET_SIZE];
+        sbus_encode(buf, &packet);
+        for (int i=0; i<SBUS_PACKET_SIZE; i++)
+        {
+            m_hash ^= buf[i];
+            m_hash *= 1099511628211ULL;
+        }
+        m_packets++;
+        return true;
+    }
+
+    quint64 hash() const { return m_hash; }
+    quint64 packets() const { return m_packets; }
+
+private:
+    quint64 m_hash;
+    quint64 m_packets;
+};
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("QTCPReplay");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replays a recording made with --record through the bridge mixer");
+    parser.addHelpOption();
+    parser.addPositionalArgument("recording", "File written by QTCPServer --record.");
+    parser.addOption(QCommandLineOption("fast", "Replay as fast as possible instead of on the recorded clock."));
+    parser.addOption(QCommandLineOption("verbose", "Print the mixer's status messages."));
+    BridgeConfig::addOptions(parser);
+    parser.process(a);
+
+    QTextStream out(stdout);
+    if (parser.positionalArguments().count() != 1)
+    {
+        out << "One recording expected, see --help\n";
+        return EXIT_FAILURE;
+    }
+
+    BridgeConfig config;
+    QString error;
+    if (!loadConfig(parser, config, error))
+    {
+        out << error << "\n";
+        return EXIT_FAILURE;
+    }
+
+    RecordingReader reader;
+    if (!reader.open(parser.positionalArguments().first(), error))
+    {
+        out << error << "\n";
+        return EXIT_FAILURE;
+    }
+
+    LatencyMonitor latency;
+    EventLog log;
+    ReplayNetwork network(config, &log, &latency);
+
+    // Sources in their recorded order, which is their priority
+    QVector<ReplayInput*> inputs;
+    StreamRecorder::RecordHeader header;
+    const char *data;
+    while (reader.next(header, data))
+    {
+        if (header.kind != StreamRecorder::KindSource) continue;
+
+        QStringList desc = QString::fromUtf8(data, int(header.size)).split(';');
+        QString type, port;
+        BridgeConfig::splitEndpoint(desc.first(), type, port);
+        ChannelUnit unit = UnitSbus;
+        if (desc.count() > 1) ChannelPipeline::parseUnit(desc.at(1), unit);
+
+        if (inputs.count() <= header.source) inputs.resize(header.source + 1);
+        inputs[header.source] = new ReplayInput(type, port, unit, config);
+    }
+    if (inputs.isEmpty() || inputs.contains(nullptr))
+    {
+        out << "Recording has no or incomplete source records\n";
+        return EXIT_FAILURE;
+    }
+
+    // Real outputs only if asked for, never the configured default port
+    QList<OutputSink*> sinks;
+    DigestSink *digest = new DigestSink;
+    sinks << digest;
+    QString type, port;
+    foreach (const QString &spec, config.sinks)
+    {
+        BridgeConfig::splitEndpoint(spec, type, port);
+        if (type == "sbus")
+            sinks << new SbusOutput(port);
+        else if (type == "crsf")
+            sinks << new CrsfOutput(port);
+        else
+        {
+            out << QString("Invalid output '%1'").arg(spec) << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    QList<InputSource*> sources;
+    foreach (ReplayInput *input, inputs) sources << input;
+
+    ChannelMixer mixer(sources, sinks);
+    mixer.setEventLog(&log);
+    mixer.setLatencyMonitor(&latency);
+    mixer.setTransforms(config.channels);
+    mixer.setTimeouts(config.primaryTimeoutMs, config.secondaryTimeoutMs, config.failsafeDelayMs);
+    for (int i=0; i<inputs.count(); i++)
+        if (inputs.at(i)->type() == "shm") mixer.setSourceTimeout(i, config.shmTimeoutMs);
+    mixer.open();
+
+    // The mixer runs on the recorded clock, its timeouts and failsafe see
+    // the same time line in both modes
+    bool fast = parser.isSet("fast");
+    bool verbose = parser.isSet("verbose");
+    qint64 tickNs = msToNs(qMax(1, config.mixerTickMs));
+    qint64 firstNs = 0, nextTickNs = 0, ticks = 0, records = 0;
+    qint64 wallStartNs = monotonicNs();
+
+    reader.rewind();
+    while (reader.next(header, data))
+    {
+        if (header.kind == StreamRecorder::KindSource) continue;
+
+        if (records++ == 0)
+            firstNs = nextTickNs = header.timeNs;
+
+        while (nextTickNs <= header.timeNs)
+        {
+            if (!fast) sleepUntil(wallStartNs + nextTickNs - firstNs);
+            mixer.process(nextTickNs);
+            nextTickNs += tickNs;
+            ticks++;
+        }
+
+        ReplayInput *input = inputs.value(header.source);
+        if (input && header.kind == StreamRecorder::KindNetwork)
+            network.feed(header, data, input);
+        else if (input)
+            input->feed(header, data);
+
+        if (verbose)
+            foreach (const QString &line, log.drain()) out << line << "\n";
+    }
+    // Send what the last record produced
+    mixer.process(nextTickNs);
+    ticks++;
+
+    qint64 wallNs = monotonicNs() - wallStartNs;
+    if (verbose)
+        foreach (const QString &line, log.drain()) out << line << "\n";
+
+    out << QString("Replayed %1 records, %2 s recorded in %3 s (%4x)")
+           .arg(records)
+           .arg((nextTickNs - firstNs) / 1e9, 0, 'f', 3)
+           .arg(wallNs / 1e9, 0, 'f', 3)
+           .arg(wallNs > 0 ? double(nextTickNs - firstNs) / wallNs : 0.0, 0, 'f', 1) << "\n";
+    for (int i=0; i<inputs.count(); i++)
+        out << QString("Input %1 %2: %3 frames, %4 errors").arg(i).arg(inputs.at(i)->name())
+               .arg(inputs.at(i)->frames()).arg(inputs.at(i)->errors()) << "\n";
+    const ClientProtocol::Stats &n = network.stats();
+    out << QString("Network: %1 accepted, %2 refused, %3 rejected, %4 stale, %5 duplicates, %6 too old, %7 resumed")
+           .arg(n.accepted).arg(n.refused).arg(n.rejected).arg(n.stale).arg(n.duplicates).arg(n.tooOld).arg(n.resumed) << "\n";
+    out << QString("Output: %1 ticks, %2 packets, digest %3")
+           .arg(ticks).arg(digest->packets()).arg(digest->hash(), 16, 16, QChar('0')) << "\n";
+    foreach (const QString &line, latency.report())
+        out << line << "\n";
+
+    return EXIT_SUCCESS;
+}
@@ -5,64 +5,46 @@
 #include <QDebug>
 #include <QMessageBox>
 #include <QMetaType>
+#include <QSlider>
 #include <QString>
-#include <QTcpServer>
-#include <QTcpSocket>
-#include <QThread>
-#include <QSettings>
-#include <qsbusthreadworker.h>
+#include <QTimer>
+#include "bridgeengine.h"
 
 namespace Ui {
 class MainWindow;
 }
 
+// GUI observer of a BridgeEngine, the engine runs the same without it
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
 
 public:
-    explicit MainWindow(QWidget *parent = nullptr);
+    explicit MainWindow(BridgeEngine *engine, QWidget *parent = nullptr);
     ~MainWindow();
 
-signals:
-    void newMessage(QString);
-    void updateSbus(QList<int> channels);
-    void openSbus(QString port);
-    void openSbusSecondary(QString port);
-    void openCRSFSecondary(QString port);
-
 private slots:
-    void newConnection();
-    void appendToSocketList(QTcpSocket* socket);
-
-    void readSocket();
-    void discardSocket();
+    void clientConnected(qintptr descriptor);
+    void clientDisconnected(qintptr descriptor);
 
-    void displayMessage(const QString& str);
-    void processMessage(const QString& str);
-    void processMessageSecondary(QList<int> channels);
-    void sendMessage(QTcpSocket* socket);
-    void serialPortChanged(const QString &);
-    void serialPortChanged2(const QString &);
+    void displayMessages(const QStringList& lines);
+    void refreshChannels();
+    void showLinkHealth(const QStringList& lines);
 
     void on_pushButton_sendMessage_clicked();
 
-private:
-    Ui::MainWindow *ui;
+protected:
+    void changeEvent(QEvent *event) override;
 
-    QTcpServer* m_server;
-    QList<QTcpSocket*> connection_list;
-    QSbusThreadWorker *m_sbusWorker;
-    QSbusReadThreadWorker *m_sbusReadWorker;
-    QCRSFReadThreadWorker *m_CRSFReadWorker;
-    QThread sbusThread;
-    QThread sbusReadThread;
-    QThread crsfReadThread;
+private:
+    void updateRefreshTimer();
 
-    QSettings *m_settings;
-    QString m_serialPort;
-    QString m_serialPort2;
+    Ui::MainWindow *ui;
 
+    BridgeEngine *m_engine;
+    QTimer *m_refreshTimer;
+    QSlider *m_channelSliders[ChannelModel::MAX_CHANNELS];
+    quint32 m_lastChannelSeq;
 };
 
 #endif // MAINWINDOW_H
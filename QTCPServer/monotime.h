@@ -0,0 +1,18 @@
+#ifndef MONOTIME_H
+#define MONOTIME_H
+
+#include <QtGlobal>
+#include <time.h>
+
+// Steady nanosecond clock for freshness and failsafe decisions.
+// Unlike QDateTime it never jumps with NTP or time zone changes.
+inline qint64 monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+inline qint64 msToNs(qint64 ms) { return ms * 1000000LL; }
+
+#endif // MONOTIME_H
@@ -0,0 +1,83 @@
+#ifndef NETWORKINPUT_H
+#define NETWORKINPUT_H
+
+#include <atomic>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include "channelio.h"
+
+// Channels received over TCP or UDP.
+// The sockets live in the engine's thread, which parses the messages and
+// submits the values here. The mixer picks up the newest values without a
+// queued signal, the slot is a seqlock so neither side ever blocks. A
+// forwarding mixer is woken through an eventfd instead of its tick.
+class NetworkInput : public InputSource
+{
+public:
+    NetworkInput(const QString &type, const QString &port = QString()) :
+        InputSource(type, port, UnitSbus), m_lastSeq(0), m_published(0), m_readyFd(-1)
+    {
+        m_taken.store(0, std::memory_order_relaxed);
+        m_signalReady.store(false, std::memory_order_relaxed);
+    }
+    ~NetworkInput() { if (m_readyFd >= 0) ::close(m_readyFd); }
+
+    // Network thread, stamps are monotonicNs() of the socket read and of the parse.
+    // True if the previous values were replaced before the mixer took them.
+    bool submit(const int *channels, int count, qint64 rxNs, qint64 readyNs)
+    {
+        bool coalesced = m_published != m_taken.load(std::memory_order_relaxed);
+        m_slot.publish(0, channels, count, rxNs, readyNs);
+        m_published = m_slot.seq();
+        if (m_signalReady.load(std::memory_order_acquire))
+        {
+            quint64 one = 1;
+            ssize_t n = ::write(m_readyFd, &one, sizeof(one));
+            Q_UNUSED(n)
+        }
+        return coalesced;
+    }
+
+    // Created on first use, from then on every submit signals it
+    int readyFd() override
+    {
+        if (m_readyFd < 0) m_readyFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        m_signalReady.store(m_readyFd >= 0, std::memory_order_release);
+        return m_readyFd;
+    }
+
+    bool open() override { m_isOpen = true; return true; }
+
+    bool poll(ChannelFrame &frame) override
+    {
+        // Cleared before the values are read, a submit after this wakes the mixer again
+        if (m_readyFd >= 0)
+        {
+            quint64 count;
+            ssize_t n = ::read(m_readyFd, &count, sizeof(count));
+            Q_UNUSED(n)
+        }
+
+        ChannelModel::Snapshot snapshot = m_slot.sample();
+        if (snapshot.seq == m_lastSeq) return false;
+        m_lastSeq = snapshot.seq;
+        m_taken.store(snapshot.seq, std::memory_order_relaxed);
+
+        frame.count = snapshot.count;
+        for (int i=0; i<snapshot.count; i++) frame.channels[i] = snapshot.channels[i];
+        frame.failsafe = false;
+        frame.rxNs = snapshot.rxNs;
+        frame.readyNs = snapshot.readyNs;
+        return true;
+    }
+
+private:
+    ChannelModel m_slot;
+    quint32 m_lastSeq;
+    quint32 m_published;                // network thread
+    std::atomic<quint32> m_taken;       // written by the mixer
+    int m_readyFd;
+    std::atomic<bool> m_signalReady;
+};
+
+#endif // NETWORKINPUT_H
@@ -0,0 +1,95 @@
+#ifndef PATHDEDUP_H
+#define PATHDEDUP_H
+
+#include <QtGlobal>
+#include "joystickprotocol.h"
+
+// First arrival wins between the paths of a client that sends every frame
+// over two connections. A ring of the last WINDOW sequence numbers remembers
+// when and on which path each frame arrived first, so the second copy is
+// dropped and credits the winner with its lead. Only frames newer than the
+// newest one kept are used, an older first copy would move the channels back.
+class PathDedup
+{
+public:
+    static const int WINDOW = 64;
+
+    struct PathStats
+    {
+        quint64 wins = 0;           // first copy came on this path
+        quint64 losses = 0;         // second copy came on this path
+        quint64 caught = 0;         // won, then the other copy came
+        quint64 solo = 0;           // won, the other copy never came within the window
+        quint64 late = 0;           // first copy, but older than the newest frame kept
+        qint64 leadSumNs = 0;       // over the wins the other path caught up with
+        qint64 leadMaxNs = 0;
+    };
+
+    enum Result
+    {
+        First,
+        Duplicate,
+        Late
+    };
+
+    PathDedup() : m_highest(0), m_started(false)
+    {
+        for (int i=0; i<WINDOW; i++) m_slots[i].used = false;
+    }
+
+    Result submit(int path, quint32 seq, qint64 nowNs)
+    {
+        Slot &slot = m_slots[seq % WINDOW];
+        if (slot.used && slot.seq == seq)
+        {
+            // The loser, or a repeat on the same path
+            if (!slot.matched && slot.path != path)
+            {
+                slot.matched = true;
+                PathStats &winner = m_stats[slot.path];
+                winner.caught++;
+                qint64 lead = nowNs - slot.firstNs;
+                winner.leadSumNs += lead;
+                winner.leadMaxNs = qMax(winner.leadMaxNs, lead);
+                m_stats[path].losses++;
+            }
+            return Duplicate;
+        }
+
+        if (m_started && qint32(seq - m_highest) <= 0)
+        {
+            m_stats[path].late++;
+            return Late;
+        }
+
+        if (slot.used && !slot.matched) m_stats[slot.path].solo++;
+        slot.seq = seq;
+        slot.firstNs = nowNs;
+        slot.path = path;
+        slot.matched = false;
+        slot.used = true;
+        m_highest = seq;
+        m_started = true;
+        m_stats[path].wins++;
+        return First;
+    }
+
+    const PathStats &stats(int path) const { return m_stats[path]; }
+
+private:
+    struct Slot
+    {
+        quint32 seq;
+        qint64 firstNs;
+        int path;
+        bool matched;
+        bool used;
+    };
+
+    Slot m_slots[WINDOW];
+    PathStats m_stats[FRAME_PATHS];
+    quint32 m_highest;
+    bool m_started;
+};
+
+#endif // PATHDEDUP_H
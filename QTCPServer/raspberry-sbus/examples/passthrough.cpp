@@ -69,12 +69,15 @@ int main(int argc, char **argv)
 #ifdef FTDI_ADAPTER
     // enable only if you have weird packet timings (mostly on FTDI chips)
     err = sbus.setLowLatencyMode(true);
-    if (err != SBUS_OK)
+    if (err == SBUS_ERR_UNSUPPORTED)
+        cout << "Low latency mode not supported by this tty" << endl;
+    else if (err != SBUS_OK)
     {
         cerr << "SBUS set low latency error: " << err << endl;
         return err;
     }
-    cout << "Low latency mode enabled" << endl;
+    else
+        cout << "Low latency mode enabled" << endl;
 #endif
 
     cout << "SBUS installed" << endl;
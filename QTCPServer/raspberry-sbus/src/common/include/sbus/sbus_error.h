@@ -10,6 +10,7 @@ enum sbus_err_t
     SBUS_ERR_OPEN = -4,
     SBUS_ERR_INVALID_ARG = -5,
     SBUS_ERR_DESYNC = -6,
+    SBUS_ERR_UNSUPPORTED = -7,
 };
 
 #endif
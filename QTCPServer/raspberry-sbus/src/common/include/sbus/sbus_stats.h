@@ -0,0 +1,30 @@
+#ifndef RPISBUS_SBUS_STATS_H
+#define RPISBUS_SBUS_STATS_H
+
+#ifdef __cplusplus
+#include <cstdint>
+#else
+#include <stdint.h>
+#endif
+
+/*
+ * Snapshot of the decoder health counters.
+ * Counters are cumulative since the decoder was created.
+ * Intervals are measured between reads that delivered at least one good frame,
+ * so they show the rate at which data actually arrives, not the wire timing.
+ */
+struct sbus_stats_t
+{
+    uint32_t goodFrames;     // frames that passed header/footer check and decoded
+    uint32_t badFrames;      // candidate frames with a bad footer
+    uint32_t bytesDiscarded; // bytes that never became part of a good frame
+    uint32_t resyncs;        // times a locked stream lost frame alignment
+    uint32_t frameLost;      // good frames with the frame lost flag set
+    uint32_t failsafe;       // good frames with the failsafe flag set
+
+    uint32_t intervalMinUs;
+    uint32_t intervalMeanUs;
+    uint32_t intervalMaxUs;
+};
+
+#endif
@@ -6,6 +6,18 @@ DecoderFSM::DecoderFSM()
         , _packetPos(0)
         , _lastPacket({0})
         , _packetCb(nullptr)
+        , _frameSeq(0)
+        , _goodFrames(0)
+        , _badFrames(0)
+        , _bytesDiscarded(0)
+        , _resyncs(0)
+        , _frameLost(0)
+        , _failsafe(0)
+        , _intervalMinUs(0)
+        , _intervalMaxUs(0)
+        , _intervalSumUs(0)
+        , _intervalCount(0)
+        , _locked(false)
 {
     _lastPacket.failsafe = true;
     _lastPacket.frameLost = true;
@@ -13,9 +25,19 @@ DecoderFSM::DecoderFSM()
 
 sbus_err_t DecoderFSM::feed(const uint8_t buf[], int bufSize, bool *hadDesyncOut)
 {
+    return feed(buf, bufSize, hadDesyncOut, nullptr, 0, nullptr);
+}
+
+sbus_err_t DecoderFSM::feed(const uint8_t buf[], int bufSize, bool *hadDesyncOut,
+                            sbus_frame_t frames[], int maxFrames, int *nFramesOut)
+{
+    int nFrames = 0;
     bool hadDesync = false;
 
     int headerByte = -1;
+    uint32_t discarded = 0;
+    bool haveNow = false;
+    std::chrono::steady_clock::time_point now;
 
     for (int i = 0; i < bufSize; i++)
     {
@@ -29,6 +51,7 @@ sbus_err_t DecoderFSM::feed(const uint8_t buf[], int bufSize, bool *hadDesyncOut
                     {
                         // skip this header
                         _state = State::WAIT_FOR_HEADER;
+                        discarded++;
                         break;
                     }
 
@@ -39,6 +62,10 @@ sbus_err_t DecoderFSM::feed(const uint8_t buf[], int bufSize, bool *hadDesyncOut
                     _packetPos = 1;
                     _state = State::PACKET;
                 }
+                else
+                {
+                    discarded++;
+                }
                 break;
 
             case State::PACKET:
@@ -51,6 +78,28 @@ sbus_err_t DecoderFSM::feed(const uint8_t buf[], int bufSize, bool *hadDesyncOut
                         decodePacket() == SBUS_OK)
                     {
                         hadDesync = false;  // clear desync if last packet was ok
+                        if (!haveNow)
+                        {
+                            now = std::chrono::steady_clock::now();
+                            haveNow = true;
+                        }
+                        _frameSeq++;
+                        countFrame(now);
+
+                        if (frames && maxFrames > 0)
+                        {
+                            if (nFrames == maxFrames)
+                            {
+                                // full, drop the oldest frame
+                                for (int f = 1; f < maxFrames; f++)
+                                    frames[f - 1] = frames[f];
+                                nFrames--;
+                            }
+                            frames[nFrames].seq = _frameSeq;
+                            frames[nFrames].packet = _lastPacket;
+                            nFrames++;
+                        }
+
                         notifyCallback();
 
                         // receive next packet
@@ -59,6 +108,9 @@ sbus_err_t DecoderFSM::feed(const uint8_t buf[], int bufSize, bool *hadDesyncOut
                     // packet error but we found other possible headers
                     else if (headerByte >= 0)
                     {
+                        countBadFrame();
+                        // only the header byte is dropped, the rest is scanned again
+                        discarded++;
                         // retry scanning after last header
                         i = headerByte;
                         _state = State::WAIT_FOR_HEADER;
@@ -66,6 +118,8 @@ sbus_err_t DecoderFSM::feed(const uint8_t buf[], int bufSize, bool *hadDesyncOut
                     else // out of headers to scan
                     {
                         hadDesync = true;
+                        countBadFrame();
+                        discarded += SBUS_PACKET_SIZE;
                         /*
                          * SBUS header is '15' and packet end is '0'.
                          * In case the packet looks like this:
@@ -104,9 +158,15 @@ sbus_err_t DecoderFSM::feed(const uint8_t buf[], int bufSize, bool *hadDesyncOut
         }
     }
 
+    if (discarded)
+        bump(_bytesDiscarded, discarded);
+
     if (hadDesyncOut)
         *hadDesyncOut = hadDesync;
 
+    if (nFramesOut)
+        *nFramesOut = nFrames;
+
     return SBUS_OK;
 }
 
@@ -136,6 +196,70 @@ const sbus_packet_t& DecoderFSM::lastPacket() const
     return _lastPacket;
 }
 
+void DecoderFSM::bump(std::atomic<uint32_t> &counter, uint32_t n)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+void DecoderFSM::countFrame(std::chrono::steady_clock::time_point now)
+{
+    bump(_goodFrames);
+    if (_lastPacket.frameLost)
+        bump(_frameLost);
+    if (_lastPacket.failsafe)
+        bump(_failsafe);
+
+    // frames decoded by the same read share a timestamp, only time between reads counts
+    if (_locked && now != _lastFrameTime)
+    {
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(now - _lastFrameTime).count();
+        uint32_t interval = us > UINT32_MAX ? UINT32_MAX : (uint32_t) us;
+
+        uint32_t count = _intervalCount.load(std::memory_order_relaxed);
+        if (count == 0 || interval < _intervalMinUs.load(std::memory_order_relaxed))
+            _intervalMinUs.store(interval, std::memory_order_relaxed);
+        if (interval > _intervalMaxUs.load(std::memory_order_relaxed))
+            _intervalMaxUs.store(interval, std::memory_order_relaxed);
+        _intervalSumUs.store(_intervalSumUs.load(std::memory_order_relaxed) + interval, std::memory_order_relaxed);
+        _intervalCount.store(count + 1, std::memory_order_relaxed);
+    }
+
+    _lastFrameTime = now;
+    _locked = true;
+}
+
+void DecoderFSM::countBadFrame()
+{
+    bump(_badFrames);
+    if (_locked)
+    {
+        bump(_resyncs);
+        _locked = false;
+    }
+}
+
+uint32_t DecoderFSM::frameSeq() const
+{
+    return _frameSeq;
+}
+
+sbus_stats_t DecoderFSM::stats() const
+{
+    sbus_stats_t s;
+    s.goodFrames = _goodFrames.load(std::memory_order_relaxed);
+    s.badFrames = _badFrames.load(std::memory_order_relaxed);
+    s.bytesDiscarded = _bytesDiscarded.load(std::memory_order_relaxed);
+    s.resyncs = _resyncs.load(std::memory_order_relaxed);
+    s.frameLost = _frameLost.load(std::memory_order_relaxed);
+    s.failsafe = _failsafe.load(std::memory_order_relaxed);
+
+    uint32_t count = _intervalCount.load(std::memory_order_relaxed);
+    s.intervalMinUs = count ? _intervalMinUs.load(std::memory_order_relaxed) : 0;
+    s.intervalMaxUs = count ? _intervalMaxUs.load(std::memory_order_relaxed) : 0;
+    s.intervalMeanUs = count ? (uint32_t) (_intervalSumUs.load(std::memory_order_relaxed) / count) : 0;
+    return s;
+}
+
 sbus_err_t DecoderFSM::onPacket(sbus_packet_cb cb)
 {
     _packetCb = cb;
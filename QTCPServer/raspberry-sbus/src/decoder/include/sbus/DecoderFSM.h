@@ -1,12 +1,21 @@
 #ifndef RPISBUS_DECODER_FSM_H
 #define RPISBUS_DECODER_FSM_H
 
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 #include "sbus/sbus_error.h"
 #include "sbus/sbus_packet.h"
+#include "sbus/sbus_stats.h"
 
 typedef void (*sbus_packet_cb)(const sbus_packet_t&);
 
+struct sbus_frame_t
+{
+    uint32_t seq;   // decoder frame sequence number, starts at 1
+    sbus_packet_t packet;
+};
+
 class DecoderFSM
 {
 public:
@@ -14,10 +23,24 @@ public:
 
     sbus_err_t feed(const uint8_t buf[], int bufSize, bool *hadDesyncOut);
 
+    /// Feed bytes and collect the frames decoded from exactly these bytes.
+    /// If more than maxFrames frames are decoded only the newest are kept.
+    /// \param frames Receives the decoded frames, oldest first
+    /// \param maxFrames Size of the frames array
+    /// \param nFramesOut Number of frames written to the array
+    sbus_err_t feed(const uint8_t buf[], int bufSize, bool *hadDesyncOut,
+                    sbus_frame_t frames[], int maxFrames, int *nFramesOut);
+
     sbus_err_t onPacket(sbus_packet_cb cb);
 
     const sbus_packet_t& lastPacket() const;
 
+    /// Sequence number of lastPacket(), 0 until the first frame is decoded.
+    uint32_t frameSeq() const;
+
+    /// Health counters, safe to call from any thread while feed() is running.
+    sbus_stats_t stats() const;
+
 private:
     enum class State
     {
@@ -31,6 +54,27 @@ private:
 
     sbus_packet_t _lastPacket;
     sbus_packet_cb _packetCb;
+    uint32_t _frameSeq;
+
+    // Counters are only written by the thread calling feed(),
+    // so a relaxed load/store is enough and avoids locked read-modify-write.
+    std::atomic<uint32_t> _goodFrames;
+    std::atomic<uint32_t> _badFrames;
+    std::atomic<uint32_t> _bytesDiscarded;
+    std::atomic<uint32_t> _resyncs;
+    std::atomic<uint32_t> _frameLost;
+    std::atomic<uint32_t> _failsafe;
+    std::atomic<uint32_t> _intervalMinUs;
+    std::atomic<uint32_t> _intervalMaxUs;
+    std::atomic<uint64_t> _intervalSumUs;
+    std::atomic<uint32_t> _intervalCount;
+
+    bool _locked;
+    std::chrono::steady_clock::time_point _lastFrameTime;
+
+    static void bump(std::atomic<uint32_t> &counter, uint32_t n = 1);
+    void countFrame(std::chrono::steady_clock::time_point now);
+    void countBadFrame();
 
     sbus_err_t verifyPacket();
     sbus_err_t decodePacket();
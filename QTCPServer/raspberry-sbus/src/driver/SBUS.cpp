@@ -4,7 +4,7 @@
 #include "sbus/packet_decoder.h"
 
 SBUS::SBUS() noexcept
-    : _fd(-1)
+    : _fd(-1), _rawCb(nullptr), _rawUser(nullptr)
 {}
 
 SBUS::~SBUS() noexcept
@@ -20,7 +20,11 @@ sbus_err_t SBUS::install(const char path[], bool blocking, uint8_t timeout)
 
 sbus_err_t SBUS::uninstall()
 {
-    return _fd < 0 ? SBUS_OK : sbus_uninstall(_fd);
+    if (_fd < 0)
+        return SBUS_OK;
+    sbus_err_t err = sbus_uninstall(_fd);
+    _fd = -1;
+    return err;
 }
 
 sbus_err_t SBUS::setLowLatencyMode(bool enable)
@@ -33,8 +37,23 @@ sbus_err_t SBUS::onPacket(sbus_packet_cb cb)
     return _decoder.onPacket(cb);
 }
 
+sbus_err_t SBUS::onRawBytes(sbus_raw_cb cb, void *user)
+{
+    _rawCb = cb;
+    _rawUser = user;
+    return SBUS_OK;
+}
+
 sbus_err_t SBUS::read()
 {
+    return read(nullptr, 0, nullptr);
+}
+
+sbus_err_t SBUS::read(sbus_frame_t frames[], int maxFrames, int *nFrames)
+{
+    if (nFrames)
+        *nFrames = 0;
+
     if (_fd < 0)
         return SBUS_FAIL;
 
@@ -44,8 +63,19 @@ sbus_err_t SBUS::read()
     if (nRead <= 0)
         return SBUS_OK;
 
+    if (_rawCb)
+        _rawCb(_readBuf, nRead, _rawUser);
+
+    return decode(_readBuf, nRead, frames, maxFrames, nFrames);
+}
+
+sbus_err_t SBUS::decode(const uint8_t buf[], int size, sbus_frame_t frames[], int maxFrames, int *nFrames)
+{
+    if (nFrames)
+        *nFrames = 0;
+
     bool hadDesync = false;
-    _decoder.feed(_readBuf, nRead, &hadDesync);
+    _decoder.feed(buf, size, &hadDesync, frames, maxFrames, nFrames);
 
     return hadDesync ? SBUS_ERR_DESYNC : SBUS_OK;
 }
@@ -70,3 +100,18 @@ const sbus_packet_t& SBUS::lastPacket() const
 {
     return _decoder.lastPacket();
 }
+
+uint32_t SBUS::frameSeq() const
+{
+    return _decoder.frameSeq();
+}
+
+int SBUS::fd() const
+{
+    return _fd;
+}
+
+sbus_stats_t SBUS::stats() const
+{
+    return _decoder.stats();
+}
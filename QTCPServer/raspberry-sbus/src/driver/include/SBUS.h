@@ -5,9 +5,15 @@
 #include "sbus/sbus_error.h"
 #include "sbus/DecoderFSM.h"
 
+/// Called with the raw bytes of every tty read, before they are decoded.
+typedef void (*sbus_raw_cb)(const uint8_t buf[], int size, void *user);
+
 class SBUS
 {
 public:
+    /// Upper bound of frames a single read() can decode.
+    static constexpr int MAX_FRAMES_PER_READ = 10;
+
     SBUS() noexcept;
 
     virtual ~SBUS() noexcept;
@@ -16,7 +22,8 @@ public:
     /// \param path tty path e.g. "/dev/ttyUSB0"
     /// \param blocking If true, read() will block, else it will return immediately
     /// \param timeout Timeout in deciseconds (10 is 1 second) for read() (only if blocking=true)
-    /// \return Error code or SBUS_OK
+    /// \return Error code or SBUS_OK. A pty (/dev/pts/N) is accepted for testing,
+    /// with its line speed left as is if the kernel rejects the SBUS baud rate.
     sbus_err_t install(const char path[], bool blocking, uint8_t timeout = 0);
 
     /// Close the opened tty.
@@ -26,7 +33,7 @@ public:
     /// Enable "low latency mode" which fixes performance on FTDI USB adapters.
     /// Called after install().
     /// \param enable True to enable and false to disable low latency mode
-    /// \return Error code or SBUS_OK
+    /// \return Error code or SBUS_OK, SBUS_ERR_UNSUPPORTED if the tty is no UART (e.g. a pty)
     sbus_err_t setLowLatencyMode(bool enable);
 
     /// Set function to be called when a packet is received.
@@ -34,12 +41,38 @@ public:
     /// \return Error code or SBUS_OK
     sbus_err_t onPacket(sbus_packet_cb cb);
 
+    /// Set function to be called with the raw bytes of every read, e.g. for recording.
+    /// \param cb Callback or nullptr to remove it
+    /// \param user Passed to cb unchanged
+    /// \return Error code or SBUS_OK
+    sbus_err_t onRawBytes(sbus_raw_cb cb, void *user);
+
     /// Call to process buffered data.
     /// Called after install().
     /// Has to be called frequently to receive packets.
     /// \return SBUS_ERR_DESYNC signaling a bad packet (not fatal), other error code or SBUS_OK
     sbus_err_t read();
 
+    /// Call to process buffered data and get only the frames decoded by this call.
+    /// Called after install().
+    /// Frames from earlier calls are never returned again, so nFrames is 0
+    /// when no new data arrived. The newest frame is frames[nFrames - 1].
+    /// \param frames Receives the new frames, oldest first
+    /// \param maxFrames Size of frames, MAX_FRAMES_PER_READ holds everything
+    /// \param nFrames Number of new frames
+    /// \return SBUS_ERR_DESYNC signaling a bad packet (not fatal), other error code or SBUS_OK
+    sbus_err_t read(sbus_frame_t frames[], int maxFrames, int *nFrames);
+
+    /// Decode bytes that did not come from the tty, e.g. a recording.
+    /// Works without install() and shares the decoder state with read().
+    /// \param buf Raw SBUS bytes
+    /// \param size Number of bytes in buf
+    /// \param frames Receives the new frames, oldest first
+    /// \param maxFrames Size of frames
+    /// \param nFrames Number of new frames
+    /// \return SBUS_ERR_DESYNC signaling a bad packet (not fatal) or SBUS_OK
+    sbus_err_t decode(const uint8_t buf[], int size, sbus_frame_t frames[], int maxFrames, int *nFrames);
+
     /// Send a packet.
     /// Called after install().
     /// \param packet The packet to send
@@ -55,11 +88,28 @@ public:
     /// \return Reference to last received packet
     const sbus_packet_t& lastPacket() const;
 
+    /// Get sequence number of the last received packet.
+    /// \return Frame counter of the decoder, 0 if nothing was received yet
+    uint32_t frameSeq() const;
+
+    /// Get the descriptor of the installed tty, e.g. to wait for data with poll().
+    /// \return Descriptor, negative if nothing is installed
+    int fd() const;
+
+    /// Get decoder health counters.
+    /// Lock free, may be called from another thread while read() is running.
+    /// \return Snapshot of the counters
+    sbus_stats_t stats() const;
+
 private:
     static constexpr int READ_BUF_SIZE = SBUS_PACKET_SIZE * 10;
+    static_assert(MAX_FRAMES_PER_READ >= (READ_BUF_SIZE + SBUS_PACKET_SIZE - 1) / SBUS_PACKET_SIZE,
+                  "a full read plus the tail of the previous packet must fit");
 
     int _fd;
     DecoderFSM _decoder;
+    sbus_raw_cb _rawCb;
+    void *_rawUser;
     uint8_t _readBuf[READ_BUF_SIZE];
     uint8_t _writeBuf[SBUS_PACKET_SIZE];
 };
@@ -20,6 +20,9 @@ enum sbus_err_t sbus_uninstall(int fd);
             int sbus_read(int fd, uint8_t buf[], int bufSize);
 enum sbus_err_t sbus_write(int fd, const uint8_t buf[], int count);
 
+// A pty slave (/dev/pts/N), which stands in for a UART in tests
+           bool sbus_is_pty(int fd);
+
 #ifdef __cplusplus
 }
 #endif
@@ -7,12 +7,16 @@
 
 #include <sys/ioctl.h>
 #include <linux/serial.h>
+#include <errno.h>
 #include <stdio.h>
 
 enum sbus_err_t sbus_set_low_latency(int fd, bool setLowLatency)
 {
     struct serial_struct ser_info;
     int err = ioctl(fd, TIOCGSERIAL, &ser_info);
+    // not a UART (e.g. a pty or some USB adapters), nothing to tune
+    if (err && (errno == ENOTTY || errno == EINVAL))
+        return SBUS_ERR_UNSUPPORTED;
     if (err)
         goto error;
 
@@ -7,10 +7,21 @@
 #include <fcntl.h>
 #include <asm/termbits.h>
 #include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
 
 #include "sbus/sbus_spec.h"
 
 
+// Unix98 pty slaves have the majors 136 to 143
+bool sbus_is_pty(int fd)
+{
+    struct stat st;
+    if (fstat(fd, &st) || !S_ISCHR(st.st_mode))
+        return false;
+    return major(st.st_rdev) >= 136 && major(st.st_rdev) <= 143;
+}
+
 int sbus_install(const char path[], bool blocking, uint8_t timeout)
 {
     int fd = open(path, O_RDWR | O_NOCTTY | (blocking ? 0 : O_NONBLOCK));
@@ -22,8 +33,10 @@ int sbus_install(const char path[], bool blocking, uint8_t timeout)
     struct termios2 options;
     if (ioctl(fd, TCGETS2, &options))
     {
+        close(fd);
         return SBUS_ERR_TCGETS2;
     }
+    tcflag_t speed = options.c_cflag & CBAUD;
 
     // sbus options
     // see man termios(3)
@@ -84,7 +97,13 @@ int sbus_install(const char path[], bool blocking, uint8_t timeout)
 
     if (ioctl(fd, TCSETS2, &options))
     {
-        return SBUS_ERR_TCSETS2;
+        // A pty has no line speed, some kernels reject a custom one
+        options.c_cflag = (options.c_cflag & ~CBAUD) | speed;
+        if (!sbus_is_pty(fd) || ioctl(fd, TCSETS2, &options))
+        {
+            close(fd);
+            return SBUS_ERR_TCSETS2;
+        }
     }
 
     return fd;
@@ -0,0 +1,63 @@
+#include <iostream>
+#include <cstring>
+#include "sbus/packet_decoder.h"
+#include "sbus/DecoderFSM.h"
+
+using namespace std;
+
+int main()
+{
+    sbus_packet_t packet;
+    memset(&packet, 0, sizeof(packet));
+
+    uint8_t stream[SBUS_PACKET_SIZE * 3];
+    for (int f = 0; f < 3; ++f)
+    {
+        packet.channels[0] = 1000 + f;
+        sbus_encode(stream + f * SBUS_PACKET_SIZE, &packet);
+    }
+
+    DecoderFSM decoder;
+    sbus_frame_t frames[2];
+    int nFrames = -1;
+
+    if (decoder.frameSeq() != 0)
+    {
+        cerr << "frameSeq before first frame" << endl;
+        return -1;
+    }
+
+    // three frames into a two frame array keeps the newest two
+    decoder.feed(stream, sizeof(stream), nullptr, frames, 2, &nFrames);
+    if (nFrames != 2 ||
+        frames[0].seq != 2 || frames[0].packet.channels[0] != 1001 ||
+        frames[1].seq != 3 || frames[1].packet.channels[0] != 1002)
+    {
+        cerr << "batch did not keep the newest frames" << endl;
+        return -1;
+    }
+
+    // no new bytes, no frames
+    decoder.feed(stream, 0, nullptr, frames, 2, &nFrames);
+    if (nFrames != 0 || decoder.frameSeq() != 3)
+    {
+        cerr << "stale frame returned" << endl;
+        return -1;
+    }
+
+    // a frame split over two reads is returned once, by the read that completes it
+    decoder.feed(stream, 10, nullptr, frames, 2, &nFrames);
+    if (nFrames != 0)
+    {
+        cerr << "partial frame returned" << endl;
+        return -1;
+    }
+    decoder.feed(stream + 10, SBUS_PACKET_SIZE - 10, nullptr, frames, 2, &nFrames);
+    if (nFrames != 1 || frames[0].seq != 4 || frames[0].packet.channels[0] != 1000)
+    {
+        cerr << "split frame not returned" << endl;
+        return -1;
+    }
+
+    return 0;
+}
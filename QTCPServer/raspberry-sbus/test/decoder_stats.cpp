@@ -0,0 +1,69 @@
+#include <iostream>
+#include <cstring>
+#include "sbus/packet_decoder.h"
+#include "sbus/DecoderFSM.h"
+
+using namespace std;
+
+int main()
+{
+    sbus_packet_t packet;
+    memset(&packet, 0, sizeof(packet));
+    for (int i = 0; i < SBUS_NUM_CHANNELS; ++i)
+        packet.channels[i] = 100 + i;
+
+    uint8_t good[SBUS_PACKET_SIZE];
+    sbus_encode(good, &packet);
+
+    packet.failsafe = true;
+    uint8_t failsafe[SBUS_PACKET_SIZE];
+    sbus_encode(failsafe, &packet);
+
+    DecoderFSM decoder;
+
+    // two good frames
+    decoder.feed(good, SBUS_PACKET_SIZE, nullptr);
+    decoder.feed(good, SBUS_PACKET_SIZE, nullptr);
+
+    // three bytes of noise, then a frame with a broken footer
+    const uint8_t noise[] = {0x01, 0x02, 0x03};
+    decoder.feed(noise, sizeof(noise), nullptr);
+    uint8_t broken[SBUS_PACKET_SIZE];
+    memcpy(broken, good, SBUS_PACKET_SIZE);
+    broken[SBUS_PACKET_SIZE - 1] = 0xff;
+    bool hadDesync = false;
+    decoder.feed(broken, SBUS_PACKET_SIZE, &hadDesync);
+
+    // recover with a failsafe frame
+    decoder.feed(failsafe, SBUS_PACKET_SIZE, nullptr);
+
+    sbus_stats_t stats = decoder.stats();
+
+    if (stats.goodFrames != 3)
+    {
+        cerr << "goodFrames " << stats.goodFrames << " != 3" << endl;
+        return -1;
+    }
+    if (stats.badFrames == 0 || stats.resyncs != 1)
+    {
+        cerr << "badFrames " << stats.badFrames << " resyncs " << stats.resyncs << endl;
+        return -1;
+    }
+    if (stats.bytesDiscarded < sizeof(noise))
+    {
+        cerr << "bytesDiscarded " << stats.bytesDiscarded << endl;
+        return -1;
+    }
+    if (stats.failsafe != 1 || stats.frameLost != 0)
+    {
+        cerr << "failsafe " << stats.failsafe << " frameLost " << stats.frameLost << endl;
+        return -1;
+    }
+    if (stats.intervalMinUs > stats.intervalMeanUs || stats.intervalMeanUs > stats.intervalMaxUs)
+    {
+        cerr << "intervals out of order" << endl;
+        return -1;
+    }
+
+    return 0;
+}
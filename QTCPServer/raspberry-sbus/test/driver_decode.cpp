@@ -0,0 +1,47 @@
+#include <iostream>
+#include <cstring>
+#include "SBUS.h"
+#include "sbus/packet_decoder.h"
+
+using namespace std;
+
+int main()
+{
+    sbus_packet_t packet;
+    memset(&packet, 0, sizeof(packet));
+
+    uint8_t stream[SBUS_PACKET_SIZE * 2];
+    for (int f = 0; f < 2; ++f)
+    {
+        packet.channels[5] = 300 + f;
+        sbus_encode(stream + f * SBUS_PACKET_SIZE, &packet);
+    }
+
+    // decode() works without a tty, e.g. for replaying a recording
+    SBUS sbus;
+    sbus_frame_t frames[SBUS::MAX_FRAMES_PER_READ];
+    int nFrames = -1;
+
+    sbus_err_t err = sbus.decode(stream, sizeof(stream), frames, SBUS::MAX_FRAMES_PER_READ, &nFrames);
+    if (err != SBUS_OK || nFrames != 2 ||
+        frames[0].packet.channels[5] != 300 || frames[1].packet.channels[5] != 301)
+    {
+        cerr << "decode without install failed" << endl;
+        return -1;
+    }
+
+    if (sbus.stats().goodFrames != 2 || sbus.frameSeq() != 2)
+    {
+        cerr << "decode did not update the decoder state" << endl;
+        return -1;
+    }
+
+    // read() still needs a tty
+    if (sbus.read(frames, SBUS::MAX_FRAMES_PER_READ, &nFrames) != SBUS_FAIL || nFrames != 0)
+    {
+        cerr << "read without install did not fail" << endl;
+        return -1;
+    }
+
+    return 0;
+}
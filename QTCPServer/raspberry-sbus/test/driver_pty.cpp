@@ -0,0 +1,91 @@
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include "SBUS.h"
+#include "sbus/packet_decoder.h"
+
+using namespace std;
+
+// End to end over a pseudo terminal: write a packet to the master side and
+// read it back through the installed slave, no UART needed
+int main()
+{
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) || unlockpt(master))
+    {
+        cout << "no pty available, skipped" << endl;
+        return 0;
+    }
+
+    SBUS sbus;
+    sbus_err_t err = sbus.install(ptsname(master), true, 10);
+    if (err != SBUS_OK)
+    {
+        cerr << "install on pty failed: " << err << endl;
+        return -1;
+    }
+
+    if (sbus.fd() < 0)
+    {
+        cerr << "no descriptor after install" << endl;
+        return -1;
+    }
+
+    err = sbus.setLowLatencyMode(true);
+    if (err != SBUS_OK && err != SBUS_ERR_UNSUPPORTED)
+    {
+        cerr << "low latency mode on pty did not degrade: " << err << endl;
+        return -1;
+    }
+
+    sbus_packet_t packet;
+    memset(&packet, 0, sizeof(packet));
+    packet.channels[0] = 1234;
+    packet.channels[15] = 172;
+    uint8_t buf[SBUS_PACKET_SIZE];
+    sbus_encode(buf, &packet);
+    if (write(master, buf, sizeof(buf)) != ssize_t(sizeof(buf)))
+    {
+        cerr << "write to pty master failed" << endl;
+        return -1;
+    }
+
+    sbus_frame_t frames[SBUS::MAX_FRAMES_PER_READ];
+    int nFrames = 0;
+    for (int i = 0; i < 10 && nFrames == 0; ++i)
+        sbus.read(frames, SBUS::MAX_FRAMES_PER_READ, &nFrames);
+
+    if (nFrames != 1 || frames[0].packet.channels[0] != 1234 || frames[0].packet.channels[15] != 172)
+    {
+        cerr << "packet did not arrive through the pty" << endl;
+        return -1;
+    }
+
+    sbus.uninstall();
+    close(master);
+    if (sbus.fd() != -1)
+    {
+        cerr << "descriptor still set after uninstall" << endl;
+        return -1;
+    }
+
+    // A failed install must not leak its descriptor
+    int before = dup(0);
+    close(before);
+    if (sbus.install("/dev/null", false) == SBUS_OK)
+    {
+        cerr << "install on /dev/null succeeded" << endl;
+        return -1;
+    }
+    int after = dup(0);
+    close(after);
+    if (after != before)
+    {
+        cerr << "failed install leaked a descriptor" << endl;
+        return -1;
+    }
+
+    return 0;
+}
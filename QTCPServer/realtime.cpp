@@ -0,0 +1,154 @@
+#include "realtime.h"
+#include <QStringList>
+#include <alloca.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+
+static const int PREFAULT_MAX_KB = 1024;
+
+static QString policyName(int policy)
+{
+    switch (policy)
+    {
+        case SCHED_FIFO: return "fifo";
+        case SCHED_RR: return "rr";
+        case SCHED_OTHER: return "other";
+    }
+    return QString::number(policy);
+}
+
+QString RealtimeConfig::toString() const
+{
+    QString spec = policyName(policy == PolicyFifo ? SCHED_FIFO : policy == PolicyRr ? SCHED_RR : SCHED_OTHER);
+    if (policy != PolicyOther)
+        spec += QString(":%1").arg(priority);
+    if (!cpus.isEmpty())
+    {
+        QStringList list;
+        foreach (int cpu, cpus) list << QString::number(cpu);
+        spec += "@" + list.join(",");
+    }
+    return spec;
+}
+
+bool RealtimeConfig::parse(const QString &spec, RealtimeConfig &config)
+{
+    RealtimeConfig parsed;
+    QString rest = spec.trimmed().toLower();
+    if (rest.isEmpty())
+    {
+        config = parsed;
+        return true;
+    }
+
+    int at = rest.indexOf('@');
+    if (at >= 0)
+    {
+        foreach (const QString &cpu, rest.mid(at + 1).split(","))
+        {
+            bool ok = false;
+            int n = cpu.toInt(&ok);
+            if (!ok || n < 0 || n >= CPU_SETSIZE) return false;
+            parsed.cpus << n;
+        }
+        rest = rest.left(at);
+    }
+
+    int colon = rest.indexOf(':');
+    QString policy = colon < 0 ? rest : rest.left(colon);
+    if (policy == "fifo") parsed.policy = PolicyFifo;
+    else if (policy == "rr") parsed.policy = PolicyRr;
+    else if (policy == "other" || policy.isEmpty()) parsed.policy = PolicyOther;
+    else return false;
+
+    if (colon >= 0)
+    {
+        bool ok = false;
+        parsed.priority = rest.mid(colon + 1).toInt(&ok);
+        if (!ok || parsed.priority < 0 || parsed.priority > 99) return false;
+    }
+
+    config = parsed;
+    return true;
+}
+
+static void prefaultStack(int kb)
+{
+    size_t size = size_t(qMin(kb, PREFAULT_MAX_KB)) * 1024;
+    volatile unsigned char *stack = static_cast<volatile unsigned char *>(alloca(size));
+    for (size_t i=0; i<size; i+=4096) stack[i] = 0;
+}
+
+QString applyRealtime(const QString &thread, const RealtimeConfig &config, int prefaultKb, bool &ok)
+{
+    QStringList report;
+    ok = true;
+    pthread_t self = pthread_self();
+
+    if (config.policy != RealtimeConfig::PolicyOther)
+    {
+        int policy = config.policy == RealtimeConfig::PolicyFifo ? SCHED_FIFO : SCHED_RR;
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = qBound(sched_get_priority_min(policy), config.priority, sched_get_priority_max(policy));
+
+        int err = pthread_setschedparam(self, policy, &param);
+        if (err != 0)
+        {
+            ok = false;
+            report << QString("%1 requested (%2)").arg(config.toString(), strerror(err));
+        }
+    }
+
+    if (!config.cpus.isEmpty())
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        foreach (int cpu, config.cpus) CPU_SET(cpu, &set);
+
+        int err = pthread_setaffinity_np(self, sizeof(set), &set);
+        if (err != 0)
+        {
+            ok = false;
+            report << QString("affinity not set (%1)").arg(strerror(err));
+        }
+    }
+
+    if (prefaultKb > 0)
+        prefaultStack(prefaultKb);
+
+    // Report what the kernel actually gave us
+    int policy = SCHED_OTHER;
+    struct sched_param param;
+    memset(&param, 0, sizeof(param));
+    pthread_getschedparam(self, &policy, &param);
+
+    QString granted = QString("%1 thread: %2").arg(thread, policyName(policy));
+    if (policy != SCHED_OTHER)
+        granted += QString(":%1").arg(param.sched_priority);
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (pthread_getaffinity_np(self, sizeof(set), &set) == 0)
+    {
+        QStringList cpus;
+        for (int cpu=0; cpu<CPU_SETSIZE; cpu++)
+            if (CPU_ISSET(cpu, &set)) cpus << QString::number(cpu);
+        granted += "@" + cpus.join(",");
+    }
+
+    if (!report.isEmpty())
+        granted += ", " + report.join(", ");
+    return granted;
+}
+
+QString lockMemory(bool &ok)
+{
+    ok = mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+    if (ok)
+        return "Memory locked";
+    return QString("Memory not locked (%1)").arg(strerror(errno));
+}
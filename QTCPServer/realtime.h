@@ -0,0 +1,30 @@
+#ifndef REALTIME_H
+#define REALTIME_H
+
+#include <QList>
+#include <QString>
+
+// Scheduling of one thread, written as "policy[:priority][@cpu,cpu...]",
+// e.g. "fifo:80@3" or "other@0,1". Policies are other, fifo and rr.
+struct RealtimeConfig
+{
+    enum Policy { PolicyOther, PolicyFifo, PolicyRr };
+
+    Policy policy = PolicyOther;
+    int priority = 0;
+    QList<int> cpus;            // empty leaves the affinity alone
+
+    bool isDefault() const { return policy == PolicyOther && cpus.isEmpty(); }
+    QString toString() const;
+    static bool parse(const QString &spec, RealtimeConfig &config);
+};
+
+// Applies config to the calling thread and touches prefaultKb of its stack so
+// the pages are resident before the first tick. Returns a one line report of
+// what was granted, ok is false if anything fell back.
+QString applyRealtime(const QString &thread, const RealtimeConfig &config, int prefaultKb, bool &ok);
+
+// mlockall() for the whole process, current and future pages
+QString lockMemory(bool &ok);
+
+#endif // REALTIME_H
@@ -0,0 +1,160 @@
+#include "recorder.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const char StreamRecorder::MAGIC[8] = { 'J', 'S', 'R', 'E', 'C', '0', '0', '1' };
+
+static qint64 paddedSize(qint64 size)
+{
+    return (size + 7) & ~qint64(7);
+}
+
+StreamRecorder::StreamRecorder() :
+    m_fd(-1), m_base(nullptr), m_capacity(0), m_used(0), m_dropped(0)
+{
+}
+
+StreamRecorder::~StreamRecorder()
+{
+    close();
+}
+
+bool StreamRecorder::open(const QString &path, qint64 capacity, QString &error)
+{
+    close();
+
+    m_fd = ::open(path.toLocal8Bit().constData(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (m_fd < 0 || ftruncate(m_fd, capacity) != 0)
+    {
+        error = QString("Unable to create recording '%1' (%2)").arg(path, strerror(errno));
+        close();
+        return false;
+    }
+
+    void *base = mmap(nullptr, size_t(capacity), PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (base == MAP_FAILED)
+    {
+        error = QString("Unable to map recording '%1' (%2)").arg(path, strerror(errno));
+        close();
+        return false;
+    }
+
+    m_base = static_cast<char *>(base);
+    m_capacity = capacity;
+    memcpy(m_base, MAGIC, sizeof(MAGIC));
+    m_used.store(sizeof(MAGIC), std::memory_order_relaxed);
+    m_dropped.store(0, std::memory_order_relaxed);
+    return true;
+}
+
+void StreamRecorder::close()
+{
+    if (m_base)
+    {
+        munmap(m_base, size_t(m_capacity));
+        m_base = nullptr;
+
+        // Drop the unused tail, a reservation that didn't fit is left as zeros
+        if (ftruncate(m_fd, qMin(m_used.load(std::memory_order_relaxed), m_capacity)) != 0) {}
+    }
+
+    if (m_fd >= 0)
+    {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+bool StreamRecorder::append(Kind kind, int source, const void *data, int size, qint64 timeNs, int stream)
+{
+    if (!m_base || size <= 0)
+        return false;
+
+    qint64 total = paddedSize(qint64(sizeof(RecordHeader)) + size);
+    qint64 offset = m_used.fetch_add(total, std::memory_order_relaxed);
+    if (offset + total > m_capacity)
+    {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    RecordHeader *header = reinterpret_cast<RecordHeader *>(m_base + offset);
+    header->kind = quint8(kind);
+    header->source = quint8(source);
+    header->stream = quint16(stream);
+    header->timeNs = timeNs;
+    memcpy(header + 1, data, size_t(size));
+
+    // Published last so a reader never sees a half written record
+    __atomic_store_n(&header->size, quint32(size), __ATOMIC_RELEASE);
+    return true;
+}
+
+RecordingReader::RecordingReader() : m_fd(-1), m_base(nullptr), m_size(0), m_pos(0)
+{
+}
+
+RecordingReader::~RecordingReader()
+{
+    if (m_base) munmap(const_cast<char *>(m_base), size_t(m_size));
+    if (m_fd >= 0) ::close(m_fd);
+}
+
+bool RecordingReader::open(const QString &path, QString &error)
+{
+    m_fd = ::open(path.toLocal8Bit().constData(), O_RDONLY);
+    struct stat st;
+    if (m_fd < 0 || fstat(m_fd, &st) != 0)
+    {
+        error = QString("Unable to open recording '%1' (%2)").arg(path, strerror(errno));
+        return false;
+    }
+
+    m_size = st.st_size;
+    if (m_size < qint64(sizeof(StreamRecorder::MAGIC)))
+    {
+        error = QString("'%1' is not a recording").arg(path);
+        return false;
+    }
+
+    void *base = mmap(nullptr, size_t(m_size), PROT_READ, MAP_PRIVATE, m_fd, 0);
+    if (base == MAP_FAILED)
+    {
+        error = QString("Unable to map recording '%1' (%2)").arg(path, strerror(errno));
+        return false;
+    }
+    m_base = static_cast<const char *>(base);
+
+    if (memcmp(m_base, StreamRecorder::MAGIC, sizeof(StreamRecorder::MAGIC)) != 0)
+    {
+        error = QString("'%1' is not a recording").arg(path);
+        return false;
+    }
+
+    rewind();
+    return true;
+}
+
+void RecordingReader::rewind()
+{
+    m_pos = sizeof(StreamRecorder::MAGIC);
+}
+
+bool RecordingReader::next(StreamRecorder::RecordHeader &header, const char *&data)
+{
+    if (m_pos + qint64(sizeof(header)) > m_size)
+        return false;
+
+    memcpy(&header, m_base + m_pos, sizeof(header));
+    qint64 total = paddedSize(qint64(sizeof(header)) + header.size);
+    if (header.size == 0 || m_pos + total > m_size)
+        return false;
+
+    data = m_base + m_pos + sizeof(header);
+    m_pos += total;
+    return true;
+}
@@ -0,0 +1,74 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <QString>
+#include <atomic>
+
+// Append only binary recording of everything the inputs received.
+// The file is memory mapped with a fixed capacity, append() reserves space
+// with one atomic add so any thread can record without locking. Each record
+// is a RecordHeader followed by the payload, padded to 8 bytes. The size field
+// is stored last, a record with size 0 marks the end (e.g. after a crash).
+class StreamRecorder
+{
+public:
+    enum Kind
+    {
+        KindSource = 1,     // payload "type:port;unit" describing source index
+        KindNetwork,        // socket read or datagram as received
+        KindSbus,           // raw SBUS bytes from one tty read
+        KindCrsf,           // raw CRSF bytes from one tty read
+        KindShm             // channels frame per shared memory update or heartbeat
+    };
+
+    struct RecordHeader
+    {
+        quint32 size;       // payload bytes, 0 ends the recording
+        quint8 kind;
+        quint8 source;      // input index in priority order
+        quint16 stream;     // connection of a stream input, 0 for others
+        qint64 timeNs;      // monotonicNs() at receive
+    };
+
+    static const char MAGIC[8];
+
+    StreamRecorder();
+    ~StreamRecorder();
+
+    bool open(const QString &path, qint64 capacity, QString &error);
+    void close();
+    bool isOpen() const { return m_base != nullptr; }
+
+    // Any thread, never blocks. False if the file is full or not open.
+    bool append(Kind kind, int source, const void *data, int size, qint64 timeNs, int stream = 0);
+
+    quint64 dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    int m_fd;
+    char *m_base;
+    qint64 m_capacity;
+    std::atomic<qint64> m_used;
+    std::atomic<quint64> m_dropped;
+};
+
+// Sequential reader for the replay tool
+class RecordingReader
+{
+public:
+    RecordingReader();
+    ~RecordingReader();
+
+    bool open(const QString &path, QString &error);
+    // Points data at the payload inside the mapping, false at the end
+    bool next(StreamRecorder::RecordHeader &header, const char *&data);
+    void rewind();
+
+private:
+    int m_fd;
+    const char *m_base;
+    qint64 m_size;
+    qint64 m_pos;
+};
+
+#endif // RECORDER_H
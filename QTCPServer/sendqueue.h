@@ -0,0 +1,73 @@
+#ifndef SENDQUEUE_H
+#define SENDQUEUE_H
+
+#include <QByteArray>
+#include <QList>
+
+// Outbound messages of one TCP client.
+// Qt buffers whatever is written to a socket without limit, so messages wait
+// here and the engine hands them to the socket only while its buffer is
+// nearly empty. Past the byte limit the oldest droppable message (telemetry,
+// superseded by the next snapshot anyway) is dropped. Control frames and text
+// messages are kept, a client that can't take them stays behind and is
+// disconnected by the engine.
+class SendQueue
+{
+public:
+    SendQueue() : m_limit(64 * 1024), m_bytes(0) {}
+
+    void setLimit(int bytes) { m_limit = bytes; }
+
+    // Returns the number of messages dropped to make room
+    int push(const QByteArray &data, bool droppable)
+    {
+        Entry entry;
+        entry.data = data;
+        entry.droppable = droppable;
+        m_entries.append(entry);
+        m_bytes += data.size();
+
+        int dropped = 0;
+        for (int i=0; m_bytes > m_limit && i < m_entries.count(); )
+        {
+            if (!m_entries.at(i).droppable)
+            {
+                i++;
+                continue;
+            }
+            m_bytes -= m_entries.at(i).data.size();
+            m_entries.removeAt(i);
+            dropped++;
+        }
+        return dropped;
+    }
+
+    bool isEmpty() const { return m_entries.isEmpty(); }
+    const QByteArray &front() const { return m_entries.first().data; }
+    void pop()
+    {
+        m_bytes -= m_entries.first().data.size();
+        m_entries.removeFirst();
+    }
+    void clear()
+    {
+        m_entries.clear();
+        m_bytes = 0;
+    }
+
+    int depth() const { return m_entries.count(); }
+    int bytes() const { return m_bytes; }
+
+private:
+    struct Entry
+    {
+        QByteArray data;
+        bool droppable;
+    };
+
+    QList<Entry> m_entries;
+    int m_limit;
+    int m_bytes;
+};
+
+#endif // SENDQUEUE_H
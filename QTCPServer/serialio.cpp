@@ -0,0 +1,255 @@
+#include "serialio.h"
+
+static QByteArray devicePath(const QString &port)
+{
+    return QString("/dev/" + port).toLocal8Bit();
+}
+
+bool SbusInput::open()
+{
+    close();
+
+    if (m_sbus.install(devicePath(m_port).constData(), false) != SBUS_OK)
+    {
+        statusMsg(EventLog::PortError, QString("Failed to open read port '%1'").arg(m_port));
+        return false;
+    }
+
+    if (isRecording())
+        m_sbus.onRawBytes(&SbusInput::recordRaw, this);
+
+    statusMsg(EventLog::PortOpen, QString("SBUS read port open on '%1'").arg(m_port));
+    m_isOpen = true;
+    return true;
+}
+
+void SbusInput::recordRaw(const uint8_t buf[], int size, void *user)
+{
+    static_cast<SbusInput *>(user)->record(StreamRecorder::KindSbus, buf, size);
+}
+
+void SbusInput::close()
+{
+    m_sbus.uninstall();
+    m_isOpen = false;
+}
+
+bool SbusInput::poll(ChannelFrame &frame)
+{
+    int nFrames = 0;
+    sbus_err_t err = m_sbus.read(m_frames, SBUS::MAX_FRAMES_PER_READ, &nFrames);
+    if (err != SBUS_OK && err != SBUS_ERR_DESYNC)
+    {
+        statusMsg(EventLog::ReadFailed, QString("SBUS read failed on '%1'").arg(m_port));
+        return false;
+    }
+
+    // Desync is not fatal and counted by the decoder stats, frames decoded
+    // before or after it are still good. Only the newest frame is used and
+    // failsafe frames from the receiver are ignored.
+    if (nFrames == 0 || m_frames[nFrames - 1].packet.failsafe)
+        return false;
+
+    const sbus_packet_t &packet = m_frames[nFrames - 1].packet;
+    frame.count = SBUS_NUM_CHANNELS;
+    for (int i=0; i<SBUS_NUM_CHANNELS; i++) frame.channels[i] = packet.channels[i];
+    frame.failsafe = false;
+    frame.rxNs = frame.readyNs = 0;
+    return true;
+}
+
+QString SbusInput::health() const
+{
+    sbus_stats_t s = m_sbus.stats();
+    return QString("SBUS in: ok %1 bad %2 drop %3 resync %4 lost %5 fs %6 int %7/%8/%9 ms")
+            .arg(s.goodFrames).arg(s.badFrames).arg(s.bytesDiscarded).arg(s.resyncs)
+            .arg(s.frameLost).arg(s.failsafe)
+            .arg(s.intervalMinUs / 1000.0, 0, 'f', 1)
+            .arg(s.intervalMeanUs / 1000.0, 0, 'f', 1)
+            .arg(s.intervalMaxUs / 1000.0, 0, 'f', 1);
+}
+
+void SbusInput::telemetry(TelemetryInput &in) const
+{
+    sbus_stats_t s = m_sbus.stats();
+    in.type = TelemetryInput::Sbus;
+    in.goodFrames = s.goodFrames;
+    in.badFrames = s.badFrames;
+    in.lostFrames = s.frameLost;
+    in.failsafes = s.failsafe;
+    in.resyncs = s.resyncs;
+}
+
+bool CrsfInput::open()
+{
+    close();
+
+    m_pCRSF = new CrsfSerial(devicePath(m_port).constData(), false);
+    if (!m_pCRSF->isPortOpen())
+    {
+        statusMsg(EventLog::PortError, QString("Failed to open read port '%1'").arg(m_port));
+        delete m_pCRSF;
+        m_pCRSF = nullptr;
+        return false;
+    }
+
+    // Called from inside loop(), so on the mixer thread
+    m_pCRSF->onPacketChannels = [this]() { m_newFrame = true; };
+    if (isRecording())
+        m_pCRSF->onRawBytes = [this](const uint8_t *buf, size_t len) { record(StreamRecorder::KindCrsf, buf, int(len)); };
+
+    statusMsg(EventLog::PortOpen, QString("CRSF read port open on '%1'").arg(m_port));
+    m_isOpen = true;
+    return true;
+}
+
+void CrsfInput::close()
+{
+    delete m_pCRSF;
+    m_pCRSF = nullptr;
+    m_isOpen = false;
+}
+
+bool CrsfInput::poll(ChannelFrame &frame)
+{
+    m_newFrame = false;
+    m_pCRSF->loop();
+    if (!m_newFrame)
+        return false;
+
+    frame.count = CRSF_NUM_CHANNELS;
+    for (int i=0; i<CRSF_NUM_CHANNELS; i++) frame.channels[i] = m_pCRSF->getChannel(unsigned(i + 1));
+    frame.failsafe = false;
+    frame.rxNs = frame.readyNs = 0;
+    return true;
+}
+
+QString CrsfInput::health() const
+{
+    if (!m_pCRSF) return QString();
+
+    crsfSerialStats_t c = m_pCRSF->getStats();
+    return QString("CRSF in: ok %1 crc %2 drop %3 resync %4 down %5 int %6/%7/%8 ms")
+            .arg(c.goodFrames).arg(c.crcErrors).arg(c.bytesDiscarded).arg(c.resyncs)
+            .arg(c.linkDown)
+            .arg(c.intervalMinUs / 1000.0, 0, 'f', 1)
+            .arg(c.intervalMeanUs / 1000.0, 0, 'f', 1)
+            .arg(c.intervalMaxUs / 1000.0, 0, 'f', 1);
+}
+
+void CrsfInput::telemetry(TelemetryInput &in) const
+{
+    in.type = TelemetryInput::Crsf;
+    if (!m_pCRSF) return;
+
+    crsfSerialStats_t c = m_pCRSF->getStats();
+    in.goodFrames = c.goodFrames;
+    in.badFrames = c.crcErrors;
+    in.failsafes = c.linkDown;
+    in.resyncs = c.resyncs;
+    if (!m_pCRSF->isLinkUp()) return;
+
+    const crsfLinkStatistics_t *link = m_pCRSF->getLinkStatistics();
+    in.flags |= TelemetryInput::HasLink;
+    in.uplinkRssi1 = link->uplink_RSSI_1;
+    in.uplinkRssi2 = link->uplink_RSSI_2;
+    in.uplinkQuality = link->uplink_Link_quality;
+    in.uplinkSnr = link->uplink_SNR;
+    in.activeAntenna = link->active_antenna;
+    in.rfMode = link->rf_Mode;
+    in.uplinkTxPower = link->uplink_TX_Power;
+    in.downlinkRssi = link->downlink_RSSI;
+    in.downlinkQuality = link->downlink_Link_quality;
+    in.downlinkSnr = link->downlink_SNR;
+}
+
+bool SbusOutput::open()
+{
+    close();
+
+    if (m_sbus.install(devicePath(m_port).constData(), true) != SBUS_OK)
+    {
+        statusMsg(EventLog::PortError, QString("Failed to open port '%1'").arg(m_port));
+        return false;
+    }
+
+    statusMsg(EventLog::PortOpen, QString("SBUS port open on '%1'").arg(m_port));
+    m_isOpen = true;
+    return true;
+}
+
+void SbusOutput::close()
+{
+    m_sbus.uninstall();
+    m_isOpen = false;
+}
+
+bool SbusOutput::write(const ChannelFrame &frame)
+{
+    sbus_packet_t packet;
+    packet.failsafe = frame.failsafe;
+    packet.frameLost = false;
+    packet.ch17 = false;
+    packet.ch18 = false;
+
+    for (int i=0; i<SBUS_NUM_CHANNELS; i++)
+    {
+        packet.channels[i] = i < frame.count ? uint16_t(frame.channels[i]) : 0;
+    }
+
+    if (m_sbus.write(packet) != SBUS_OK)
+    {
+        statusMsg(EventLog::WriteFailed, QString("Failed to write SBUS port '%1'").arg(m_port));
+        return false;
+    }
+    return true;
+}
+
+bool CrsfOutput::open()
+{
+    close();
+
+    m_pCRSF = new CrsfSerial(devicePath(m_port).constData(), false);
+    if (!m_pCRSF->isPortOpen())
+    {
+        statusMsg(EventLog::PortError, QString("Failed to open port '%1'").arg(m_port));
+        delete m_pCRSF;
+        m_pCRSF = nullptr;
+        return false;
+    }
+
+    statusMsg(EventLog::PortOpen, QString("CRSF port open on '%1'").arg(m_port));
+    m_isOpen = true;
+    return true;
+}
+
+void CrsfOutput::close()
+{
+    delete m_pCRSF;
+    m_pCRSF = nullptr;
+    m_isOpen = false;
+}
+
+bool CrsfOutput::write(const ChannelFrame &frame)
+{
+    // CRSF has no failsafe flag, a receiver signals it by not sending
+    if (frame.failsafe)
+        return true;
+
+    int v[CRSF_NUM_CHANNELS];
+    for (int i=0; i<CRSF_NUM_CHANNELS; i++)
+        v[i] = i < frame.count ? qBound(0, frame.channels[i], 2047) : CRSF_CHANNEL_VALUE_MID;
+
+    crsf_channels_t ch;
+    ch.ch0 = unsigned(v[0]);   ch.ch1 = unsigned(v[1]);   ch.ch2 = unsigned(v[2]);   ch.ch3 = unsigned(v[3]);
+    ch.ch4 = unsigned(v[4]);   ch.ch5 = unsigned(v[5]);   ch.ch6 = unsigned(v[6]);   ch.ch7 = unsigned(v[7]);
+    ch.ch8 = unsigned(v[8]);   ch.ch9 = unsigned(v[9]);   ch.ch10 = unsigned(v[10]); ch.ch11 = unsigned(v[11]);
+    ch.ch12 = unsigned(v[12]); ch.ch13 = unsigned(v[13]); ch.ch14 = unsigned(v[14]); ch.ch15 = unsigned(v[15]);
+
+    if (!m_pCRSF->writePacket(CRSF_ADDRESS_FLIGHT_CONTROLLER, CRSF_FRAMETYPE_RC_CHANNELS_PACKED, &ch, sizeof(ch)))
+    {
+        statusMsg(EventLog::WriteFailed, QString("Failed to write CRSF port '%1'").arg(m_port));
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,74 @@
+#ifndef SERIALIO_H
+#define SERIALIO_H
+
+#include <SBUS.h>
+#include <CrsfSerial.h>
+#include "channelio.h"
+
+// Serial sources and sinks, port is the tty name without /dev/
+
+class SbusInput : public InputSource
+{
+public:
+    explicit SbusInput(const QString &port) : InputSource("sbus", port, UnitSbus) {}
+
+    bool open() override;
+    void close() override;
+    bool poll(ChannelFrame &frame) override;
+    QString health() const override;
+    void telemetry(TelemetryInput &in) const override;
+    int readyFd() override { return m_isOpen ? m_sbus.fd() : -1; }
+
+private:
+    static void recordRaw(const uint8_t buf[], int size, void *user);
+
+    SBUS m_sbus;
+    sbus_frame_t m_frames[SBUS::MAX_FRAMES_PER_READ];
+};
+
+class CrsfInput : public InputSource
+{
+public:
+    explicit CrsfInput(const QString &port) : InputSource("crsf", port, UnitCrsf), m_pCRSF(nullptr), m_newFrame(false) {}
+    ~CrsfInput() { close(); }
+
+    bool open() override;
+    void close() override;
+    bool poll(ChannelFrame &frame) override;
+    QString health() const override;
+    void telemetry(TelemetryInput &in) const override;
+    int readyFd() override { return m_pCRSF ? m_pCRSF->portFd() : -1; }
+
+private:
+    CrsfSerial *m_pCRSF;
+    bool m_newFrame;
+};
+
+class SbusOutput : public OutputSink
+{
+public:
+    explicit SbusOutput(const QString &port) : OutputSink("sbus", port) {}
+
+    bool open() override;
+    void close() override;
+    bool write(const ChannelFrame &frame) override;
+
+private:
+    SBUS m_sbus;
+};
+
+class CrsfOutput : public OutputSink
+{
+public:
+    explicit CrsfOutput(const QString &port) : OutputSink("crsf", port), m_pCRSF(nullptr) {}
+    ~CrsfOutput() { close(); }
+
+    bool open() override;
+    void close() override;
+    bool write(const ChannelFrame &frame) override;
+
+private:
+    CrsfSerial *m_pCRSF;
+};
+
+#endif // SERIALIO_H
@@ -0,0 +1,100 @@
+#ifndef SHMCHANNELS_H
+#define SHMCHANNELS_H
+
+#include <atomic>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Channel frame shared with producers on the same machine, e.g. an autopilot
+// or a vision tracker, through a POSIX shared memory region (shm_open).
+// The producer writes the values under a seqlock and bumps the heartbeat
+// with plain stores, no syscall per frame. The mixer reads the region
+// directly every tick. A frame stays fresh while the heartbeat moves, so a
+// producer holding still only bumps it, and one that stops goes stale after
+// the source's timeout like any other input.
+// Header only and without Qt, producers can include it as is.
+
+static const uint32_t SHM_CHANNELS_MAGIC = 0x31434853;     // "SHC1"
+static const int SHM_MAX_CHANNELS = 16;
+
+struct ShmChannelBlock
+{
+    std::atomic<uint32_t> magic;        // set once by whoever maps it first
+    std::atomic<uint32_t> seq;          // odd while a frame is written
+    std::atomic<uint32_t> heartbeat;
+    std::atomic<int32_t> count;
+    std::atomic<int32_t> channels[SHM_MAX_CHANNELS];      // in the bridge's network unit, SBUS by default
+    std::atomic<int64_t> stampNs;       // CLOCK_MONOTONIC of the write, for the latency report
+};
+
+// Maps the region name (e.g. "/qtcpserver"), creating it if it doesn't exist.
+// Null with errno set on failure.
+inline ShmChannelBlock *shmChannelsMap(const char *name)
+{
+    int fd = shm_open(name, O_RDWR | O_CREAT, 0660);
+    if (fd < 0) return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (st.st_size < off_t(sizeof(ShmChannelBlock)) && ftruncate(fd, sizeof(ShmChannelBlock)) != 0))
+    {
+        int error = errno;
+        close(fd);
+        errno = error;
+        return nullptr;
+    }
+
+    void *p = mmap(nullptr, sizeof(ShmChannelBlock), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return nullptr;
+
+    // A new region is zero filled, which is a valid empty block
+    ShmChannelBlock *block = static_cast<ShmChannelBlock *>(p);
+    uint32_t expected = 0;
+    block->magic.compare_exchange_strong(expected, SHM_CHANNELS_MAGIC);
+    if (block->magic.load() != SHM_CHANNELS_MAGIC)
+    {
+        munmap(p, sizeof(ShmChannelBlock));
+        errno = EINVAL;
+        return nullptr;
+    }
+    return block;
+}
+
+inline void shmChannelsUnmap(ShmChannelBlock *block)
+{
+    munmap(block, sizeof(ShmChannelBlock));
+}
+
+// Producer, one per region: new values, which also count as a heartbeat
+inline void shmChannelsPublish(ShmChannelBlock *block, const int *values, int count)
+{
+    if (count < 0) count = 0;
+    if (count > SHM_MAX_CHANNELS) count = SHM_MAX_CHANNELS;
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    uint32_t seq = block->seq.load(std::memory_order_relaxed);
+    block->seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    block->count.store(count, std::memory_order_relaxed);
+    for (int i=0; i<count; i++) block->channels[i].store(values[i], std::memory_order_relaxed);
+    block->stampNs.store(int64_t(ts.tv_sec) * 1000000000LL + ts.tv_nsec, std::memory_order_relaxed);
+
+    block->seq.store(seq + 2, std::memory_order_release);
+    block->heartbeat.fetch_add(1, std::memory_order_release);
+}
+
+// Producer: still alive, the current values stand
+inline void shmChannelsHeartbeat(ShmChannelBlock *block)
+{
+    block->heartbeat.fetch_add(1, std::memory_order_release);
+}
+
+#endif // SHMCHANNELS_H
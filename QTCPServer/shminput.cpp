@@ -0,0 +1,117 @@
+#include "shminput.h"
+#include <errno.h>
+#include <string.h>
+
+// Reads retried while the producer is writing, a producer that died in the
+// middle of a frame must not hang the mixer
+static const int SHM_READ_RETRIES = 64;
+
+ShmInput::ShmInput(const QString &port) :
+    InputSource("shm", port, UnitSbus), m_block(nullptr),
+    m_lastSeq(0), m_lastHeartbeat(0), m_frames(0), m_heartbeats(0), m_torn(0)
+{
+}
+
+ShmInput::~ShmInput()
+{
+    close();
+}
+
+bool ShmInput::open()
+{
+    close();
+
+    m_block = shmChannelsMap(("/" + m_port).toLocal8Bit().constData());
+    if (!m_block)
+    {
+        statusMsg(EventLog::PortOpen, QString("Unable to map shared memory '/%1': %2").arg(m_port, strerror(errno)));
+        return false;
+    }
+
+    // Only what is written from now on counts
+    m_lastSeq = m_block->seq.load(std::memory_order_acquire);
+    m_lastHeartbeat = m_block->heartbeat.load(std::memory_order_acquire);
+    m_isOpen = true;
+    statusMsg(EventLog::PortOpen, QString("Shared memory '/%1' mapped").arg(m_port));
+    return true;
+}
+
+void ShmInput::close()
+{
+    if (m_block)
+    {
+        shmChannelsUnmap(m_block);
+        m_block = nullptr;
+    }
+    m_isOpen = false;
+}
+
+bool ShmInput::poll(ChannelFrame &frame)
+{
+    if (!m_block) return false;
+
+    quint32 heartbeat = m_block->heartbeat.load(std::memory_order_acquire);
+    if (heartbeat == m_lastHeartbeat) return false;
+
+    int count = 0;
+    int channels[SHM_MAX_CHANNELS];
+    qint64 stampNs = 0;
+    quint32 before = 0;
+    for (int attempt = 0; ; attempt++)
+    {
+        if (attempt == SHM_READ_RETRIES)
+        {
+            m_torn++;
+            return false;
+        }
+
+        before = m_block->seq.load(std::memory_order_acquire);
+        if (before & 1) continue;
+        count = qBound(0, int(m_block->count.load(std::memory_order_relaxed)), SHM_MAX_CHANNELS);
+        for (int i=0; i<count; i++) channels[i] = m_block->channels[i].load(std::memory_order_relaxed);
+        stampNs = m_block->stampNs.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_block->seq.load(std::memory_order_relaxed) == before) break;
+    }
+
+    m_lastHeartbeat = heartbeat;
+    // A heartbeat before the first frame keeps nothing alive
+    if (count == 0) return false;
+
+    frame.count = count;
+    for (int i=0; i<count; i++) frame.channels[i] = channels[i];
+    frame.failsafe = false;
+    if (before != m_lastSeq)
+    {
+        m_lastSeq = before;
+        m_frames++;
+        frame.rxNs = frame.readyNs = stampNs;
+    }
+    else
+    {
+        // Held values, published long ago, nothing to time
+        m_heartbeats++;
+        frame.rxNs = frame.readyNs = 0;
+    }
+
+    if (isRecording())
+    {
+        QByteArray payload;
+        appendChannelsFrame(payload, before, channels, count);
+        record(StreamRecorder::KindShm, payload.constData(), payload.size());
+    }
+    return true;
+}
+
+QString ShmInput::health() const
+{
+    if (!m_block) return QString();
+    return QString("%1: %2 frames, %3 heartbeats, %4 torn reads").arg(name()).arg(m_frames).arg(m_heartbeats).arg(m_torn);
+}
+
+void ShmInput::telemetry(TelemetryInput &in) const
+{
+    in.type = TelemetryInput::Shm;
+    in.goodFrames = m_frames;
+    in.badFrames = m_torn;
+}
@@ -0,0 +1,32 @@
+#ifndef SHMINPUT_H
+#define SHMINPUT_H
+
+#include "channelio.h"
+#include "shmchannels.h"
+
+// Channels from a producer on the same machine through shared memory, see
+// shmchannels.h. port is the region name without the leading '/'.
+// The mixer reads the region in poll(), there is no thread, socket or
+// parser in between.
+class ShmInput : public InputSource
+{
+public:
+    explicit ShmInput(const QString &port);
+    ~ShmInput();
+
+    bool open() override;
+    void close() override;
+    bool poll(ChannelFrame &frame) override;
+    QString health() const override;
+    void telemetry(TelemetryInput &in) const override;
+
+private:
+    ShmChannelBlock *m_block;
+    quint32 m_lastSeq;
+    quint32 m_lastHeartbeat;
+    quint32 m_frames;           // new values
+    quint32 m_heartbeats;       // heartbeats without new values
+    quint32 m_torn;             // reads abandoned while the producer was writing
+};
+
+#endif // SHMINPUT_H
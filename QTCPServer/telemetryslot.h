@@ -0,0 +1,70 @@
+#ifndef TELEMETRYSLOT_H
+#define TELEMETRYSLOT_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <string.h>
+#include "joystickprotocol.h"
+
+// Latest encoded telemetry payload.
+// The mixer thread encodes a snapshot once per telemetry tick, the network
+// thread copies it out and frames it for every subscriber. Single writer
+// seqlock over atomic words, so neither side ever blocks.
+class TelemetrySlot
+{
+public:
+    static const int WORDS = (TELEMETRY_MAX_PAYLOAD + 3) / 4;
+    static const int BYTES = WORDS * 4;
+
+    TelemetrySlot() : m_seq(0), m_size(0)
+    {
+        for (int i=0; i<WORDS; i++) m_words[i].store(0, std::memory_order_relaxed);
+    }
+
+    // Mixer thread, payload holds BYTES bytes
+    void publish(const char *payload, int size)
+    {
+        size = qBound(0, size, TELEMETRY_MAX_PAYLOAD);
+        quint32 seq = m_seq.load(std::memory_order_relaxed);
+        m_seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        m_size.store(size, std::memory_order_relaxed);
+        for (int i=0; i<(size + 3) / 4; i++)
+        {
+            quint32 word;
+            memcpy(&word, payload + 4 * i, 4);
+            m_words[i].store(word, std::memory_order_relaxed);
+        }
+
+        m_seq.store(seq + 2, std::memory_order_release);
+    }
+
+    // Copies the newest payload into payload (BYTES bytes). Returns a number
+    // that changes with every publish, 0 before the first one.
+    quint32 sample(char *payload, int &size) const
+    {
+        quint32 before, after;
+        do
+        {
+            before = m_seq.load(std::memory_order_acquire);
+            size = m_size.load(std::memory_order_relaxed);
+            for (int i=0; i<(size + 3) / 4; i++)
+            {
+                quint32 word = m_words[i].load(std::memory_order_relaxed);
+                memcpy(payload + 4 * i, &word, 4);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = m_seq.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+
+        return before;
+    }
+
+private:
+    std::atomic<quint32> m_seq;
+    std::atomic<int> m_size;
+    std::atomic<quint32> m_words[WORDS];
+};
+
+#endif // TELEMETRYSLOT_H
@@ -0,0 +1,108 @@
+#include "textprotocol.h"
+#include <QDataStream>
+
+QString formatTextMessage(const int *values, int count)
+{
+    QString str = QString("B,%1,").arg(count);
+    for (int i=0; i<count; i++)
+        str += QString::number(values[i]) + ",";
+
+    int checksum = 0;
+    for (int i=0; i<str.count(); i++)
+        checksum += str.at(i).toLatin1();
+
+    return str + QString("E,%1").arg(checksum);
+}
+
+QByteArray writeTextMessage(const QString &str)
+{
+    QByteArray block;
+    QDataStream out(&block, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_11);
+    out << str;
+    return block;
+}
+
+bool parseTextMessage(const QString &str, int values[TEXT_MAX_CHANNELS], int &count, QString &error)
+{
+    count = 0;
+    error.clear();
+    if (str.isEmpty()) return false;
+
+    // Protocol starts with 'B' (begin), num axis, ... axis values (servo style), E (end) checksum
+    const QList<QString> list = str.split(",");
+    int index = 0;
+    int channelCount = 0;
+    int channelIndex = 0;
+    int checksum = 0;
+
+    for (int i=0; i<str.count(); i++)
+    {
+        if (str.at(i)=='E') break;
+        checksum += str.at(i).toLatin1();
+    }
+
+    for (auto &token : list)
+    {
+        switch (index)
+        {
+            case 0:
+            {
+                // First token 'B' for begin
+                if (token != "B")
+                {
+                    error = QString("Invalid string received 'B-missing' '%1'").arg(str);
+                    return false;
+                }
+            }
+            break;
+            case 1:
+            {
+                // Channel count
+                channelCount = token.toInt();
+                if (channelCount<1 || channelCount>16)
+                {
+                    error = QString("Invalid channel count '%1' received!").arg(token);
+                    return false;
+                }
+            }
+            break;
+            default:
+            {
+                if (channelCount>0)
+                {
+                    if (channelIndex<channelCount)
+                    {
+                        values[channelIndex++] = token.toInt();
+                    }
+                }
+            }
+        }
+
+        if (index==list.count()-2)
+        {
+            // 2nd to last token is 'E' (end)
+            if (token != "E")
+            {
+                error = QString("Invalid string received 'E-missing', '%1'").arg(str);
+                return false;
+            }
+        }
+
+        if (index==list.count()-1)
+        {
+            // Last token is checksum
+            int cs = token.toInt();
+            if (cs!=checksum)
+            {
+                error = QString("Checksum failed! '%1'").arg(str);
+                return false;
+            }
+        }
+
+        index++;
+    }
+
+    count = channelIndex;
+    return true;
+}
@@ -0,0 +1,22 @@
+#ifndef TEXTPROTOCOL_H
+#define TEXTPROTOCOL_H
+
+#include <QByteArray>
+#include <QString>
+
+// Text channel protocol sent by the clients, QDataStream serialized QStrings:
+// "B,n,v1,...,vn,E,checksum", checksum is the sum of the characters before 'E'.
+
+static const int TEXT_MAX_CHANNELS = 16;
+
+// Builds one message, the inverse of parseTextMessage()
+QString formatTextMessage(const int *values, int count);
+
+// Serialized the way clients send it, messages are concatenated as is
+QByteArray writeTextMessage(const QString &str);
+
+// Returns false and a description in error for an invalid message,
+// empty messages are ignored without an error
+bool parseTextMessage(const QString &str, int values[TEXT_MAX_CHANNELS], int &count, QString &error);
+
+#endif // TEXTPROTOCOL_H